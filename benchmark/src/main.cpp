@@ -0,0 +1,360 @@
+#include "tokenize.hpp"
+#include "token_array.hpp"
+#include "parser.hpp"
+#include "type_checker.hpp"
+#include "scan.hpp"
+#include "thread_pool.hpp"
+#include "compile_unit.hpp"
+#include "peephole_optimizer.hpp"
+#include "instruction_profile.hpp"
+#include "superinstruction_selector.hpp"
+#include "interpreter.hpp"
+#include "verifier.hpp"
+#include "ir_builder.hpp"
+#include "ir_optimizer.hpp"
+#include "ir_lowering.hpp"
+#include "register_machine.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+
+
+/* machine-generated style input: long identifiers, long literals and deep
+ * indentation */
+static std::string generate_source(std::size_t size) {
+	std::string source;
+	source.reserve(size + 128);
+	unsigned int index = 0;
+	while (source.size() < size) {
+		std::string name = "generated_variable_name_" + std::to_string(index);
+		source += "\t\t\t\tmut " + name + ": float = 1234567890.0987654321 * (";
+		source += name + " + 42424242424242) - 3141592653589793;\n\n";
+		++index;
+	}
+	return source;
+}
+
+/* a script that runs to the end: int and float variables updated from
+ * each other, the way numeric code reads */
+static std::string generate_program(std::size_t statements) {
+	std::string source;
+	for (std::size_t index = 0; index < statements; ++index) {
+		std::string i = "i" + std::to_string(index);
+		std::string f = "f" + std::to_string(index);
+		source += "mut " + i + ": int = " + std::to_string(index % 7 + 1) + "; mut " + f + ": float = 0.5;\n";
+		source += i + " = " + i + " + 3; " + f + " = " + f + " * 1.5 + " + i + ";\n";
+		source += i + " = " + i + " * 2 - " + i + " / 3; " + f + " = " + f + " + " + f + " / 4.0;\n";
+		source += "const c" + std::to_string(index) + ": float = " + f + " - " + i + " * 0.25;\n";
+	}
+	return source + "return f" + std::to_string(statements - 1) + ";\n";
+}
+
+/* the same statements with every one feeding the result, so none of
+ * them is dead code to the IR */
+static std::string generate_live_program(std::size_t statements) {
+	std::string source = "mut total: float = 0.0;\n";
+	for (std::size_t index = 0; index < statements; ++index) {
+		std::string i = "i" + std::to_string(index);
+		std::string f = "f" + std::to_string(index);
+		source += "mut " + i + ": int = total / 1000 + " + std::to_string(index % 7 + 1) + "; mut " + f + ": float = total * 0.5;\n";
+		source += i + " = " + i + " + 3; " + f + " = " + f + " * 1.5 + " + i + ";\n";
+		source += i + " = " + i + " * 2 - " + i + " / 3; " + f + " = " + f + " + " + f + " / 4.0;\n";
+		source += "total = total * 0.25 + " + f + " - " + i + " * 0.25;\n";
+	}
+	return source + "return total;\n";
+}
+
+static bool same_tokens(const token_array& lhs, const token_array& rhs) {
+	if (lhs.size() != rhs.size()) {
+		return false;
+	}
+	for (std::size_t index = 0; index < lhs.size(); ++index) {
+		token l = lhs[index];
+		token r = rhs[index];
+		if (l.str.data() != r.str.data() || l.str.size() != r.str.size() ||
+			l.type != r.type || l.offset != r.offset || l.sym != r.sym) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, const char** argv) {
+	std::size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 32;
+	int repeat = argc > 2 ? std::atoi(argv[2]) : 5;
+	std::string source = generate_source(megabytes << 20);
+
+	std::cout << "source: " << source.size() << " bytes, repeat: " << repeat << std::endl;
+
+	/* the runs skipped by the scalar loops, then by the vector ones. the
+	 * runs alternate so that both see the same state of the machine. the
+	 * cost is per token rather than per byte, so both are shown. */
+	token_array expected;
+	const scan_mode saved = get_scan_mode();
+	double lex_best[2] = { 0., 0. };
+	for (int count = 0; count < repeat; ++count) {
+		for (int vector = 0; vector < 2; ++vector) {
+			if (!set_scan_mode(vector ? scan_mode::sse2 : scan_mode::scalar)) {
+				continue;
+			}
+			std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+			token_array tokens = lexer::tokenize(source);
+			std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+			double seconds = std::chrono::duration<double>(end - begin).count();
+			if (source.size() / seconds > lex_best[vector]) {
+				lex_best[vector] = source.size() / seconds;
+			}
+			if (expected.size() == 0) {
+				expected = std::move(tokens);
+			} else if (!same_tokens(expected, tokens)) {
+				std::cout << "lex: the vector loops changed the tokens" << std::endl;
+				return 1;
+			}
+		}
+	}
+	set_scan_mode(saved);
+	for (int vector = 0; vector < 2; ++vector) {
+		if (lex_best[vector] == 0.) {
+			std::cout << (vector ? "lex vector: " : "lex scalar: ") << "not supported" << std::endl;
+			continue;
+		}
+		std::cout << (vector ? "lex vector: " : "lex scalar: ") << lex_best[vector] / (1 << 20) << " MB/s ("
+				<< expected.size() << " tokens, " << source.size() / lex_best[vector] / expected.size() * 1e9
+				<< " ns per token)" << std::endl;
+	}
+	double best = 0.;
+	std::cout << "token array: " << static_cast<double>(expected.memory_size()) / expected.size()
+			<< " bytes per token (token is " << sizeof(token) << ")" << std::endl;
+
+	/* the same text with every identifier spelled in kana */
+	std::string kana;
+	kana.reserve(source.size() * 2);
+	for (char c : source) {
+		if (c >= 'a' && c <= 'z') {
+			kana += "\xe3\x81";
+			kana += static_cast<char>(0x81 + (c - 'a'));
+		} else {
+			kana += c;
+		}
+	}
+	for (scan_mode mode : { scan_mode::scalar, scan_mode::sse2, scan_mode::avx2 }) {
+		if (!set_scan_mode(mode)) {
+			continue;
+		}
+		for (const std::string* text : { &source, &kana }) {
+			double best = 0.;
+			for (int count = 0; count < repeat; ++count) {
+				std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+				const char* end = get_scan_kernels().validate_utf8(text->data(), text->data() + text->size());
+				std::chrono::steady_clock::time_point finish = std::chrono::steady_clock::now();
+				if (end != text->data() + text->size()) {
+					std::cout << "validate_utf8: rejected well-formed input" << std::endl;
+					return 1;
+				}
+				double seconds = std::chrono::duration<double>(finish - begin).count();
+				if (text->size() / seconds > best) {
+					best = text->size() / seconds;
+				}
+			}
+			std::cout << "validate_utf8 " << to_string(mode) << (text == &source ? " ascii: " : " kana: ")
+					<< best / (1 << 20) << " MB/s" << std::endl;
+		}
+	}
+
+	best = 0.;
+	for (int count = 0; count < repeat; ++count) {
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		token_array tokens = lexer::tokenize_parallel(source);
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		double seconds = std::chrono::duration<double>(end - begin).count();
+		if (source.size() / seconds > best) {
+			best = source.size() / seconds;
+		}
+		if (!same_tokens(expected, tokens)) {
+			std::cout << "parallel: token stream differs from sequential" << std::endl;
+			return 1;
+		}
+	}
+	std::cout << "parallel (" << thread_pool::get_instance()->size() << " threads, "
+			<< to_string(get_scan_mode()) << "): " << best / (1 << 20) << " MB/s" << std::endl;
+
+	/* the tree is cleared and refilled every round, as compile_unit does */
+	syntax_tree tree;
+	best = 0.;
+	for (int count = 0; count < repeat; ++count) {
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		tree.clear();
+		parser::parse(expected, tree);
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		double seconds = std::chrono::duration<double>(end - begin).count();
+		if (source.size() / seconds > best) {
+			best = source.size() / seconds;
+		}
+	}
+	std::cout << "parse: " << best / (1 << 20) << " MB/s (" << tree.size() - 1 << " nodes, "
+			<< static_cast<double>(tree.memory_size()) / (tree.size() - 1) << " bytes per node)" << std::endl;
+
+	/* checking the same tree again resolves the same types */
+	best = 0.;
+	std::size_t type_errors = 0;
+	for (int count = 0; count < repeat; ++count) {
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		type_errors = type_checker::check(tree, tree.root()).size();
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		double seconds = std::chrono::duration<double>(end - begin).count();
+		if (source.size() / seconds > best) {
+			best = source.size() / seconds;
+		}
+	}
+	std::cout << "type check: " << best / (1 << 20) << " MB/s (" << type_errors << " errors)" << std::endl;
+
+	/* what the interpreter spends its dispatches on */
+	compile_unit program(generate_program(megabytes << 10));
+	const syntax_tree& program_tree = program.parse();
+	asm_context profiled;
+	program_tree.encode(program_tree.root(), profiled);
+	peephole_optimizer().run(profiled);
+	instruction_profile profile;
+	profile.execute(profiled);
+	std::cout << "profile: " << profile.executed() << " instructions executed" << std::endl;
+	for (std::size_t length : { 2, 3 }) {
+		for (const auto& [sequence, count] : profile.top(length, 8)) {
+			std::cout << "\t" << static_cast<double>(count) * 100 / profile.executed() << "% " << sequence << std::endl;
+		}
+	}
+
+	/* the same code with and without the superinstructions, run through
+	 * the instruct list and as bytecode. the rate is per instruction of
+	 * the unfused code, so the four are comparable */
+	double expected_result = std::get<double>(profiled.stack.back().value);
+	for (bool fuse : { false, true }) {
+		asm_context con;
+		program_tree.encode(program_tree.root(), con);
+		peephole_optimizer().run(con);
+		if (fuse) {
+			superinstruction_selector::select(con);
+		}
+		best = 0.;
+		OBJECT result;
+		for (int count = 0; count < repeat; ++count) {
+			con.stack.clear();
+			con.is_abort = false;
+			std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+			for (const std::unique_ptr<instruct>& inst : con.codes) {
+				inst->execute(con);
+				if (con.is_abort) {
+					break;
+				}
+			}
+			std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+			double seconds = std::chrono::duration<double>(end - begin).count();
+			if (best == 0. || seconds < best) {
+				best = seconds;
+			}
+			result = con.stack.back().value;
+		}
+		if (std::get<double>(result) != expected_result) {
+			std::cout << "execute: the instruct list changed the result" << std::endl;
+			return 1;
+		}
+		std::cout << (fuse ? "execute fused: " : "execute: ") << best * 1e9 / profile.executed() << " ns/op ("
+				<< con.codes.size() << " instructions)" << std::endl;
+
+		bytecode program = bytecode::compile(con);
+		interpreter runner(program);
+		best = 0.;
+		/* the first run is the one that quickens the code */
+		double first = 0.;
+		for (int count = 0; count < repeat; ++count) {
+			std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+			std::span<const value> stack = runner.run();
+			std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+			double seconds = std::chrono::duration<double>(end - begin).count();
+			if (count == 0) {
+				first = seconds;
+			}
+			if (best == 0. || seconds < best) {
+				best = seconds;
+			}
+			if (stack.empty() || stack.back().type != value::tag::floating || stack.back().floating != expected_result) {
+				std::cout << "execute: the bytecode changed the result" << std::endl;
+				return 1;
+			}
+		}
+		std::cout << (fuse ? "bytecode fused: " : "bytecode: ") << best * 1e9 / profile.executed() << " ns/op ("
+				<< program.size() << " bytes, " << runner.quickened() << " quickened, first run "
+				<< first * 1e9 / profile.executed() << " ns/op)" << std::endl;
+
+		/* the same code once the verifier has proven it, without checks */
+		std::chrono::steady_clock::time_point verify_begin = std::chrono::steady_clock::now();
+		if (std::optional<verifier::error> error = verifier::verify(program)) {
+			std::cout << "verify: " << error->message << " at " << error->offset << std::endl;
+			return 1;
+		}
+		double verify_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - verify_begin).count();
+		interpreter unchecked(program);
+		best = 0.;
+		for (int count = 0; count < repeat; ++count) {
+			std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+			std::span<const value> stack = unchecked.run();
+			std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+			double seconds = std::chrono::duration<double>(end - begin).count();
+			if (best == 0. || seconds < best) {
+				best = seconds;
+			}
+			if (stack.empty() || stack.back().type != value::tag::floating || stack.back().floating != expected_result) {
+				std::cout << "execute: the verified bytecode changed the result" << std::endl;
+				return 1;
+			}
+		}
+		std::cout << (fuse ? "verified fused: " : "verified: ") << best * 1e9 / profile.executed() << " ns/op (verify "
+				<< verify_seconds * 1e3 << " ms)" << std::endl;
+	}
+
+	/* both engines on the same SSA form, the way main compiles */
+	compile_unit live(generate_live_program(megabytes << 10));
+	const syntax_tree& live_tree = live.parse();
+	std::vector<ir_function> functions = ir_builder::build(live_tree, live_tree.root());
+	for (ir_function& function : functions) {
+		ir_optimizer::run(function);
+	}
+	asm_context lowered;
+	ir_lowering::lower(functions, lowered);
+	peephole_optimizer().run(lowered);
+	superinstruction_selector::select(lowered);
+	bytecode stack_program = bytecode::compile(lowered);
+	register_code register_program = register_code::compile(functions.front());
+	if (std::optional<verifier::error> error = verifier::verify(register_program)) {
+		std::cout << "verify: " << error->message << " at " << error->offset << std::endl;
+		return 1;
+	}
+	interpreter stack_engine(stack_program);
+	register_machine register_engine(register_program);
+	double stack_best = 0.;
+	double register_best = 0.;
+	for (int count = 0; count < repeat; ++count) {
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		std::span<const value> stack = stack_engine.run();
+		std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+		std::optional<value> returned = register_engine.run();
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		if (stack.empty() || !returned || stack.back().floating != returned->floating) {
+			std::cout << "engines: the register machine returned another value" << std::endl;
+			return 1;
+		}
+		double stack_seconds = std::chrono::duration<double>(middle - begin).count();
+		double register_seconds = std::chrono::duration<double>(end - middle).count();
+		if (stack_best == 0. || stack_seconds < stack_best) {
+			stack_best = stack_seconds;
+		}
+		if (register_best == 0. || register_seconds < register_best) {
+			register_best = register_seconds;
+		}
+	}
+	std::cout << "stack engine: " << stack_program.count() << " dispatches, " << stack_best * 1e3 << " ms" << std::endl;
+	std::cout << "register engine: " << register_program.instructions().size() << " dispatches, "
+			<< register_best * 1e3 << " ms" << std::endl;
+	return 0;
+}
@@ -2,10 +2,50 @@
 #include "tokenize.hpp"
 #include "parser.hpp"
 #include "asm.hpp"
+#include "compile_unit.hpp"
+#include "source_file.hpp"
+#include "document.hpp"
+#include "token_array.hpp"
+#include "token_stream.hpp"
+#include "scan.hpp"
+#include "constant_folder.hpp"
+#include "ir_builder.hpp"
+#include "ir_optimizer.hpp"
+#include "ir_lowering.hpp"
+#include "peephole_optimizer.hpp"
+#include "superinstruction_selector.hpp"
+#include "interpreter.hpp"
+#include "verifier.hpp"
+#include "register_machine.hpp"
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
+#include <limits>
+#include <map>
+#include <new>
+#include <optional>
+#include <random>
+#include <sstream>
 
 
+/* every allocation of the thread, counted for the tests that must not
+ * make any */
+static thread_local std::size_t allocations = 0;
+
+void* operator new(std::size_t size) {
+	++allocations;
+	if (void* memory = std::malloc(size ? size : 1)) {
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+void operator delete(void* memory, std::size_t) noexcept {
+	std::free(memory);
+}
+
 struct build_test_parameter {
 	std::string source;
 	std::string result;
@@ -16,30 +56,27 @@ void build_ast_test::get_tests(std::vector<test_parameter>& parameters) const {
 	namespace fs = std::filesystem;
 	std::string path = "../../functional_test/test";
 	for (const fs::directory_entry& entry : fs::directory_iterator(path + "/source")) {
-		std::string src_file = entry.path().string();
-		std::ifstream src_in(src_file);
-		std::string source((std::istreambuf_iterator<char>(src_in)), (std::istreambuf_iterator<char>()));
-		source.push_back('\0');
-
-		std::string res_file = path + "/parse/" + entry.path().filename().replace_extension("par").string();
-		std::ifstream res_in(res_file);
-		std::string result((std::istreambuf_iterator<char>(res_in)), (std::istreambuf_iterator<char>()));
+		source_file source(entry.path().string());
+		source_file result(path + "/parse/" + entry.path().filename().replace_extension("par").string());
 
 		parameters.push_back(test_parameter {
 			.test_name = entry.path().filename().string(),
-			.object = std::make_unique<build_test_parameter>(build_test_parameter { .source = source, .result = result})
+			.object = std::make_unique<build_test_parameter>(build_test_parameter {
+				.source = std::string(source.text()),
+				.result = std::string(result.text())
+			})
 		});
 	}
 }
 bool build_ast_test::run_test(const std::unique_ptr<void>& parameter) const {
 	build_test_parameter* param = static_cast<build_test_parameter*>(parameter.get());
 
-	std::vector<token> tokens = lexer::tokenize(std::move(param->source));
-	std::unique_ptr<ast_base_node> root = parser::parse(std::move(tokens));
-	if (!root) {
+	compile_unit unit(std::move(param->source));
+	const syntax_tree& tree = unit.parse();
+	if (tree.root() == no_node) {
 		return false;
 	}
-	std::string test_str = root->log("");
+	std::string test_str = tree.log(tree.root(), "");
 	if (param->result != test_str) {
 		return false;
 	}
@@ -47,6 +84,876 @@ bool build_ast_test::run_test(const std::unique_ptr<void>& parameter) const {
 	return true;
 }
 
+IMPLEMENT_FUNCTIONAL_TEST(build_ast_streaming)
+void build_ast_streaming_test::get_tests(std::vector<test_parameter>& parameters) const {
+	build_ast_test().get_tests(parameters);
+}
+bool build_ast_streaming_test::run_test(const std::unique_ptr<void>& parameter) const {
+	build_test_parameter* param = static_cast<build_test_parameter*>(parameter.get());
+
+	/* tiny chunks so that most lines straddle a read boundary */
+	std::istringstream in(param->source);
+	compile_unit unit(in, 3);
+	const syntax_tree& tree = unit.parse();
+	if (tree.root() == no_node) {
+		return false;
+	}
+	return param->result == tree.log(tree.root(), "");
+}
+
+IMPLEMENT_FUNCTIONAL_TEST(repeated_parse)
+void repeated_parse_test::get_tests(std::vector<test_parameter>& parameters) const {
+	build_ast_test().get_tests(parameters);
+}
+bool repeated_parse_test::run_test(const std::unique_ptr<void>& parameter) const {
+	build_test_parameter* param = static_cast<build_test_parameter*>(parameter.get());
+
+	/* a second parse, and tokenize after parse, lex the whole text again */
+	token_array expected = lexer::tokenize(param->source);
+	std::istringstream in(param->source);
+	compile_unit streamed(in, 3);
+	compile_unit whole(param->source);
+	for (compile_unit* unit : { &streamed, &whole }) {
+		for (int i = 0; i < 2; ++i) {
+			const syntax_tree& tree = unit->parse();
+			if (tree.root() == no_node || tree.log(tree.root(), "") != param->result) {
+				return false;
+			}
+		}
+		const token_array& tokens = unit->tokenize();
+		if (tokens.size() != expected.size()) {
+			return false;
+		}
+		for (std::size_t index = 0; index < tokens.size(); ++index) {
+			if (tokens.kind(index) != expected.kind(index) || tokens.offset(index) != expected.offset(index) ||
+				tokens[index].str != expected[index].str)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+struct lex_test_parameter {
+	std::string source;
+};
+
+static bool same_token(const token& lhs, const token& rhs) {
+	return lhs.str.data() == rhs.str.data() &&
+		lhs.str.size() == rhs.str.size() &&
+		lhs.type == rhs.type &&
+		lhs.offset == rhs.offset &&
+		lhs.sym == rhs.sym;
+}
+
+IMPLEMENT_FUNCTIONAL_TEST(parallel_lex)
+void parallel_lex_test::get_tests(std::vector<test_parameter>& parameters) const {
+	std::vector<test_parameter> sources;
+	build_ast_test().get_tests(sources);
+	for (test_parameter& param : sources) {
+		parameters.push_back(test_parameter {
+			.test_name = param.test_name,
+			.object = std::make_unique<lex_test_parameter>(lex_test_parameter {
+				.source = static_cast<build_test_parameter*>(param.object.get())->source
+			})
+		});
+	}
+
+	std::string generated;
+	for (int index = 0; index < 2000; ++index) {
+		generated += "mut v" + std::to_string(index) + ": float = " + std::to_string(index) + ".5 * (v + 1);";
+		generated += index % 3 ? "\n" : "\r\n\n\t";
+		if (index % 7 == 0) {
+			generated += "@ .x\n";
+		}
+	}
+	parameters.push_back(test_parameter {
+		.test_name = "generated lines",
+		.object = std::make_unique<lex_test_parameter>(lex_test_parameter { .source = generated })
+	});
+	std::string truncated = generated;
+	truncated[truncated.size() / 2] = '\0';
+	parameters.push_back(test_parameter {
+		.test_name = "stops at embedded nul",
+		.object = std::make_unique<lex_test_parameter>(lex_test_parameter { .source = truncated })
+	});
+	parameters.push_back(test_parameter {
+		.test_name = "single line",
+		.object = std::make_unique<lex_test_parameter>(lex_test_parameter { .source = std::string(4096, 'a') + " + 1;" })
+	});
+}
+bool parallel_lex_test::run_test(const std::unique_ptr<void>& parameter) const {
+	lex_test_parameter* param = static_cast<lex_test_parameter*>(parameter.get());
+
+	token_array expected = lexer::tokenize(param->source);
+	for (std::size_t min_chunk_size : { 1, 8, 64, 4096 }) {
+		token_array tokens = lexer::tokenize_parallel(param->source, min_chunk_size);
+		if (tokens.size() != expected.size()) {
+			return false;
+		}
+		for (std::size_t index = 0; index < tokens.size(); ++index) {
+			if (!same_token(tokens[index], expected[index])) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_FUNCTIONAL_TEST(token_stream_lookahead)
+void token_stream_lookahead_test::get_tests(std::vector<test_parameter>& parameters) const {
+	parallel_lex_test().get_tests(parameters);
+}
+bool token_stream_lookahead_test::run_test(const std::unique_ptr<void>& parameter) const {
+	lex_test_parameter* param = static_cast<lex_test_parameter*>(parameter.get());
+
+	/* every token is looked at before any is released, so the ring has to
+	 * grow well past its initial size */
+	token_array expected = lexer::tokenize(param->source);
+	lexer lex(param->source);
+	token_stream lexed(lex);
+	token_stream stored(expected);
+	for (token_stream* stream : { &lexed, &stored }) {
+		for (std::size_t index = 0; index < expected.size() + token_stream::lookahead; ++index) {
+			if (!same_token(stream->at(index), expected[std::min(index, expected.size() - 1)])) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_FUNCTIONAL_TEST(vector_skip)
+void vector_skip_test::get_tests(std::vector<test_parameter>& parameters) const {
+	parallel_lex_test().get_tests(parameters);
+	/* runs of every length around the 16-byte blocks, ended by each kind
+	 * of byte that stops them. the last run ends the source. */
+	struct run {
+		const char* name;
+		std::string_view bytes;
+	};
+	const run runs[] = {
+		{ "spaces", " \t\r\v\f" }, { "identifier bytes", "a_Z9z0A" }, { "digits", "0123456789" }
+	};
+	const char* const stops[] = { ";", "\n", ".5", "\xc3\xa9", "@", "x", " " };
+	for (const run& item : runs) {
+		for (const char* stop : stops) {
+			std::string source;
+			for (std::size_t length = 1; length <= 40; ++length) {
+				source += length % 2 ? "v " : "v\n";
+				for (std::size_t index = 0; index < length; ++index) {
+					source += item.bytes[index % item.bytes.size()];
+				}
+				if (length < 40) {
+					source += stop;
+				}
+			}
+			std::string name = std::string(item.name) + " before";
+			for (unsigned char c : std::string_view(stop)) {
+				name += " " + std::to_string(c);
+			}
+			parameters.push_back(test_parameter {
+				.test_name = name,
+				.object = std::make_unique<lex_test_parameter>(lex_test_parameter { .source = source })
+			});
+		}
+	}
+}
+bool vector_skip_test::run_test(const std::unique_ptr<void>& parameter) const {
+	lex_test_parameter* param = static_cast<lex_test_parameter*>(parameter.get());
+
+	scan_mode saved = get_scan_mode();
+	set_scan_mode(scan_mode::scalar);
+	token_array expected = lexer::tokenize(param->source);
+	bool result = true;
+	for (scan_mode mode : { scan_mode::sse2, scan_mode::avx2 }) {
+		if (!set_scan_mode(mode)) {
+			continue;
+		}
+		token_array tokens = lexer::tokenize(param->source);
+		if (tokens.size() != expected.size()) {
+			result = false;
+			continue;
+		}
+		for (std::size_t index = 0; index < tokens.size(); ++index) {
+			if (!same_token(tokens[index], expected[index])) {
+				result = false;
+			}
+		}
+	}
+	set_scan_mode(saved);
+	return result;
+}
+
+IMPLEMENT_FUNCTIONAL_TEST(intern_symbols)
+void intern_symbols_test::get_tests(std::vector<test_parameter>& parameters) const {
+	parallel_lex_test().get_tests(parameters);
+	std::string long_name(70000, 'x');
+	parameters.push_back(test_parameter {
+		.test_name = "names longer than a name block",
+		.object = std::make_unique<lex_test_parameter>(lex_test_parameter {
+			.source = long_name + " a " + long_name + "y b " + long_name + "\n"
+		})
+	});
+}
+bool intern_symbols_test::run_test(const std::unique_ptr<void>& parameter) const {
+	lex_test_parameter* param = static_cast<lex_test_parameter*>(parameter.get());
+
+	/* the chunks are interned concurrently */
+	token_array tokens = lexer::tokenize_parallel(param->source, 64);
+	std::map<std::string_view, symbol> seen;
+	for (std::size_t index = 0; index < tokens.size(); ++index) {
+		token tok = tokens[index];
+		if (tok.type != token_type::identifier) {
+			if (tok.sym != no_symbol) {
+				return false;
+			}
+			continue;
+		}
+		if (tok.sym == no_symbol || interner::get_instance()->name(tok.sym) != tok.str) {
+			return false;
+		}
+		auto [itr, inserted] = seen.insert({ tok.str, tok.sym });
+		if (itr->second != tok.sym) {
+			return false;
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_FUNCTIONAL_TEST(source_location)
+void source_location_test::get_tests(std::vector<test_parameter>& parameters) const {
+	parallel_lex_test().get_tests(parameters);
+
+	/* past the range of the 16-bit line and column that tokens used to carry */
+	std::string many_lines;
+	for (int index = 0; index < 70000; ++index) {
+		many_lines += "return " + std::to_string(index) + ";\n";
+	}
+	parameters.push_back(test_parameter {
+		.test_name = "many lines",
+		.object = std::make_unique<lex_test_parameter>(lex_test_parameter { .source = many_lines })
+	});
+	parameters.push_back(test_parameter {
+		.test_name = "columns in code points",
+		.object = std::make_unique<lex_test_parameter>(lex_test_parameter {
+			.source = "mut \u5909\u6570: int = 1;\n\u5909\u6570 = \u5909\u6570 + \U0001F600 2;\n"
+		})
+	});
+	parameters.push_back(test_parameter {
+		.test_name = "long line",
+		.object = std::make_unique<lex_test_parameter>(lex_test_parameter {
+			.source = "return 1;\n" + std::string(70000, ' ') + "return 2;\n"
+		})
+	});
+}
+bool source_location_test::run_test(const std::unique_ptr<void>& parameter) const {
+	lex_test_parameter* param = static_cast<lex_test_parameter*>(parameter.get());
+	std::string_view source = param->source;
+
+	compile_unit unit(param->source);
+	std::istringstream in(param->source);
+	compile_unit streamed(in, 7);
+	const token_array& tokens = unit.tokenize();
+	const token_array& streamed_tokens = streamed.tokenize();
+	if (tokens.size() != streamed_tokens.size()) {
+		return false;
+	}
+
+	/* walk the source once alongside the tokens */
+	source_location expected { .line = 0, .col = 0 };
+	std::size_t walked = 0;
+	for (std::size_t index = 0; index < tokens.size(); ++index) {
+		token tok = tokens[index];
+		if (tok.offset != streamed_tokens[index].offset ||
+			tok.str != streamed_tokens[index].str) {
+			return false;
+		}
+		if (tok.str != source.substr(tok.offset, tok.str.size())) {
+			return false;
+		}
+		for (; walked < tok.offset; ++walked) {
+			if (source[walked] == '\n') {
+				++expected.line;
+				expected.col = 0;
+			} else if ((static_cast<unsigned char>(source[walked]) & 0xc0) != 0x80) {
+				++expected.col;
+			}
+		}
+		source_location location = unit.locate(tok.offset);
+		source_location streamed_location = streamed.locate(tok.offset);
+		if (location.line != expected.line || location.col != expected.col ||
+			streamed_location.line != expected.line || streamed_location.col != expected.col) {
+			return false;
+		}
+	}
+	return true;
+}
+
+struct type_error_location_test_parameter {
+	std::string source;
+	/* where each type error's node starts, in the order they are reported */
+	std::vector<source_location> locations;
+};
+
+IMPLEMENT_FUNCTIONAL_TEST(type_error_location)
+void type_error_location_test::get_tests(std::vector<test_parameter>& parameters) const {
+	auto add = [&parameters](const char* name, std::string source, std::vector<source_location> locations) {
+		parameters.push_back(test_parameter {
+			.test_name = name,
+			.object = std::make_unique<type_error_location_test_parameter>(type_error_location_test_parameter {
+				.source = std::move(source),
+				.locations = std::move(locations)
+			})
+		});
+	};
+	add("variable on a later line", "mut a: int;\nreturn 1 +\n  a;", { { 2, 2 } });
+	add("two errors on one line", "mut a: int; mut b: int;\nreturn a + b;", { { 1, 7 }, { 1, 11 } });
+	add("column after a non-ASCII name", "mut \u5024: int;\nreturn 2 + \u5024 + \u5024;", { { 1, 11 }, { 1, 15 } });
+	add("name from inside a function", "fn f() -> const int { const b: int = 1; return b; }\nreturn b + 1;", { { 1, 7 } });
+}
+bool type_error_location_test::run_test(const std::unique_ptr<void>& parameter) const {
+	type_error_location_test_parameter* param = static_cast<type_error_location_test_parameter*>(parameter.get());
+
+	/* from a string, and streamed in chunks that split the lines */
+	compile_unit unit(param->source);
+	std::istringstream in(param->source);
+	compile_unit streamed(in, 5);
+	for (compile_unit* current : { &unit, &streamed }) {
+		current->parse();
+		const std::vector<type_checker::error>& errors = current->type_errors();
+		if (errors.size() != param->locations.size()) {
+			return false;
+		}
+		for (std::size_t index = 0; index < errors.size(); ++index) {
+			source_location location = current->locate(errors[index].offset);
+			if (location.line != param->locations[index].line || location.col != param->locations[index].col) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+struct source_limit_test_parameter {
+	std::size_t size;
+	std::size_t size_limit;
+	bool is_too_large;
+};
+
+IMPLEMENT_FUNCTIONAL_TEST(source_limit)
+void source_limit_test::get_tests(std::vector<test_parameter>& parameters) const {
+	auto add = [&parameters](const char* name, std::size_t size, std::size_t size_limit, bool is_too_large) {
+		parameters.push_back(test_parameter {
+			.test_name = name,
+			.object = std::make_unique<source_limit_test_parameter>(source_limit_test_parameter {
+				.size = size,
+				.size_limit = size_limit,
+				.is_too_large = is_too_large
+			})
+		});
+	};
+	/* a small limit stands in for max_size, so no file of 4 GiB is written.
+	 * a size of a whole page is read rather than mapped */
+	add("mapped file at the limit", 100, 100, false);
+	add("mapped file over the limit", 101, 100, true);
+	add("read file at the limit", 4096, 4096, false);
+	add("read file over the limit", 4096, 4095, true);
+}
+bool source_limit_test::run_test(const std::unique_ptr<void>& parameter) const {
+	namespace fs = std::filesystem;
+	source_limit_test_parameter* param = static_cast<source_limit_test_parameter*>(parameter.get());
+	fs::path path = fs::temp_directory_path() / "limescript_source_limit.ls";
+	{
+		std::ofstream create(path, std::ios::binary);
+		create << std::string(param->size, ' ');
+	}
+	bool result;
+	{
+		source_file file(path.string(), param->size_limit);
+		if (param->is_too_large) {
+			/* refused before a byte of it is read */
+			result = file.is_too_large() && !file.is_open();
+			compile_unit unit(std::move(file));
+			result = result && unit.is_too_large() && unit.parse().root() == no_node;
+		} else {
+			result = !file.is_too_large() && file.is_open() && file.text().size() == param->size;
+		}
+	}
+	fs::remove(path);
+	return result;
+}
+
+struct utf8_lex_test_parameter {
+	std::string source;
+	std::vector<std::pair<std::string, token_type>> expected;
+};
+
+IMPLEMENT_FUNCTIONAL_TEST(utf8_lex)
+void utf8_lex_test::get_tests(std::vector<test_parameter>& parameters) const {
+	auto add = [&parameters](const char* name, std::string source,
+		std::vector<std::pair<std::string, token_type>> expected) {
+		parameters.push_back(test_parameter {
+			.test_name = name,
+			.object = std::make_unique<utf8_lex_test_parameter>(utf8_lex_test_parameter {
+				.source = std::move(source),
+				.expected = std::move(expected)
+			})
+		});
+	};
+	add("non-ASCII identifier", "mut \u5909\u6570: int = 1;", {
+		{ "mut", token_type::_mut }, { "\u5909\u6570", token_type::identifier },
+		{ ":", token_type::colon }, { "int", token_type::_int }, { "=", token_type::equal },
+		{ "1", token_type::number }, { ";", token_type::semicolon }
+	});
+	add("mixed scripts", "r\u00e9sum\u00e9_2 + na\u00efve", {
+		{ "r\u00e9sum\u00e9_2", token_type::identifier }, { "+", token_type::plus },
+		{ "na\u00efve", token_type::identifier }
+	});
+	add("combining mark continues only", "a\u0301 \u0301a", {
+		{ "a\u0301", token_type::identifier }, { "\u0301", token_type::unknown },
+		{ "a", token_type::identifier }
+	});
+	add("symbol is not an identifier", "a\u2192b", {
+		{ "a", token_type::identifier }, { "\u2192", token_type::unknown },
+		{ "b", token_type::identifier }
+	});
+	add("four byte identifier", "\U00020000\U00020001 1", {
+		{ "\U00020000\U00020001", token_type::identifier }, { "1", token_type::number }
+	});
+	add("ill-formed bytes", "x\xff\xc3y \xe3\x81 z\xc3\xa9", {
+		{ "x", token_type::identifier }, { "\xff", token_type::unknown },
+		{ "\xc3", token_type::unknown }, { "y", token_type::identifier },
+		{ "\xe3", token_type::unknown }, { "\x81", token_type::unknown },
+		{ "z\xc3\xa9", token_type::identifier }
+	});
+	add("truncated at the end", "abc \xe3\x81", {
+		{ "abc", token_type::identifier }, { "\xe3", token_type::unknown },
+		{ "\x81", token_type::unknown }
+	});
+}
+bool utf8_lex_test::run_test(const std::unique_ptr<void>& parameter) const {
+	utf8_lex_test_parameter* param = static_cast<utf8_lex_test_parameter*>(parameter.get());
+
+	std::istringstream in(param->source);
+	compile_unit streamed(in, 3);
+	const token_array& streamed_tokens = streamed.tokenize();
+	token_array tokens = lexer::tokenize(param->source);
+	if (tokens.size() != param->expected.size() + 1 || streamed_tokens.size() != tokens.size()) {
+		return false;
+	}
+	for (std::size_t index = 0; index < param->expected.size(); ++index) {
+		if (tokens[index].str != param->expected[index].first ||
+			tokens[index].type != param->expected[index].second ||
+			streamed_tokens[index].str != tokens[index].str ||
+			streamed_tokens[index].offset != tokens[index].offset) {
+			return false;
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_FUNCTIONAL_TEST(token_kinds)
+void token_kinds_test::get_tests(std::vector<test_parameter>& parameters) const {
+	auto add = [&parameters](const char* name, std::string source,
+		std::vector<std::pair<std::string, token_type>> expected) {
+		parameters.push_back(test_parameter {
+			.test_name = name,
+			.object = std::make_unique<utf8_lex_test_parameter>(utf8_lex_test_parameter {
+				.source = std::move(source),
+				.expected = std::move(expected)
+			})
+		});
+	};
+	add("every punctuator", "+-*/();:=,->{}", {
+		{ "+", token_type::plus }, { "-", token_type::minus }, { "*", token_type::asterisk },
+		{ "/", token_type::slash }, { "(", token_type::l_paren }, { ")", token_type::r_paren },
+		{ ";", token_type::semicolon }, { ":", token_type::colon }, { "=", token_type::equal },
+		{ ",", token_type::comma }, { "->", token_type::arrow }, { "{", token_type::l_brace },
+		{ "}", token_type::r_brace }
+	});
+	add("minus before arrow", "a--->b", {
+		{ "a", token_type::identifier }, { "-", token_type::minus }, { "-", token_type::minus },
+		{ "->", token_type::arrow }, { "b", token_type::identifier }
+	});
+	add("literals keep their text", "x = 12 * .5 / 3.25 ? 0;", {
+		{ "x", token_type::identifier }, { "=", token_type::equal }, { "12", token_type::number },
+		{ "*", token_type::asterisk }, { ".5", token_type::floating }, { "/", token_type::slash },
+		{ "3.25", token_type::floating }, { "?", token_type::unknown }, { "0", token_type::number },
+		{ ";", token_type::semicolon }
+	});
+}
+bool token_kinds_test::run_test(const std::unique_ptr<void>& parameter) const {
+	utf8_lex_test_parameter* param = static_cast<utf8_lex_test_parameter*>(parameter.get());
+
+	/* the array has to give back exactly what the lexer produced */
+	token_array tokens = lexer::tokenize(param->source);
+	lexer lex(param->source);
+	if (tokens.size() != param->expected.size() + 1) {
+		return false;
+	}
+	for (std::size_t index = 0; index < tokens.size(); ++index) {
+		token tok = tokens[index];
+		if (!same_token(tok, lex.next()) || tokens.kind(index) != tok.type) {
+			return false;
+		}
+		if (index < param->expected.size() &&
+			(tok.str != param->expected[index].first || tok.type != param->expected[index].second)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+struct view_lex_test_parameter {
+	std::string source;
+	/* only this many bytes of the source are lexed */
+	std::size_t length;
+	std::vector<std::pair<std::string, token_type>> expected;
+};
+
+IMPLEMENT_FUNCTIONAL_TEST(view_lex)
+void view_lex_test::get_tests(std::vector<test_parameter>& parameters) const {
+	auto add = [&parameters](const char* name, std::string source, std::size_t length,
+		std::vector<std::pair<std::string, token_type>> expected) {
+		parameters.push_back(test_parameter {
+			.test_name = name,
+			.object = std::make_unique<view_lex_test_parameter>(view_lex_test_parameter {
+				.source = std::move(source),
+				.length = length,
+				.expected = std::move(expected)
+			})
+		});
+	};
+	add("sign cut before its second byte", "a->", 2, { { "a", token_type::identifier }, { "-", token_type::minus } });
+	add("number cut before its fraction", "1.5", 1, { { "1", token_type::number } });
+	add("number cut after its dot", "1.5", 2, { { "1.", token_type::floating } });
+	add("dot cut before its digits", ".5", 1, { { ".", token_type::unknown } });
+	add("identifier cut short", "abc", 2, { { "ab", token_type::identifier } });
+}
+bool view_lex_test::run_test(const std::unique_ptr<void>& parameter) const {
+	view_lex_test_parameter* param = static_cast<view_lex_test_parameter*>(parameter.get());
+
+	/* the view is not followed by a '\0', so the bytes after it must not
+	 * change what it lexes to */
+	token_array tokens = lexer::tokenize(std::string_view(param->source).substr(0, param->length));
+	if (tokens.size() != param->expected.size() + 1 || tokens.back().offset != param->length) {
+		return false;
+	}
+	for (std::size_t index = 0; index < param->expected.size(); ++index) {
+		if (tokens[index].str != param->expected[index].first || tokens[index].type != param->expected[index].second) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/* reference check written per code point, independent of the kernels */
+static std::size_t first_invalid_utf8(std::string_view str) {
+	std::size_t pos = 0;
+	while (pos < str.size()) {
+		unsigned char lead = static_cast<unsigned char>(str[pos]);
+		std::size_t length = lead < 0x80 ? 1 : lead >= 0xc0 && lead < 0xe0 ? 2 :
+			lead >= 0xe0 && lead < 0xf0 ? 3 : lead >= 0xf0 && lead < 0xf8 ? 4 : 0;
+		if (!length || pos + length > str.size()) {
+			return pos;
+		}
+		char32_t c = length == 1 ? lead : lead & (0x7f >> length);
+		for (std::size_t index = 1; index < length; ++index) {
+			unsigned char trail = static_cast<unsigned char>(str[pos + index]);
+			if ((trail & 0xc0) != 0x80) {
+				return pos;
+			}
+			c = (c << 6) | (trail & 0x3f);
+		}
+		static constexpr char32_t min_value[] = { 0, 0, 0x80, 0x800, 0x10000 };
+		if (c < min_value[length] || c > 0x10ffff || (c >= 0xd800 && c <= 0xdfff)) {
+			return pos;
+		}
+		pos += length;
+	}
+	return pos;
+}
+
+struct utf8_validate_test_parameter {
+	std::vector<std::string> sources;
+};
+
+IMPLEMENT_FUNCTIONAL_TEST(utf8_validate)
+void utf8_validate_test::get_tests(std::vector<test_parameter>& parameters) const {
+	const std::string samples[] = {
+		"abc", "\u00e9", "\u3042", "\U0001F600", "\U0010FFFF", "\uFFFD", "\u07FF", "\uD7FF", "\uE000"
+	};
+	const std::string broken[] = {
+		"\x80", "\xbf", "\xc0\xaf", "\xc1\xbf", "\xe0\x80\xaf", "\xe0\x9f\xbf",
+		"\xed\xa0\x80", "\xed\xbf\xbf", "\xf0\x80\x80\xaf", "\xf0\x8f\xbf\xbf",
+		"\xf4\x90\x80\x80", "\xf5\x80\x80\x80", "\xff", "\xfe", "\xc3", "\xe3\x81",
+		"\xf0\x9f\x98", "\xc3\xa9\xa9", "\xe3\x41\x81"
+	};
+	std::string text;
+	for (int index = 0; text.size() < 200; ++index) {
+		text += samples[(index * 7) % std::size(samples)];
+	}
+	parameters.push_back(test_parameter {
+		.test_name = "well-formed",
+		.object = std::make_unique<utf8_validate_test_parameter>(utf8_validate_test_parameter { .sources = { text } })
+	});
+	/* every ill-formed sequence at every position of the first two 32-byte
+	 * blocks, and right before the end at block boundaries */
+	for (const std::string& bad : broken) {
+		utf8_validate_test_parameter param;
+		for (std::size_t pos = 0; pos <= 70; ++pos) {
+			param.sources.push_back(std::string(pos, 'a') + bad + text);
+		}
+		for (std::size_t size : { 0, 1, 31, 32, 33, 63, 64, 65 }) {
+			param.sources.push_back(text.substr(0, size) + bad);
+		}
+		std::string name;
+		for (unsigned char c : bad) {
+			name += (name.empty() ? "" : " ") + std::to_string(c);
+		}
+		parameters.push_back(test_parameter {
+			.test_name = "ill-formed " + name,
+			.object = std::make_unique<utf8_validate_test_parameter>(std::move(param))
+		});
+	}
+}
+bool utf8_validate_test::run_test(const std::unique_ptr<void>& parameter) const {
+	utf8_validate_test_parameter* param = static_cast<utf8_validate_test_parameter*>(parameter.get());
+
+	scan_mode saved = get_scan_mode();
+	bool result = true;
+	for (scan_mode mode : { scan_mode::scalar, scan_mode::sse2, scan_mode::avx2 }) {
+		if (!set_scan_mode(mode)) {
+			continue;
+		}
+		for (std::string_view source : param->sources) {
+			/* also from every start inside the first few bytes */
+			for (std::size_t start = 0; start < 4 && start <= source.size(); ++start) {
+				std::string_view view = source.substr(start);
+				const char* found = get_scan_kernels().validate_utf8(view.data(), view.data() + view.size());
+				if (static_cast<std::size_t>(found - view.data()) != first_invalid_utf8(view)) {
+					result = false;
+				}
+			}
+		}
+	}
+	set_scan_mode(saved);
+	return result;
+}
+
+struct edit_test_parameter {
+	std::string source;
+	std::vector<document::edit> edits;
+	/* upper bound of re-parsed statements for the last edit */
+	std::size_t max_reparsed;
+};
+
+IMPLEMENT_FUNCTIONAL_TEST(incremental_edit)
+void incremental_edit_test::get_tests(std::vector<test_parameter>& parameters) const {
+	std::string source = "mut a: int = 1;\nconst b: float = 2.5;\na = a + 3;\nreturn a + b;\n";
+	parameters.push_back(test_parameter {
+		.test_name = "edit literal",
+		.object = std::make_unique<edit_test_parameter>(edit_test_parameter {
+			.source = source,
+			.edits = { { .offset = 13, .removed = 1, .inserted = "42" } },
+			.max_reparsed = 1
+		})
+	});
+	parameters.push_back(test_parameter {
+		.test_name = "join and split tokens",
+		.object = std::make_unique<edit_test_parameter>(edit_test_parameter {
+			.source = source,
+			.edits = {
+				{ .offset = 14, .removed = 2, .inserted = "" },
+				{ .offset = 14, .removed = 0, .inserted = ";\n" },
+				{ .offset = 0, .removed = 0, .inserted = "  " },
+				{ .offset = 63, .removed = 0, .inserted = " * 2" }
+			},
+			.max_reparsed = 2
+		})
+	});
+	parameters.push_back(test_parameter {
+		.test_name = "change definition",
+		.object = std::make_unique<edit_test_parameter>(edit_test_parameter {
+			.source = source,
+			.edits = { { .offset = 0, .removed = 3, .inserted = "const" } },
+			.max_reparsed = 3
+		})
+	});
+	parameters.push_back(test_parameter {
+		.test_name = "open and close function",
+		.object = std::make_unique<edit_test_parameter>(edit_test_parameter {
+			.source = "fn main(const argc: int) -> const int {\n\treturn 0;\n}\nreturn 1;\n",
+			.edits = {
+				{ .offset = 51, .removed = 1, .inserted = "" },
+				{ .offset = 51, .removed = 0, .inserted = "}" },
+				{ .offset = 0, .removed = 0, .inserted = "@" },
+				{ .offset = 0, .removed = 1, .inserted = "" }
+			},
+			.max_reparsed = 2
+		})
+	});
+
+	std::string large;
+	for (int index = 0; index < 500; ++index) {
+		large += "mut v" + std::to_string(index) + ": int = " + std::to_string(index) + ";\n";
+	}
+	std::size_t middle = large.find("v250: int = ") + 12;
+	parameters.push_back(test_parameter {
+		.test_name = "local edit in large file",
+		.object = std::make_unique<edit_test_parameter>(edit_test_parameter {
+			.source = large,
+			.edits = { { .offset = middle, .removed = 3, .inserted = "7 * 6" } },
+			.max_reparsed = 1
+		})
+	});
+	/* nothing else mentions v250, so no other statement is re-parsed */
+	parameters.push_back(test_parameter {
+		.test_name = "definition nothing mentions",
+		.object = std::make_unique<edit_test_parameter>(edit_test_parameter {
+			.source = large,
+			.edits = { { .offset = large.find("mut v250"), .removed = 3, .inserted = "const" } },
+			.max_reparsed = 1
+		})
+	});
+	parameters.push_back(test_parameter {
+		.test_name = "offsets after a growing edit",
+		.object = std::make_unique<edit_test_parameter>(edit_test_parameter {
+			.source = "const a: int = 1;\nconst b: int = 2;\n",
+			.edits = { { .offset = 15, .removed = 1, .inserted = "12345" } },
+			.max_reparsed = 1
+		})
+	});
+	/* the parser still defines a variable whose name is not an identifier */
+	parameters.push_back(test_parameter {
+		.test_name = "definition without a name",
+		.object = std::make_unique<edit_test_parameter>(edit_test_parameter {
+			.source = "const a: int = 4;\nreturn 1;\n",
+			.edits = { { .offset = 6, .removed = 1, .inserted = "(" } },
+			.max_reparsed = 1
+		})
+	});
+
+	/* random edits of pieces of the language, checked after each one
+	 * against the text lexed and parsed from scratch */
+	static constexpr std::string_view pieces[] = {
+		"", " ", "\n", ";", "a", "b1", "1", "2.5", ".", "=", "+", "*", "-", "->", "(", ")", "{", "}", ":",
+		"mut ", "const ", "int", "float", "return ", "fn f(const x: int) -> const int {", "mut a: int = 1;\n"
+	};
+	for (std::uint32_t seed : { 1u, 2u, 3u, 4u }) {
+		std::mt19937 random(seed);
+		std::string text = source;
+		std::vector<document::edit> edits;
+		for (int count = 0; count < 300; ++count) {
+			std::size_t offset = random() % (text.size() + 1);
+			std::size_t removed = std::min<std::size_t>(random() % 4, text.size() - offset);
+			std::string_view inserted = pieces[random() % std::size(pieces)];
+			edits.push_back(document::edit { .offset = offset, .removed = removed, .inserted = inserted });
+			text.replace(offset, removed, inserted);
+		}
+		parameters.push_back(test_parameter {
+			.test_name = "random edits, seed " + std::to_string(seed),
+			.object = std::make_unique<edit_test_parameter>(edit_test_parameter {
+				.source = source,
+				.edits = std::move(edits),
+				.max_reparsed = std::numeric_limits<std::size_t>::max()
+			})
+		});
+	}
+}
+bool incremental_edit_test::run_test(const std::unique_ptr<void>& parameter) const {
+	edit_test_parameter* param = static_cast<edit_test_parameter*>(parameter.get());
+
+	document doc(param->source);
+	std::string expected_text = param->source;
+	for (const document::edit& change : param->edits) {
+		doc.apply(change);
+		expected_text.replace(change.offset, change.removed, change.inserted);
+		if (doc.text() != expected_text) {
+			return false;
+		}
+		compile_unit unit(expected_text);
+		const syntax_tree& expected = unit.parse();
+		if (expected.root() == no_node || expected.log(expected.root(), "") != doc.log()) {
+			return false;
+		}
+		token_array tokens = doc.tokens();
+		token_array lexed = lexer::tokenize(expected_text);
+		if (tokens.size() != lexed.size()) {
+			return false;
+		}
+		for (std::size_t index = 0; index < lexed.size(); ++index) {
+			if (tokens[index].type != lexed[index].type || tokens[index].offset != lexed[index].offset ||
+				tokens[index].str != lexed[index].str)
+			{
+				return false;
+			}
+		}
+	}
+	return doc.last_stats().reparsed_statements <= param->max_reparsed;
+}
+
+struct type_check_test_parameter {
+	std::string source;
+	/* type of the last statement's expression and the casts of its operands */
+	object_type type;
+	object_type lhs_cast;
+	object_type rhs_cast;
+	std::size_t errors;
+};
+
+IMPLEMENT_FUNCTIONAL_TEST(type_check)
+void type_check_test::get_tests(std::vector<test_parameter>& parameters) const {
+	auto add = [&parameters](const char* name, std::string source, object_type type,
+		object_type lhs_cast, object_type rhs_cast, std::size_t errors) {
+		parameters.push_back(test_parameter {
+			.test_name = name,
+			.object = std::make_unique<type_check_test_parameter>(type_check_test_parameter {
+				.source = std::move(source),
+				.type = type,
+				.lhs_cast = lhs_cast,
+				.rhs_cast = rhs_cast,
+				.errors = errors
+			})
+		});
+	};
+	add("same types need no cast", "return 1 + 2;",
+		object_type::integer, object_type::none, object_type::none, 0);
+	add("integer lhs is widened", "return 1 + 2.5;",
+		object_type::floating, object_type::floating, object_type::none, 0);
+	add("integer rhs is widened", "return 2.5 * 2;",
+		object_type::floating, object_type::none, object_type::floating, 0);
+	add("assignment of a wider value", "mut a: int = 0; a = 1.5;",
+		object_type::floating, object_type::floating, object_type::none, 0);
+	add("parse errors are not reported again", "return x + 1;",
+		object_type::none, object_type::none, object_type::none, 0);
+	add("arguments are in scope of the body", "fn f(const a: int) -> const int { return a; } return 1 + 2;",
+		object_type::integer, object_type::none, object_type::none, 0);
+	add("a function's variables stay in it", "fn f() -> const int { const b: int = 1; return b; } return b + 1;",
+		object_type::integer, object_type::none, object_type::none, 1);
+	add("read before initialization", "mut a: int; return a + 1;",
+		object_type::integer, object_type::none, object_type::none, 1);
+	add("assignment initializes", "mut a: int; a = 2; return a + 1;",
+		object_type::integer, object_type::none, object_type::none, 0);
+}
+bool type_check_test::run_test(const std::unique_ptr<void>& parameter) const {
+	type_check_test_parameter* param = static_cast<type_check_test_parameter*>(parameter.get());
+	compile_unit unit(std::move(param->source));
+	const syntax_tree& tree = unit.parse();
+	if (tree.root() == no_node || tree.list(tree.root()).empty()) {
+		return false;
+	}
+	if (unit.type_errors().size() != param->errors) {
+		return false;
+	}
+	const ast_node& statement = tree[tree.list(tree.root()).back()];
+	const ast_node& expr = tree[statement.lhs];
+	return expr.kind == ast_kind::bin_op && expr.type == param->type &&
+		tree[expr.lhs].cast == param->lhs_cast && tree[expr.rhs].cast == param->rhs_cast;
+}
+
 struct return_test_parameter {
 	return_test_parameter() = default;
 	return_test_parameter(OBJECT ret, const std::string& source) :
@@ -91,16 +998,65 @@ void runtime_execute_test::get_tests(std::vector<test_parameter>& parameters) co
 			.object = std::make_unique<return_test_parameter>(OBJECT(3.14), "const v: float = 2.14; return 1 + v;")
 		}
 	);
+	parameters.push_back(
+		test_parameter {
+			.test_name = "return value of non-ASCII variable",
+			.object = std::make_unique<return_test_parameter>(OBJECT(3), "const \u5024: int = 2; return \u5024 + 1;")
+		}
+	);
+	parameters.push_back(
+		test_parameter {
+			.test_name = "assign to a variable",
+			.object = std::make_unique<return_test_parameter>(OBJECT(3), "mut v: int = 1; v = v + 2.5; return v;")
+		}
+	);
+	parameters.push_back(
+		test_parameter {
+			.test_name = "int sum wraps around",
+			.object = std::make_unique<return_test_parameter>(OBJECT(std::numeric_limits<int>::min()), "return 2147483647 + 1;")
+		}
+	);
+	parameters.push_back(
+		test_parameter {
+			.test_name = "int difference of a variable wraps around",
+			.object = std::make_unique<return_test_parameter>(OBJECT(2147483647), "mut v: int = 0 - 2147483647; return v - 2;")
+		}
+	);
+	parameters.push_back(
+		test_parameter {
+			.test_name = "int product of variables wraps around",
+			.object = std::make_unique<return_test_parameter>(OBJECT(0), "mut v: int = 65536; return v * v;")
+		}
+	);
 }
-bool runtime_execute_test::run_test(const std::unique_ptr<void>& parameter) const {
-	return_test_parameter* param = static_cast<return_test_parameter*>(parameter.get());
-	std::vector<token> tokens = lexer::tokenize(param->source);
-	std::unique_ptr<ast_base_node> root = parser::parse(std::move(tokens));
-	if (!root) {
-		return false;
+/* the tree through SSA form, optimized and lowered back to instructions */
+static std::vector<ir_function> build_optimized(const syntax_tree& tree) {
+	std::vector<ir_function> functions = ir_builder::build(tree, tree.root());
+	for (ir_function& function : functions) {
+		ir_optimizer::run(function);
+	}
+	return functions;
+}
+static void lower_optimized(const syntax_tree& tree, asm_context& con) {
+	ir_lowering::lower(build_optimized(tree), con);
+}
+/* runs the global code, both as bytecode and instruction by instruction,
+ * and compares the one value left on the stack */
+static bool returns(asm_context& con, const OBJECT& expected) {
+	/* once checked, and once unchecked after the verifier accepts it, as
+	 * it must for everything the encoder emits */
+	bytecode program = bytecode::compile(con);
+	for (bool verify : { false, true }) {
+		if (verify && verifier::verify(program)) {
+			return false;
+		}
+		std::vector<OBJECT> stack = interpreter::evaluate(program);
+		if (stack.size() != 1 || stack.back().index() != expected.index() ||
+			std::visit(cmp_not_equal{}, stack.back(), expected))
+		{
+			return false;
+		}
 	}
-	asm_context con;
-	root->encode(con);
 	for (const std::unique_ptr<instruct>& inst : con.codes) {
 		inst->execute(con);
 		if (con.is_abort) {
@@ -111,12 +1067,963 @@ bool runtime_execute_test::run_test(const std::unique_ptr<void>& parameter) cons
 	if (con.stack.size() != 1) {
 		return false;
 	}
-	if (con.stack.back().value.index() != param->return_value.index()) {
+	if (con.stack.back().value.index() != expected.index()) {
 		return false;
 	}
 
-	if (std::visit(cmp_not_equal{}, con.stack.back().value, param->return_value)) {
+	if (std::visit(cmp_not_equal{}, con.stack.back().value, expected)) {
 		return false;
 	}
 	return true;
 }
+/* the same for the encoded tree */
+static bool returns(const syntax_tree& tree, const OBJECT& expected, bool optimized = false) {
+	asm_context con;
+	if (optimized) {
+		/* the register engine compiles from the same SSA form */
+		register_code code = register_code::compile(build_optimized(tree).front());
+		if (verifier::verify(code)) {
+			return false;
+		}
+		std::vector<OBJECT> registers = register_machine::evaluate(code);
+		if (registers.size() != 1 || registers.back().index() != expected.index() ||
+			std::visit(cmp_not_equal{}, registers.back(), expected))
+		{
+			return false;
+		}
+		lower_optimized(tree, con);
+	} else {
+		tree.encode(tree.root(), con);
+	}
+	return returns(con, expected);
+}
+bool runtime_execute_test::run_test(const std::unique_ptr<void>& parameter) const {
+	return_test_parameter* param = static_cast<return_test_parameter*>(parameter.get());
+	compile_unit unit(param->source);
+	const syntax_tree& tree = unit.parse();
+	if (tree.root() == no_node) {
+		return false;
+	}
+	/* neither folding nor the IR passes may change what the code computes */
+	return returns(tree, param->return_value) && returns(tree, param->return_value, true) &&
+		returns(unit.fold_constants(), param->return_value);
+}
+
+struct deep_nesting_test_parameter {
+	std::string source;
+	OBJECT return_value;
+};
+
+IMPLEMENT_FUNCTIONAL_TEST(deep_nesting)
+void deep_nesting_test::get_tests(std::vector<test_parameter>& parameters) const {
+	/* far beyond what one native frame per level would survive */
+	constexpr int depth = 200000;
+	auto add = [&parameters](const char* name, std::string source, OBJECT ret) {
+		parameters.push_back(test_parameter {
+			.test_name = name,
+			.object = std::make_unique<deep_nesting_test_parameter>(deep_nesting_test_parameter {
+				.source = std::move(source),
+				.return_value = ret
+			})
+		});
+	};
+	auto parentheses = [](int count) {
+		return "return " + std::string(count, '(') + "1" + std::string(count, ')') + ";";
+	};
+	auto functions = [](int count) {
+		std::string source;
+		for (int index = 0; index < count; ++index) {
+			source += "fn f() -> const int {";
+		}
+		return source + std::string(count, '}') + "return 2;";
+	};
+
+	std::string chain = "return 1";
+	for (int count = 1; count < depth; ++count) {
+		chain += " + 1";
+	}
+	add("long operator chain", chain + ";", OBJECT(depth));
+	add("deep parentheses", parentheses(depth), OBJECT(1));
+	add("deeply nested functions", functions(depth / 10), OBJECT(2));
+}
+bool deep_nesting_test::run_test(const std::unique_ptr<void>& parameter) const {
+	deep_nesting_test_parameter* param = static_cast<deep_nesting_test_parameter*>(parameter.get());
+	std::size_t source_size = param->source.size();
+	compile_unit unit(std::move(param->source));
+	const syntax_tree& tree = unit.parse();
+	if (tree.root() == no_node || tree[tree.root()].kind != ast_kind::block) {
+		return false;
+	}
+	/* the log is printed whole, so it has to grow with the source and not
+	 * with the source times its depth */
+	std::string log = tree.log(tree.root(), "");
+	if (!log.ends_with("</block>\n") || log.size() > source_size * 2 * (syntax_tree::max_log_indent + 64)) {
+		return false;
+	}
+	/* neither folding nor the IR passes may change what the code computes */
+	return returns(tree, param->return_value) && returns(tree, param->return_value, true) &&
+		returns(unit.fold_constants(), param->return_value);
+}
+
+/* the instructions as logged, one line each */
+static std::vector<std::string> listing(const std::list<std::unique_ptr<instruct>>& codes) {
+	std::vector<std::string> lines;
+	for (const std::unique_ptr<instruct>& inst : codes) {
+		std::string line = inst->log("");
+		while (!line.empty() && line.back() == '\n') {
+			line.pop_back();
+		}
+		lines.push_back(std::move(line));
+	}
+	return lines;
+}
+
+struct constant_folding_test_parameter {
+	std::string source;
+	std::vector<std::string> listing;
+};
+
+IMPLEMENT_FUNCTIONAL_TEST(constant_folding)
+void constant_folding_test::get_tests(std::vector<test_parameter>& parameters) const {
+	auto add = [&parameters](const char* name, std::string source, std::vector<std::string> listing) {
+		parameters.push_back(test_parameter {
+			.test_name = name,
+			.object = std::make_unique<constant_folding_test_parameter>(constant_folding_test_parameter {
+				.source = std::move(source),
+				.listing = std::move(listing)
+			})
+		});
+	};
+	add("literal operation", "return 1 + 2;", { "push 3", "return" });
+	add("precedence and parentheses", "return (1 + 2) * 3 - 4 / 2;", { "push 7", "return" });
+	add("integer promoted to float", "return 1 + 2.5;", { "push 3.500000", "return" });
+	add("integer division before promotion", "return 7 / 2 * 2.0;", { "push 6.000000", "return" });
+	add("cast to the variable's type", "const v: int = 2.5 * 3; return v;",
+		{ "alloc int const as v", "push 7", "init v", "push 7", "return" });
+	add("const variable propagated", "const v: int = 1; return v + 2;",
+		{ "alloc int const as v", "push 1", "init v", "push 3", "return" });
+	add("const variable promoted where used", "const v: int = 1; return v + 0.5;",
+		{ "alloc int const as v", "push 1", "init v", "push 1.500000", "return" });
+	add("mutable variable is not a constant", "mut v: int = 1; return v + 2;",
+		{ "alloc int mut as v", "push 1", "init v", "push v", "push 2", "add", "return" });
+	add("integer division by zero is left to run", "return 1 / 0;",
+		{ "push 1", "push 0", "div", "return" });
+	add("overflow is left to run", "return 2147483647 + 1;",
+		{ "push 2147483647", "push 1", "add", "return" });
+	add("product that overflows is left to run", "return 65536 * 65536;",
+		{ "push 65536", "push 65536", "mul", "return" });
+	add("product that fits is folded", "return 65535 * 32768;", { "push 2147450880", "return" });
+}
+bool constant_folding_test::run_test(const std::unique_ptr<void>& parameter) const {
+	constant_folding_test_parameter* param = static_cast<constant_folding_test_parameter*>(parameter.get());
+	compile_unit unit(std::move(param->source));
+	unit.parse();
+	const syntax_tree& tree = unit.fold_constants();
+	if (tree.root() == no_node || !unit.type_errors().empty()) {
+		return false;
+	}
+	asm_context con;
+	tree.encode(tree.root(), con);
+	return listing(con.codes) == param->listing;
+}
+
+struct ir_optimization_test_parameter {
+	std::string source;
+	std::vector<std::string> listing;
+	OBJECT return_value;
+};
+
+IMPLEMENT_FUNCTIONAL_TEST(ir_optimization)
+void ir_optimization_test::get_tests(std::vector<test_parameter>& parameters) const {
+	auto add = [&parameters](const char* name, std::string source, std::vector<std::string> listing, OBJECT ret) {
+		parameters.push_back(test_parameter {
+			.test_name = name,
+			.object = std::make_unique<ir_optimization_test_parameter>(ir_optimization_test_parameter {
+				.source = std::move(source),
+				.listing = std::move(listing),
+				.return_value = ret
+			})
+		});
+	};
+	add("code after return is dropped", "return 1; return 2 + 3;", { "push 1", "return" }, OBJECT(1));
+	add("unused variable has no alloc", "const unused: float = 1.5; return 2;", { "push 2", "return" }, OBJECT(2));
+	add("copies are propagated", "mut a: int = 4; mut b: int = a; b = b + a; return b;",
+		{ "push 4", "push 4", "add", "return" }, OBJECT(8));
+	add("assignment converts to the variable's type", "mut v: int = 1; v = v + 2.5; return v;",
+		{ "push 1", "cast double", "push 2.500000", "addf", "cast int", "return" }, OBJECT(3));
+	add("common subexpression is computed once", "mut x: int = 2; const y: int = x * 3; return y + x * 3;",
+		{ "alloc int const as y", "push 2", "push 3", "mul", "init y", "push y", "push y", "add", "return" },
+		OBJECT(12));
+	add("shared temporary is listed by its slot", "mut x: int = 2; return (x + 1) * (x + 1);",
+		{ "alloc int const as $0", "push 2", "push 1", "add", "init $0", "push $0", "push $0", "mul", "return" },
+		OBJECT(9));
+	add("assignment of an unknown name poisons the variable", "mut a: int = 1; a = x; return a;",
+		{ "abort" }, OBJECT());
+}
+bool ir_optimization_test::run_test(const std::unique_ptr<void>& parameter) const {
+	ir_optimization_test_parameter* param = static_cast<ir_optimization_test_parameter*>(parameter.get());
+	compile_unit unit(std::move(param->source));
+	const syntax_tree& tree = unit.parse();
+	if (tree.root() == no_node || !unit.type_errors().empty()) {
+		return false;
+	}
+	/* lowering names nothing the source did not */
+	std::size_t symbols = interner::get_instance()->size();
+	asm_context con;
+	lower_optimized(tree, con);
+	if (interner::get_instance()->size() != symbols || listing(con.codes) != param->listing) {
+		return false;
+	}
+	if (param->return_value.index() == INVALID_TYPE_INDEX) {
+		/* both engines stop where the direct encoder would */
+		register_code code = register_code::compile(build_optimized(tree).front());
+		bytecode program = bytecode::compile(con);
+		return !verifier::verify(code) && register_machine::evaluate(code).empty() &&
+			!verifier::verify(program) && interpreter(program).run().empty();
+	}
+	return returns(tree, param->return_value, true);
+}
+
+struct peephole_test_parameter {
+	std::string source;
+	std::vector<std::string> listing;
+	/* instructions removed by each rule, in rule order */
+	std::array<std::size_t, peephole_optimizer::rule_count> removed;
+	OBJECT return_value;
+};
+
+IMPLEMENT_FUNCTIONAL_TEST(peephole)
+void peephole_test::get_tests(std::vector<test_parameter>& parameters) const {
+	auto add = [&parameters](const char* name, std::string source, std::vector<std::string> listing,
+		std::array<std::size_t, peephole_optimizer::rule_count> removed, OBJECT ret)
+	{
+		parameters.push_back(test_parameter {
+			.test_name = name,
+			.object = std::make_unique<peephole_test_parameter>(peephole_test_parameter {
+				.source = std::move(source),
+				.listing = std::move(listing),
+				.removed = removed,
+				.return_value = ret
+			})
+		});
+	};
+	add("unused expression statement", "1 + 2; return 3;", { "push 3", "return" }, { 4, 0, 0, 0 }, OBJECT(3));
+	add("value left by an assignment", "mut x: int = 1; x = 2; return x;",
+		{ "alloc int mut as x", "push 2", "mov x", "push x", "return" }, { 2, 0, 0, 2 }, OBJECT(2));
+	add("overwritten computed store", "mut x: int = 1; x = x + 1; x = 5; return x;",
+		{ "alloc int mut as x", "push 5", "mov x", "push x", "return" }, { 8, 0, 0, 2 }, OBJECT(5));
+	add("cast of a literal", "return 1 + 2.5;", { "push 1.000000", "push 2.500000", "addf", "return" },
+		{ 0, 0, 1, 0 }, OBJECT(3.5));
+	add("cast of a float literal", "const v: int = 2.5; return v;",
+		{ "alloc int const as v", "push 2", "init v", "push v", "return" }, { 0, 0, 1, 0 }, OBJECT(2));
+	add("cast of a variable to its type", "mut v: float = 1.5; v = v + 1; return v;",
+		{ "alloc float mut as v", "push 1.500000", "init v", "push v", "push 1.000000", "addf", "movf v",
+			"push v", "return" },
+		{ 2, 0, 1, 0 }, OBJECT(2.5));
+}
+bool peephole_test::run_test(const std::unique_ptr<void>& parameter) const {
+	peephole_test_parameter* param = static_cast<peephole_test_parameter*>(parameter.get());
+	compile_unit unit(std::move(param->source));
+	const syntax_tree& tree = unit.parse();
+	if (tree.root() == no_node || !unit.type_errors().empty()) {
+		return false;
+	}
+	asm_context con;
+	tree.encode(tree.root(), con);
+	peephole_optimizer::report removed = peephole_optimizer().run(con);
+	if (listing(con.codes) != param->listing || removed.removed != param->removed) {
+		return false;
+	}
+	return returns(con, param->return_value);
+}
+
+IMPLEMENT_FUNCTIONAL_TEST(peephole_identity_cast)
+void peephole_identity_cast_test::get_tests(std::vector<test_parameter>& parameters) const {
+	parameters.push_back(test_parameter { .test_name = "cast of a computed value to its type", .object = nullptr });
+}
+bool peephole_identity_cast_test::run_test(const std::unique_ptr<void>&) const {
+	/* the encoder only casts where the types differ, so the input is built
+	 * by hand */
+	std::list<std::unique_ptr<instruct>> codes;
+	auto push = [&codes](OBJECT value) {
+		std::unique_ptr<push_instruct> inst = std::make_unique<push_instruct>();
+		inst->value = operand { .type = operand_type::immidiate, .value = value };
+		codes.push_back(std::move(inst));
+	};
+	push(OBJECT(1));
+	push(OBJECT(2));
+	codes.push_back(std::make_unique<add_instruct>());
+	codes.push_back(std::make_unique<cast_instruct>(object_type::integer));
+	codes.push_back(std::make_unique<return_instruct>());
+
+	peephole_optimizer optimizer;
+	optimizer.enable(peephole_optimizer::rule::identity_cast, false);
+	if (optimizer.run(codes).total() != 0) {
+		return false;
+	}
+	optimizer.enable(peephole_optimizer::rule::identity_cast, true);
+	peephole_optimizer::report removed = optimizer.run(codes);
+	return removed.removed[static_cast<std::size_t>(peephole_optimizer::rule::identity_cast)] == 1 &&
+		listing(codes) == std::vector<std::string> { "push 1", "push 2", "add", "return" };
+}
+
+struct superinstruction_test_parameter {
+	std::string source;
+	std::vector<std::string> listing;
+	std::size_t fused;
+	/* no value when the verified bytecode aborts */
+	OBJECT return_value;
+};
+
+IMPLEMENT_FUNCTIONAL_TEST(superinstruction)
+void superinstruction_test::get_tests(std::vector<test_parameter>& parameters) const {
+	auto add = [&parameters](const char* name, std::string source, std::vector<std::string> listing,
+		std::size_t fused, OBJECT ret)
+	{
+		parameters.push_back(test_parameter {
+			.test_name = name,
+			.object = std::make_unique<superinstruction_test_parameter>(superinstruction_test_parameter {
+				.source = std::move(source),
+				.listing = std::move(listing),
+				.fused = fused,
+				.return_value = ret
+			})
+		});
+	};
+	add("variable initialized with a literal", "const v: int = 3; return v;",
+		{ "init_from_imm int const v, 3", "push v", "return" }, 1, OBJECT(3));
+	add("operation on a variable and a literal", "mut x: int = 4; return x / 3;",
+		{ "init_from_imm int mut x, 4", "div_var_imm x, 3", "return" }, 2, OBJECT(1));
+	add("operation on two variables", "mut x: float = 1.5; mut y: float = 2.0; return x * y;",
+		{ "init_from_imm float mut x, 1.500000", "init_from_imm float mut y, 2.000000", "mulf_var_var x, y",
+			"return" },
+		3, OBJECT(3.0));
+	add("variable cast to float", "mut i: int = 2; return 0.5 + i;",
+		{ "init_from_imm int mut i, 2", "push 0.500000", "push_var_cast_f i", "addf", "return" }, 2, OBJECT(2.5));
+	add("assignment from the variable itself", "mut x: int = 1; x = x - 3; return x;",
+		{ "init_from_imm int mut x, 1", "sub_var_imm x, 3", "mov x", "push x", "return" }, 2, OBJECT(-2));
+	add("sum of a variable that wraps around", "mut x: int = 2147483647; return x + 1;",
+		{ "init_from_imm int mut x, 2147483647", "add_var_imm x, 1", "return" }, 2, OBJECT(std::numeric_limits<int>::min()));
+	add("division by a literal that can fail", "mut x: int = 4; return x / 0;",
+		{ "init_from_imm int mut x, 4", "push x", "push 0", "div", "return" }, 1, OBJECT());
+}
+bool superinstruction_test::run_test(const std::unique_ptr<void>& parameter) const {
+	superinstruction_test_parameter* param = static_cast<superinstruction_test_parameter*>(parameter.get());
+	compile_unit unit(std::move(param->source));
+	const syntax_tree& tree = unit.parse();
+	if (tree.root() == no_node || !unit.type_errors().empty()) {
+		return false;
+	}
+	asm_context con;
+	tree.encode(tree.root(), con);
+	peephole_optimizer().run(con);
+	if (superinstruction_selector::select(con) != param->fused || listing(con.codes) != param->listing) {
+		return false;
+	}
+	if (param->return_value.index() == INVALID_TYPE_INDEX) {
+		bytecode program = bytecode::compile(con);
+		return !verifier::verify(program) && interpreter(program).run().empty();
+	}
+	return returns(con, param->return_value);
+}
+
+struct bytecode_test_parameter {
+	std::string source;
+	/* run through the peephole pass and the superinstructions first */
+	bool optimize;
+	std::vector<std::string> disassembly;
+	OBJECT return_value;
+};
+
+IMPLEMENT_FUNCTIONAL_TEST(bytecode)
+void bytecode_test::get_tests(std::vector<test_parameter>& parameters) const {
+	auto add = [&parameters](const char* name, std::string source, bool optimize,
+		std::vector<std::string> disassembly, OBJECT ret)
+	{
+		parameters.push_back(test_parameter {
+			.test_name = name,
+			.object = std::make_unique<bytecode_test_parameter>(bytecode_test_parameter {
+				.source = std::move(source),
+				.optimize = optimize,
+				.disassembly = std::move(disassembly),
+				.return_value = ret
+			})
+		});
+	};
+	add("operands inline", "return 1 + 2.5;", false,
+		{ "0: push_int 1", "5: cast_float", "6: push_float 2.500000", "15: addf", "16: ret", "17: ret" }, OBJECT(3.5));
+	add("variables in frame slots", "mut v: int = 1; v = v * 3; return v;", false,
+		{ "0: alloc_int $0", "5: push_int 1", "10: init $0", "15: push_var $0", "20: push_int 3", "25: mul",
+			"26: store $0", "31: push_var $0", "36: pop", "37: push_var $0", "42: ret", "43: ret" },
+		OBJECT(3));
+	add("assignment before any read", "mut a: int; a = 1; return a;", false,
+		{ "0: alloc_int $0", "5: push_int 1", "10: store $0", "15: push_var $0", "20: pop", "21: push_var $0",
+			"26: ret", "27: ret" },
+		OBJECT(1));
+	add("superinstructions", "mut x: int = 4; return x / 3;", true,
+		{ "0: store_int $0, 4", "9: div_var_imm $0, 3", "18: ret", "19: ret" }, OBJECT(1));
+	add("float superinstructions", "mut x: float = 1.5; mut y: float = 2.0; mut i: int = 2; return x * y - i;", true,
+		{ "0: store_float $0, 1.500000", "13: store_float $1, 2.000000", "26: store_int $2, 2", "35: mulf_var_var $0, $1",
+			"44: push_var_cast_float $2", "49: subf", "50: ret", "51: ret" },
+		OBJECT(1.0));
+}
+bool bytecode_test::run_test(const std::unique_ptr<void>& parameter) const {
+	bytecode_test_parameter* param = static_cast<bytecode_test_parameter*>(parameter.get());
+	compile_unit unit(std::move(param->source));
+	const syntax_tree& tree = unit.parse();
+	if (tree.root() == no_node || !unit.type_errors().empty()) {
+		return false;
+	}
+	asm_context con;
+	tree.encode(tree.root(), con);
+	if (param->optimize) {
+		peephole_optimizer().run(con);
+		superinstruction_selector::select(con);
+	}
+	bytecode program = bytecode::compile(con);
+	std::vector<std::string> lines;
+	std::istringstream disassembly(program.disassemble());
+	for (std::string line; std::getline(disassembly, line);) {
+		lines.push_back(line);
+	}
+	if (lines != param->disassembly || program.count() != lines.size()) {
+		return false;
+	}
+	return returns(con, param->return_value);
+}
+
+struct interpreter_allocation_test_parameter {
+	std::string source;
+	std::uint32_t max_stack;
+	OBJECT return_value;
+};
+
+IMPLEMENT_FUNCTIONAL_TEST(interpreter_allocation)
+void interpreter_allocation_test::get_tests(std::vector<test_parameter>& parameters) const {
+	auto add = [&parameters](const char* name, std::string source, std::uint32_t max_stack, OBJECT ret) {
+		parameters.push_back(test_parameter {
+			.test_name = name,
+			.object = std::make_unique<interpreter_allocation_test_parameter>(interpreter_allocation_test_parameter {
+				.source = std::move(source),
+				.max_stack = max_stack,
+				.return_value = ret
+			})
+		});
+	};
+	add("arithmetic", "return (1 + 2) * (3 + 4.5);", 3, OBJECT(22.5));
+	add("variables", "mut x: int = 1; mut y: float = 2.5; x = x + 1; y = y * x; return y - x;", 2, OBJECT(3.0));
+	add("nested operands", "return 1 + (2 + (3 + (4 + 5)));", 5, OBJECT(15));
+}
+bool interpreter_allocation_test::run_test(const std::unique_ptr<void>& parameter) const {
+	interpreter_allocation_test_parameter* param = static_cast<interpreter_allocation_test_parameter*>(parameter.get());
+	compile_unit unit(std::move(param->source));
+	const syntax_tree& tree = unit.parse();
+	if (tree.root() == no_node || !unit.type_errors().empty()) {
+		return false;
+	}
+	asm_context con;
+	tree.encode(tree.root(), con);
+	bytecode program = bytecode::compile(con);
+	if (program.max_stack() != param->max_stack) {
+		return false;
+	}
+	interpreter runner(program);
+	std::size_t before = allocations;
+	std::size_t results = 0;
+	for (int count = 0; count < 100; ++count) {
+		std::span<const value> stack = runner.run();
+		results += stack.size();
+	}
+	if (allocations != before || results != 100) {
+		return false;
+	}
+	OBJECT result = runner.run().back().to_object();
+	return result.index() == param->return_value.index() && !std::visit(cmp_not_equal{}, result, param->return_value);
+}
+
+struct register_engine_test_parameter {
+	std::string source;
+	std::vector<std::string> disassembly;
+	OBJECT return_value;
+};
+
+IMPLEMENT_FUNCTIONAL_TEST(register_engine)
+void register_engine_test::get_tests(std::vector<test_parameter>& parameters) const {
+	auto add = [&parameters](const char* name, std::string source, std::vector<std::string> disassembly, OBJECT ret) {
+		parameters.push_back(test_parameter {
+			.test_name = name,
+			.object = std::make_unique<register_engine_test_parameter>(register_engine_test_parameter {
+				.source = std::move(source),
+				.disassembly = std::move(disassembly),
+				.return_value = ret
+			})
+		});
+	};
+	add("one dispatch per operation", "mut v: int = 1; return v + 2;",
+		{ "r0 = 1", "r1 = 2", "r2 = add r0, r1", "ret r2" }, OBJECT(3));
+	add("dead temporaries are reused", "mut v: int = 1; return (v + 2) * 3 - 4;",
+		{ "r0 = 1", "r1 = 2", "r2 = 3", "r3 = 4", "r4 = add r0, r1", "r4 = mul r4, r2", "r4 = sub r4, r3", "ret r4" },
+		OBJECT(5));
+	add("shared value stays in its register", "mut x: int = 2; mut y: int = x + 1; return y * y + y;",
+		{ "r0 = 2", "r1 = 1", "r2 = add r0, r1", "r3 = mul r2, r2", "r2 = add r3, r2", "ret r2" }, OBJECT(12));
+	add("casts between types", "mut i: int = 3; return i / 2 + 0.5;",
+		{ "r0 = 3", "r1 = 2", "r2 = 0.500000", "r3 = div r0, r1", "r3 = cast_float r3", "r3 = addf r3, r2", "ret r3" },
+		OBJECT(1.5));
+	add("code after return is gone", "return 1; return 2;", { "r0 = 1", "ret r0" }, OBJECT(1));
+}
+bool register_engine_test::run_test(const std::unique_ptr<void>& parameter) const {
+	register_engine_test_parameter* param = static_cast<register_engine_test_parameter*>(parameter.get());
+	compile_unit unit(std::move(param->source));
+	const syntax_tree& tree = unit.parse();
+	if (tree.root() == no_node || !unit.type_errors().empty()) {
+		return false;
+	}
+	register_code code = register_code::compile(build_optimized(tree).front());
+	std::vector<std::string> lines;
+	std::istringstream disassembly(code.disassemble());
+	for (std::string line; std::getline(disassembly, line);) {
+		lines.push_back(line);
+	}
+	return lines == param->disassembly && returns(tree, param->return_value, true);
+}
+
+struct quickening_test_parameter {
+	std::string source;
+	bool fused;
+	/* one run of the same interpreter per entry. the body of the function
+	 * runs when the source defines one, the global code otherwise */
+	std::vector<std::vector<OBJECT>> arguments;
+	std::vector<OBJECT> return_values;
+	/* the lines of the code that differ from the compiled code after the
+	 * last run */
+	std::vector<std::string> rewritten;
+	std::size_t deoptimized;
+};
+
+IMPLEMENT_FUNCTIONAL_TEST(quickening)
+void quickening_test::get_tests(std::vector<test_parameter>& parameters) const {
+	auto add = [&parameters](const char* name, std::string source, bool fused, std::vector<std::vector<OBJECT>> arguments,
+		std::vector<OBJECT> rets, std::vector<std::string> rewritten, std::size_t deoptimized) {
+		parameters.push_back(test_parameter {
+			.test_name = name,
+			.object = std::make_unique<quickening_test_parameter>(quickening_test_parameter {
+				.source = std::move(source),
+				.fused = fused,
+				.arguments = std::move(arguments),
+				.return_values = std::move(rets),
+				.rewritten = std::move(rewritten),
+				.deoptimized = deoptimized
+			})
+		});
+	};
+	add("cast is specialized on its first run", "mut i: int = 3; return i + 0.5;", false,
+		{ {}, {} }, { OBJECT(3.5), OBJECT(3.5) }, { "20: cast_i2f" }, 0);
+	add("fused cast is specialized", "mut i: int = 3; return i + 0.5;", true,
+		{ {}, {} }, { OBJECT(3.5), OBJECT(3.5) }, { "9: push_var_i2f $0" }, 0);
+	add("argument of another type deoptimizes", "fn half(const x: int) -> const float { return x / 2.0; } return 0;", false,
+		{ { OBJECT(3) }, { OBJECT(3.5) }, { OBJECT(4) } }, { OBJECT(1.5), OBJECT(1.75), OBJECT(2.0) }, { "5: cast_float_any" }, 1);
+}
+bool quickening_test::run_test(const std::unique_ptr<void>& parameter) const {
+	quickening_test_parameter* param = static_cast<quickening_test_parameter*>(parameter.get());
+	compile_unit unit(std::move(param->source));
+	const syntax_tree& tree = unit.parse();
+	if (tree.root() == no_node || !unit.type_errors().empty()) {
+		return false;
+	}
+	asm_context con;
+	tree.encode(tree.root(), con);
+	if (param->fused) {
+		superinstruction_selector::select(con);
+	}
+	const std::list<std::unique_ptr<instruct>>* codes = &con.codes;
+	std::uint32_t frame_size = static_cast<std::uint32_t>(con.frame.size());
+	con.functions.for_each([&codes, &frame_size](symbol, const asm_context::function_info& info) {
+		codes = &info.instruction;
+		frame_size = info.frame_size;
+	});
+	bytecode program = bytecode::compile(*codes, frame_size);
+	interpreter runner(program);
+	for (std::size_t run = 0; run < param->arguments.size(); ++run) {
+		std::vector<value> arguments;
+		for (const OBJECT& argument : param->arguments[run]) {
+			arguments.push_back(value::from_object(argument));
+		}
+		std::span<const value> stack = runner.run(arguments);
+		if (stack.size() != 1) {
+			return false;
+		}
+		OBJECT result = stack.back().to_object();
+		const OBJECT& expected = param->return_values[run];
+		if (result.index() != expected.index() || std::visit(cmp_not_equal{}, result, expected)) {
+			return false;
+		}
+	}
+	std::vector<std::string> rewritten;
+	std::istringstream compiled(program.disassemble());
+	std::istringstream current(runner.disassemble());
+	for (std::string before, after; std::getline(compiled, before) && std::getline(current, after);) {
+		if (before != after) {
+			rewritten.push_back(after);
+		}
+	}
+	return rewritten == param->rewritten && runner.quickened() == rewritten.size()
+		&& runner.deoptimized() == param->deoptimized;
+}
+
+struct verifier_test_parameter {
+	std::list<std::unique_ptr<instruct>> codes;
+	std::uint32_t frame_size;
+	std::vector<verifier::argument> arguments;
+	/* empty when the code is sound */
+	std::string error;
+	std::size_t offset;
+};
+
+IMPLEMENT_FUNCTIONAL_TEST(verifier)
+void verifier_test::get_tests(std::vector<test_parameter>& parameters) const {
+	/* the encoder only emits sound code, so the input is built by hand */
+	using code_list = std::list<std::unique_ptr<instruct>>;
+	auto push = [](code_list& codes, OBJECT value) {
+		std::unique_ptr<push_instruct> inst = std::make_unique<push_instruct>();
+		inst->value = operand { .type = operand_type::immidiate, .value = value };
+		codes.push_back(std::move(inst));
+	};
+	auto push_var = [](code_list& codes, slot_index slot) {
+		std::unique_ptr<push_instruct> inst = std::make_unique<push_instruct>();
+		inst->value = operand { .type = operand_type::variable, .slot = slot };
+		codes.push_back(std::move(inst));
+	};
+	auto alloc = [](code_list& codes, slot_index slot, bool is_mutable) {
+		std::unique_ptr<alloc_instruct> inst = std::make_unique<alloc_instruct>();
+		inst->is_mutable = is_mutable;
+		inst->slot = slot;
+		inst->type = object_type::integer;
+		codes.push_back(std::move(inst));
+	};
+	auto init = [](code_list& codes, slot_index slot) {
+		std::unique_ptr<init_instruct> inst = std::make_unique<init_instruct>();
+		inst->slot = slot;
+		codes.push_back(std::move(inst));
+	};
+	auto mov = [](code_list& codes, slot_index slot) {
+		std::unique_ptr<mov_instruct> inst = std::make_unique<mov_instruct>();
+		inst->slot = slot;
+		codes.push_back(std::move(inst));
+	};
+	auto add = [&parameters](const char* name, code_list codes, std::uint32_t frame_size,
+		std::vector<verifier::argument> arguments, std::string error, std::size_t offset)
+	{
+		parameters.push_back(test_parameter {
+			.test_name = name,
+			.object = std::make_unique<verifier_test_parameter>(verifier_test_parameter {
+				.codes = std::move(codes),
+				.frame_size = frame_size,
+				.arguments = std::move(arguments),
+				.error = std::move(error),
+				.offset = offset
+			})
+		});
+	};
+
+	code_list sound;
+	alloc(sound, 1, true);
+	push(sound, OBJECT(1));
+	init(sound, 1);
+	push(sound, OBJECT(2));
+	mov(sound, 1);
+	push_var(sound, 1);
+	push_var(sound, 0);
+	sound.push_back(std::make_unique<add_instruct>());
+	add("sound code with an argument", std::move(sound), 2, { { value::tag::integer, false } }, "", 0);
+
+	code_list underflow;
+	push(underflow, OBJECT(1));
+	underflow.push_back(std::make_unique<add_instruct>());
+	add("stack underflow", std::move(underflow), 0, {}, "add: the stack is empty", 5);
+
+	code_list mixed;
+	push(mixed, OBJECT(1));
+	push(mixed, OBJECT(2.5));
+	mixed.push_back(std::make_unique<add_instruct>());
+	add("operand of the wrong type", std::move(mixed), 0, {}, "add: expects int but the stack has float", 14);
+
+	code_list constant;
+	alloc(constant, 0, false);
+	push(constant, OBJECT(1));
+	init(constant, 0);
+	push(constant, OBJECT(2));
+	mov(constant, 0);
+	add("assignment to a constant", std::move(constant), 1, {}, "store: $0 is constant", 20);
+
+	code_list argument;
+	push(argument, OBJECT(2));
+	mov(argument, 0);
+	add("assignment to a constant argument", std::move(argument), 1, { { value::tag::integer, false } },
+		"store: $0 is constant", 5);
+
+	code_list uninitialized;
+	alloc(uninitialized, 0, true);
+	push_var(uninitialized, 0);
+	add("read before write", std::move(uninitialized), 1, {}, "push_var: $0 is read before it is written", 5);
+
+	code_list untyped;
+	push_var(untyped, 0);
+	add("argument without a type", std::move(untyped), 1, { { value::tag::none, false } }, "push_var: $0 has no type", 0);
+
+	code_list outside;
+	push_var(outside, 3);
+	add("slot outside the frame", std::move(outside), 1, {}, "push_var: $3 is outside the frame of 1", 0);
+
+	code_list twice;
+	alloc(twice, 0, false);
+	push(twice, OBJECT(1));
+	init(twice, 0);
+	push(twice, OBJECT(1));
+	init(twice, 0);
+	add("initialized twice", std::move(twice), 1, {}, "init: $0 is initialized twice", 20);
+
+	code_list zero;
+	std::unique_ptr<binary_var_imm_instruct> divide = std::make_unique<binary_var_imm_instruct>();
+	divide->op = arithmetic::div;
+	divide->type = object_type::integer;
+	divide->slot = 0;
+	divide->rhs = OBJECT(0);
+	zero.push_back(std::move(divide));
+	add("immediate divisor of 0", std::move(zero), 1, { { value::tag::integer, false } }, "div_var_imm: divides by 0", 0);
+
+	/* what the encoder emits for a variable assigned before it is read */
+	compile_unit unit("mut a: int; a = 1; return a;");
+	const syntax_tree& tree = unit.parse();
+	asm_context encoded;
+	tree.encode(tree.root(), encoded);
+	add("encoded assignment before any read", std::move(encoded.codes), static_cast<std::uint32_t>(encoded.frame.size()),
+		{}, "", 0);
+}
+bool verifier_test::run_test(const std::unique_ptr<void>& parameter) const {
+	verifier_test_parameter* param = static_cast<verifier_test_parameter*>(parameter.get());
+	bytecode program = bytecode::compile(param->codes, param->frame_size);
+	std::optional<verifier::error> error = verifier::verify(program, param->arguments);
+	if (error) {
+		return !program.is_verified() && error->message == param->error && error->offset == param->offset;
+	}
+	if (!param->error.empty() || !program.is_verified()) {
+		return false;
+	}
+	/* the unchecked run, which the arguments are verified for, ends as
+	 * the checked run of the same code does */
+	bytecode unverified = bytecode::compile(param->codes, param->frame_size);
+	interpreter checked(unverified);
+	interpreter runner(program);
+	std::vector<value> arguments(param->arguments.size(), value::of(std::int32_t(40)));
+	std::span<const value> expected = checked.run(arguments);
+	std::span<const value> stack = runner.run(arguments);
+	return stack.size() == 1 && expected.size() == 1 && stack.back().type == value::tag::integer &&
+		stack.back().type == expected.back().type && stack.back().integer == expected.back().integer;
+}
+
+struct checked_frame_test_parameter {
+	std::list<std::unique_ptr<instruct>> codes;
+	std::uint32_t frame_size;
+	/* values on the stack when the run stops */
+	std::size_t stack_size;
+};
+
+IMPLEMENT_FUNCTIONAL_TEST(checked_frame)
+void checked_frame_test::get_tests(std::vector<test_parameter>& parameters) const {
+	/* unverified code naming slots past the frame, each followed by a push
+	 * that must not run */
+	using code_list = std::list<std::unique_ptr<instruct>>;
+	auto push = [](code_list& codes, OBJECT value) {
+		std::unique_ptr<push_instruct> inst = std::make_unique<push_instruct>();
+		inst->value = operand { .type = operand_type::immidiate, .value = value };
+		codes.push_back(std::move(inst));
+	};
+	auto add = [&parameters](const char* name, code_list codes, std::uint32_t frame_size, std::size_t stack_size) {
+		parameters.push_back(test_parameter {
+			.test_name = name,
+			.object = std::make_unique<checked_frame_test_parameter>(checked_frame_test_parameter {
+				.codes = std::move(codes),
+				.frame_size = frame_size,
+				.stack_size = stack_size
+			})
+		});
+	};
+
+	code_list read;
+	std::unique_ptr<push_instruct> push_var = std::make_unique<push_instruct>();
+	push_var->value = operand { .type = operand_type::variable, .slot = 3 };
+	read.push_back(std::move(push_var));
+	push(read, OBJECT(7));
+	add("read past the frame", std::move(read), 1, 0);
+
+	code_list write;
+	push(write, OBJECT(1));
+	std::unique_ptr<mov_instruct> mov = std::make_unique<mov_instruct>();
+	mov->slot = 1;
+	write.push_back(std::move(mov));
+	push(write, OBJECT(7));
+	add("write past the frame", std::move(write), 1, 1);
+
+	code_list allocation;
+	std::unique_ptr<alloc_instruct> alloc = std::make_unique<alloc_instruct>();
+	alloc->is_mutable = true;
+	alloc->slot = 0;
+	alloc->type = object_type::floating;
+	allocation.push_back(std::move(alloc));
+	push(allocation, OBJECT(7));
+	add("allocation in an empty frame", std::move(allocation), 0, 0);
+}
+bool checked_frame_test::run_test(const std::unique_ptr<void>& parameter) const {
+	checked_frame_test_parameter* param = static_cast<checked_frame_test_parameter*>(parameter.get());
+	bytecode program = bytecode::compile(param->codes, param->frame_size);
+	interpreter runner(program);
+	return runner.run().size() == param->stack_size;
+}
+
+struct register_verifier_test_parameter {
+	ir_function function;
+	/* empty when the code is sound */
+	std::string error;
+	std::size_t offset;
+};
+
+IMPLEMENT_FUNCTIONAL_TEST(register_verifier)
+void register_verifier_test::get_tests(std::vector<test_parameter>& parameters) const {
+	/* the builder only emits well-typed code, so the input is built by hand */
+	auto constant = [](ir_function& function, OBJECT value, object_type type) {
+		return function.add(ir_instruction { .op = ir_opcode::constant, .type = type, .constant = value });
+	};
+	/* returns the sum of lhs and the integer 1, which takes the register
+	 * after lhs */
+	auto add_one = [&constant](ir_function& function, ir_value lhs) {
+		ir_value rhs = constant(function, OBJECT(1), object_type::integer);
+		ir_value sum = function.add(ir_instruction { .op = ir_opcode::add, .type = object_type::integer, .lhs = lhs, .rhs = rhs });
+		function.add(ir_instruction { .op = ir_opcode::ret, .lhs = sum });
+	};
+	auto add = [&parameters](const char* name, ir_function function, std::string error, std::size_t offset) {
+		parameters.push_back(test_parameter {
+			.test_name = name,
+			.object = std::make_unique<register_verifier_test_parameter>(register_verifier_test_parameter {
+				.function = std::move(function),
+				.error = std::move(error),
+				.offset = offset
+			})
+		});
+	};
+
+	ir_function sound;
+	add_one(sound, constant(sound, OBJECT(2), object_type::integer));
+	add("sound code", std::move(sound), "", 0);
+
+	ir_function mixed;
+	add_one(mixed, constant(mixed, OBJECT(1.5), object_type::floating));
+	add("operand of the wrong type", std::move(mixed), "add: expects int but r0 is float", 0);
+
+	ir_function argument;
+	ir_value first = argument.add(ir_instruction { .op = ir_opcode::argument, .type = object_type::integer, .index = 0 });
+	add_one(argument, first);
+	add("argument that is never passed", std::move(argument), "add: r0 is read before it is written", 0);
+
+	ir_function poison;
+	poison.add(ir_instruction { .op = ir_opcode::ret, .lhs = constant(poison, OBJECT(), object_type::none) });
+	add("constant without a type", std::move(poison), "r0 has no type", 0);
+}
+bool register_verifier_test::run_test(const std::unique_ptr<void>& parameter) const {
+	register_verifier_test_parameter* param = static_cast<register_verifier_test_parameter*>(parameter.get());
+	register_code code = register_code::compile(param->function);
+	std::optional<verifier::error> error = verifier::verify(code);
+	if (error) {
+		return error->message == param->error && error->offset == param->offset;
+	}
+	return param->error.empty() && register_machine::evaluate(code).size() == 1;
+}
+
+struct integer_division_test_parameter {
+	std::list<std::unique_ptr<instruct>> codes;
+	std::int32_t lhs;
+	std::int32_t rhs;
+	/* none when the division aborts */
+	std::optional<std::int32_t> quotient;
+};
+
+IMPLEMENT_FUNCTIONAL_TEST(integer_division)
+void integer_division_test::get_tests(std::vector<test_parameter>& parameters) const {
+	/* divides argument $0 by argument $1, through the stack or fused */
+	using code_list = std::list<std::unique_ptr<instruct>>;
+	auto stack = []() {
+		code_list codes;
+		for (slot_index slot : { 0, 1 }) {
+			std::unique_ptr<push_instruct> inst = std::make_unique<push_instruct>();
+			inst->value = operand { .type = operand_type::variable, .slot = slot };
+			codes.push_back(std::move(inst));
+		}
+		codes.push_back(std::make_unique<div_instruct>());
+		return codes;
+	};
+	auto fused = []() {
+		code_list codes;
+		std::unique_ptr<binary_var_var_instruct> inst = std::make_unique<binary_var_var_instruct>();
+		inst->op = arithmetic::div;
+		inst->type = object_type::integer;
+		inst->lhs_slot = 0;
+		inst->rhs_slot = 1;
+		codes.push_back(std::move(inst));
+		return codes;
+	};
+	auto add = [&parameters](std::string name, code_list codes, std::int32_t lhs, std::int32_t rhs,
+		std::optional<std::int32_t> quotient)
+	{
+		parameters.push_back(test_parameter {
+			.test_name = std::move(name),
+			.object = std::make_unique<integer_division_test_parameter>(integer_division_test_parameter {
+				.codes = std::move(codes),
+				.lhs = lhs,
+				.rhs = rhs,
+				.quotient = quotient
+			})
+		});
+	};
+
+	const std::int32_t min = std::numeric_limits<std::int32_t>::min();
+	for (bool is_fused : { false, true }) {
+		std::string suffix = is_fused ? " of two variables" : " on the stack";
+		add("quotient" + suffix, is_fused ? fused() : stack(), 7, 2, 3);
+		add("division by 0" + suffix, is_fused ? fused() : stack(), 7, 0, std::nullopt);
+		add("smallest int by -1" + suffix, is_fused ? fused() : stack(), min, -1, std::nullopt);
+	}
+}
+bool integer_division_test::run_test(const std::unique_ptr<void>& parameter) const {
+	integer_division_test_parameter* param = static_cast<integer_division_test_parameter*>(parameter.get());
+	value arguments[] = { value::of(param->lhs), value::of(param->rhs) };
+	auto divides = [param](std::span<const value> stack) {
+		if (!param->quotient) {
+			return stack.empty();
+		}
+		return stack.size() == 1 && stack.back().type == value::tag::integer && stack.back().integer == *param->quotient;
+	};
+
+	/* checked, then unchecked once verified */
+	bytecode program = bytecode::compile(param->codes, 2);
+	if (!divides(interpreter(program).run(arguments))) {
+		return false;
+	}
+	verifier::argument types[] = { { value::tag::integer, false }, { value::tag::integer, false } };
+	if (verifier::verify(program, types) || !divides(interpreter(program).run(arguments))) {
+		return false;
+	}
+
+	ir_function function;
+	ir_value lhs = function.add(ir_instruction { .op = ir_opcode::constant, .type = object_type::integer, .constant = OBJECT(param->lhs) });
+	ir_value rhs = function.add(ir_instruction { .op = ir_opcode::constant, .type = object_type::integer, .constant = OBJECT(param->rhs) });
+	ir_value quotient = function.add(ir_instruction { .op = ir_opcode::div, .type = object_type::integer, .lhs = lhs, .rhs = rhs });
+	function.add(ir_instruction { .op = ir_opcode::ret, .lhs = quotient });
+	register_code code = register_code::compile(function);
+	if (verifier::verify(code)) {
+		return false;
+	}
+	std::vector<OBJECT> returned = register_machine::evaluate(code);
+	if (!param->quotient) {
+		return returned.empty();
+	}
+	return returned.size() == 1 && std::get<int>(returned.back()) == *param->quotient;
+}
@@ -1,10 +1,12 @@
 #pragma once
+#include <cstdint>
 #include <list>
 #include <memory>
 #include <variant>
 #include <string>
-#include <map>
+#include <vector>
 #include "types.hpp"
+#include "interner.hpp"
 
 
 struct invalid_type {};
@@ -15,7 +17,7 @@ static inline constexpr int INT_TYPE_INDEX = OBJECT(0).index();
 static inline constexpr int DOUBLE_TYPE_INDEX = OBJECT(0.).index();
 static inline constexpr int STRING_TYPE_INDEX = OBJECT("").index();
 
-enum class object_type {
+enum class object_type : std::uint8_t {
 	none = INVALID_TYPE_INDEX,
 	integer = INT_TYPE_INDEX,
 	floating = DOUBLE_TYPE_INDEX,
@@ -25,8 +27,12 @@ enum class object_type {
 class instruct;
 struct operand;
 
+/* index of a variable in the frame of the function that defines it */
+using slot_index = std::uint32_t;
+static inline constexpr slot_index no_slot = ~slot_index(0);
+
 struct variable {
-	std::string name;
+	symbol name;
 	bool is_mutable;
 	bool is_init { false };
 	OBJECT value;
@@ -37,17 +43,22 @@ public:
 	struct function_info {
 		std::list<variable> argument;
 		std::list<std::unique_ptr<instruct>> instruction;
+		/* slots the body needs, the arguments first */
+		std::uint32_t frame_size { 0 };
 	};
 	
 public:
 	std::list<operand> stack;
 	bool is_abort { false };
 
-	std::map<std::string, variable> variables;
+	/* the values of the variables, indexed by the slots the type checker
+	 * gave them. encode sizes it for the code it emits. */
+	std::vector<OBJECT> frame;
 
 	std::list<std::unique_ptr<instruct>> codes;
 
-	std::map<std::string, function_info> functions;
+	/* keyed by the interned mangled name */
+	symbol_map<function_info> functions;
 };
 
 class instruct {
@@ -62,9 +73,13 @@ enum class operand_type {
 	variable,
 };
 
+/* an immidiate carries its value, a variable its slot and, for the
+ * listing, its name */
 struct operand {
 	operand_type type;
 	OBJECT value;
+	symbol name { no_symbol };
+	slot_index slot { no_slot };
 };
 
 class push_instruct : public instruct {
@@ -92,7 +107,8 @@ public:
 
 public:
 	bool is_mutable { false };
-	std::string name;
+	symbol name;
+	slot_index slot;
 	object_type type;
 };
 
@@ -103,7 +119,8 @@ public:
 	std::string log(const std::string& prefix) const override;
 
 public:
-	std::string lhs;
+	symbol lhs;
+	slot_index slot;
 };
 
 class return_instruct : public instruct {
@@ -127,7 +144,8 @@ public:
 	std::string log(const std::string& prefix) const override;
 
 public:
-	std::string lhs;
+	symbol lhs;
+	slot_index slot;
 };
 
 class add_instruct : public instruct {
@@ -165,7 +183,8 @@ public:
 	std::string log(const std::string& prefix) const override;
 
 public:
-	std::string lhs;
+	symbol lhs;
+	slot_index slot;
 };
 
 class addf_instruct : public instruct {
@@ -206,3 +225,74 @@ public:
 public:
 	object_type to;
 };
+
+/* superinstructions. each stands for a sequence the instruction profile
+ * found among the most executed, and does its work in one dispatch
+ * without going through the stack in between. superinstruction_selector
+ * puts them in place of the sequences. */
+enum class arithmetic : std::uint8_t {
+	add,
+	sub,
+	mul,
+	div,
+};
+
+/* alloc, push of a literal and init of the same slot */
+class init_from_imm_instruct : public instruct {
+public:
+	~init_from_imm_instruct() = default;
+	void execute(asm_context& con) const override;
+	std::string log(const std::string& prefix) const override;
+
+public:
+	bool is_mutable { false };
+	symbol name;
+	slot_index slot;
+	object_type type;
+	OBJECT value;
+};
+
+/* push of a variable and cast */
+class push_var_cast_instruct : public instruct {
+public:
+	~push_var_cast_instruct() = default;
+	void execute(asm_context& con) const override;
+	std::string log(const std::string& prefix) const override;
+
+public:
+	symbol name;
+	slot_index slot;
+	object_type to;
+};
+
+/* push of a variable, push of a literal and an operation on the two */
+class binary_var_imm_instruct : public instruct {
+public:
+	~binary_var_imm_instruct() = default;
+	void execute(asm_context& con) const override;
+	std::string log(const std::string& prefix) const override;
+
+public:
+	arithmetic op;
+	/* integer or floating, as the fused operation computes */
+	object_type type;
+	symbol lhs;
+	slot_index slot;
+	OBJECT rhs;
+};
+
+/* pushes of two variables and an operation on them */
+class binary_var_var_instruct : public instruct {
+public:
+	~binary_var_var_instruct() = default;
+	void execute(asm_context& con) const override;
+	std::string log(const std::string& prefix) const override;
+
+public:
+	arithmetic op;
+	object_type type;
+	symbol lhs;
+	slot_index lhs_slot;
+	symbol rhs;
+	slot_index rhs_slot;
+};
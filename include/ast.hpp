@@ -0,0 +1,140 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "tokenize.hpp"
+#include "asm.hpp"
+#include "types.hpp"
+
+
+enum class ast_kind : std::uint8_t {
+	error,
+	value,
+	parenthess,
+	bin_op,
+	expr,
+	var_define,
+	_return,
+	block,
+	function,
+};
+
+/* index of a node in its syntax_tree. no_node is never handed out, so a
+ * missing child is a zero. */
+using node_id = std::uint32_t;
+static inline constexpr node_id no_node = 0;
+
+/* one fixed-size record per node. which fields a node uses depends on its kind:
+ *   error       str = message, lhs = the node the error is about
+ *   value       tok = number, floating or identifier, str = its text,
+ *               sym and type = name and type of a variable, list = its
+ *               frame slot (see slot())
+ *   parenthess  lhs = expression
+ *   bin_op      tok = operator, lhs and rhs = operands
+ *   expr        lhs = expression
+ *   var_define  tok = const or mut, var_type = int or float, str and sym =
+ *               name, lhs = initial value, list = frame slot
+ *   _return     lhs = expression
+ *   block       str = name, list = statements
+ *   function    str and sym = name (str is empty when it was missing),
+ *               tok and var_type = return type (unknown where one was
+ *               missing, eof before the parser reached it), lhs = body,
+ *               list = the first list_split entries are arguments and the
+ *               rest are errors
+ * type is the type of the node's value and cast the type it is converted to
+ * where that value is used, none for no conversion. the parser sets type on
+ * identifiers and type_checker fills in the rest.
+ * str views either the source or text stored in the tree. offset is where
+ * the node starts in the source: its token, the operator of a bin_op, the
+ * token an error was found at. */
+struct ast_node {
+	ast_kind kind;
+	token_type tok { token_type::eof };
+	token_type var_type { token_type::eof };
+	object_type type { object_type::none };
+	object_type cast { object_type::none };
+	symbol sym { no_symbol };
+	node_id lhs { no_node };
+	node_id rhs { no_node };
+	std::uint32_t list { 0 };
+	std::uint32_t list_size { 0 };
+	std::uint32_t list_split { 0 };
+	std::uint32_t offset { 0 };
+	std::string_view str;
+};
+
+/* the AST of one parse, kept as a flat array of node records that refer to
+ * each other by index. child lists live in one shared array. nothing in a
+ * record owns memory, so the whole tree is released at once. */
+class syntax_tree {
+public:
+	syntax_tree();
+	~syntax_tree() = default;
+
+	syntax_tree(const syntax_tree&) = delete;
+	syntax_tree& operator=(const syntax_tree&) = delete;
+	syntax_tree(syntax_tree&&) = default;
+	syntax_tree& operator=(syntax_tree&&) = default;
+
+	node_id add(const ast_node& node);
+	ast_node& operator[](node_id id);
+	const ast_node& operator[](node_id id) const;
+	/* number of nodes, plus one for no_node */
+	std::size_t size() const;
+
+	/* lists are gathered on a stack, so a nested list can be filled while
+	 * an outer one is still open. end_list moves the entries pushed since
+	 * `mark` into `owner`'s list. */
+	std::size_t begin_list() const;
+	void push_list(node_id id);
+	void end_list(node_id owner, std::size_t mark);
+	std::span<const node_id> list(node_id id) const;
+
+	/* copies text that does not live in the source, such as a message */
+	std::string_view store(std::string_view text);
+
+	node_id root() const;
+	void set_root(node_id id);
+
+	/* the type type_checker resolved for `id`, none for no_node */
+	object_type type(node_id id) const;
+	/* the value of a number or floating literal, read as its type */
+	OBJECT literal(node_id id) const;
+	/* the frame slot type_checker gave a variable or a reference to one */
+	slot_index slot(node_id id) const;
+	void set_slot(node_id id, slot_index slot);
+	/* the walks below keep their pending work on the heap, so they handle
+	 * any nesting depth with the call stack they start with */
+	std::string log(node_id id, const std::string& prefix) const;
+	/* levels below this are indented like it, so the log grows with the
+	 * number of nodes rather than with nodes times depth */
+	static constexpr std::size_t max_log_indent = 64;
+	/* expects the tree to have been through type_checker */
+	void encode(node_id id, asm_context& con) const;
+	/* "fn@name(modifier type,...)" of a function node */
+	std::string mangled_name(node_id id) const;
+
+	/* drops every node, keeping the storage for the next parse */
+	void clear();
+	/* bytes used by the elements, not counting spare capacity */
+	std::size_t memory_size() const;
+
+private:
+	void encode_value(node_id id, asm_context& con) const;
+	void encode_cast(node_id id, asm_context& con) const;
+	void encode_operator(node_id id, asm_context& con) const;
+	void encode_function(node_id id, asm_context body, asm_context& con) const;
+
+	std::vector<ast_node> _nodes;
+	std::vector<node_id> _lists;
+	std::vector<node_id> _pending;
+	/* stored text lives in fixed blocks that are never moved */
+	std::vector<std::unique_ptr<char[]>> _text_blocks;
+	std::size_t _text_used;
+	node_id _root;
+};
@@ -0,0 +1,163 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "asm.hpp"
+#include "value.hpp"
+
+
+/* what follows an opcode in the code array. slots are 32-bit, ints are
+ * 32-bit and floats are 64-bit, all unaligned */
+enum class operand_layout : std::uint8_t {
+	none,
+	slot,
+	integer,
+	floating,
+	slot_integer,
+	slot_floating,
+	slot_slot,
+};
+
+/* every opcode with its operands and how many values it leaves on the
+ * stack, net of those it takes. an instruction's type is in its opcode,
+ * so only casts look at the type of a value. the interpreter runs init and
+ * store, and the const allocs, as it does the others; they are distinct so
+ * that the verifier can see declarations and mutability. */
+#define BYTECODE_OPCODES(X) \
+	X(push_int, integer, 1) \
+	X(push_float, floating, 1) \
+	X(push_var, slot, 1) \
+	X(pop, none, -1) \
+	X(alloc_int, slot, 0) \
+	X(alloc_float, slot, 0) \
+	X(alloc_const_int, slot, 0) \
+	X(alloc_const_float, slot, 0) \
+	X(init, slot, -1) \
+	X(store, slot, -1) \
+	X(store_int, slot_integer, 0) \
+	X(store_float, slot_floating, 0) \
+	X(store_const_int, slot_integer, 0) \
+	X(store_const_float, slot_floating, 0) \
+	X(add, none, -1) \
+	X(sub, none, -1) \
+	X(mul, none, -1) \
+	X(div, none, -1) \
+	X(addf, none, -1) \
+	X(subf, none, -1) \
+	X(mulf, none, -1) \
+	X(divf, none, -1) \
+	X(cast_int, none, 0) \
+	X(cast_float, none, 0) \
+	X(push_var_cast_int, slot, 1) \
+	X(push_var_cast_float, slot, 1) \
+	X(add_var_imm, slot_integer, 1) \
+	X(sub_var_imm, slot_integer, 1) \
+	X(mul_var_imm, slot_integer, 1) \
+	X(div_var_imm, slot_integer, 1) \
+	X(addf_var_imm, slot_floating, 1) \
+	X(subf_var_imm, slot_floating, 1) \
+	X(mulf_var_imm, slot_floating, 1) \
+	X(divf_var_imm, slot_floating, 1) \
+	X(add_var_var, slot_slot, 1) \
+	X(sub_var_var, slot_slot, 1) \
+	X(mul_var_var, slot_slot, 1) \
+	X(div_var_var, slot_slot, 1) \
+	X(addf_var_var, slot_slot, 1) \
+	X(subf_var_var, slot_slot, 1) \
+	X(mulf_var_var, slot_slot, 1) \
+	X(divf_var_var, slot_slot, 1) \
+	X(ret, none, 0) \
+	X(abort, none, 0) \
+	QUICKENED_OPCODES(X)
+
+/* what the interpreter rewrites a type-dispatching instruction into the
+ * first time it runs it, once it has seen the type of its operand. each
+ * checks only that the type is still the one it saw, and rewrites itself
+ * into the _any form, which never specializes again, when it is not.
+ * compile() never emits them. */
+#define QUICKENED_OPCODES(X) \
+	X(cast_i2i, none, 0) \
+	X(cast_f2i, none, 0) \
+	X(cast_int_any, none, 0) \
+	X(cast_i2f, none, 0) \
+	X(cast_f2f, none, 0) \
+	X(cast_float_any, none, 0) \
+	X(push_var_i2i, slot, 1) \
+	X(push_var_f2i, slot, 1) \
+	X(push_var_cast_int_any, slot, 1) \
+	X(push_var_i2f, slot, 1) \
+	X(push_var_f2f, slot, 1) \
+	X(push_var_cast_float_any, slot, 1)
+
+enum class opcode : std::uint8_t {
+#define BYTECODE_ENUM(name, layout, effect) name,
+	BYTECODE_OPCODES(BYTECODE_ENUM)
+#undef BYTECODE_ENUM
+};
+
+/* a program as one contiguous array: each instruction is a one-byte
+ * opcode followed by its operands. the instruct list it is compiled from
+ * stays the view for listings. */
+class bytecode {
+public:
+	/* the global code of `con` */
+	static bytecode compile(const asm_context& con);
+	static bytecode compile(const std::list<std::unique_ptr<instruct>>& codes, std::uint32_t frame_size);
+
+	const std::uint8_t* data() const;
+	std::size_t size() const;
+	std::uint32_t frame_size() const;
+	/* the most values the stack holds at any point of the program */
+	std::uint32_t max_stack() const;
+	/* number of instructions */
+	std::size_t count() const;
+	/* whether verifier::verify accepted the code, and for arguments of
+	 * which types. the interpreter runs verified code without checks */
+	bool is_verified() const;
+	const std::vector<value::tag>& argument_types() const;
+
+	/* one line per instruction: its offset, opcode and operands */
+	std::string disassemble() const;
+	static std::string disassemble(const std::uint8_t* code, std::size_t size);
+
+	static std::string_view name(opcode op);
+	static operand_layout layout(opcode op);
+	/* bytes of the operands that follow `op` */
+	static std::size_t operand_size(opcode op);
+	static int stack_effect(opcode op);
+
+	template <class T>
+	static T read(const std::uint8_t* at) {
+		T value;
+		std::memcpy(&value, at, sizeof(T));
+		return value;
+	}
+
+private:
+	friend class verifier;
+
+	void emit(opcode op);
+	template <class T>
+	void emit_operand(T value) {
+		std::size_t offset = _code.size();
+		_code.resize(offset + sizeof(T));
+		std::memcpy(_code.data() + offset, &value, sizeof(T));
+	}
+	/* an immediate of the type it holds, or abort for no value */
+	void emit_push(const OBJECT& value);
+	void emit_instruction(const instruct& inst);
+
+	std::vector<std::uint8_t> _code;
+	std::uint32_t _frame_size { 0 };
+	std::uint32_t _max_stack { 0 };
+	/* the depth after the code so far, for max_stack */
+	std::int64_t _depth { 0 };
+	std::size_t _count { 0 };
+	bool _is_verified { false };
+	std::vector<value::tag> _argument_types;
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include <istream>
+#include <string>
+#include <vector>
+#include <memory>
+#include "source_buffer.hpp"
+#include "tokenize.hpp"
+#include "token_array.hpp"
+#include "parser.hpp"
+#include "type_checker.hpp"
+#include "constant_folder.hpp"
+
+
+/* owns the source text of a script.
+ * tokens and AST nodes only hold views into it, so it must outlive both. */
+class compile_unit {
+public:
+	compile_unit(std::string source);
+	compile_unit(source_file file);
+	/* the text is read from `in` block by block while it is lexed */
+	compile_unit(std::istream& in, std::size_t chunk_size = source_buffer::default_chunk_size);
+	~compile_unit() = default;
+
+	compile_unit(const compile_unit&) = delete;
+	compile_unit& operator=(const compile_unit&) = delete;
+	compile_unit(compile_unit&&) = delete;
+	compile_unit& operator=(compile_unit&&) = delete;
+
+	const token_array& tokens() const;
+	const syntax_tree& tree() const;
+	/* the source is longer than source_file::max_size. it then parses to
+	 * no tree, since its offsets would not fit in the tokens */
+	bool is_too_large() const;
+
+	/* lexes the whole input into tokens() */
+	const token_array& tokenize();
+	/* same as tokenize(), but a file or string source is lexed in chunks on
+	 * the thread pool. streamed input is lexed sequentially. */
+	const token_array& tokenize_parallel();
+	/* parses tokens() if tokenize() was called, otherwise pulls tokens
+	 * straight from the lexer without materializing them, from the start of
+	 * the text on every call. the tree is then type checked, ready to be
+	 * encoded. */
+	const syntax_tree& parse();
+	/* what the type checker found in the last parse() */
+	const std::vector<type_checker::error>& type_errors() const;
+	/* folds the constant expressions of the parsed tree ahead of encoding.
+	 * the tree then no longer logs as the source was written. */
+	const syntax_tree& fold_constants();
+
+	/* line and column of a token's or a node's offset. the line table is
+	 * built on the first call, so a run without diagnostics never pays
+	 * for it. */
+	source_location locate(std::uint32_t offset);
+
+private:
+	source_buffer _source;
+	token_array _tokens;
+	syntax_tree _tree;
+	std::vector<type_checker::error> _type_errors;
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include <optional>
+#include <vector>
+#include "ast.hpp"
+#include "asm.hpp"
+
+
+/* rewrites every operation on constants in a type checked tree into the
+ * literal it evaluates to, the way the encoded instructions would compute
+ * it. a `const` variable with a constant initializer is a constant too, so
+ * its uses become literals as well. */
+class constant_folder {
+public:
+	static void fold(syntax_tree& tree, node_id root);
+	/* `value` as cast_instruct would convert it to `to`, or `nullopt` where
+	 * that is undefined, such as a float out of the range of int */
+	static std::optional<OBJECT> cast(const OBJECT& value, object_type to);
+
+private:
+	struct context {
+		syntax_tree& tree;
+		/* values of the constant variables seen so far, by symbol */
+		symbol_map<OBJECT> constants;
+	};
+
+	static void fold_node(context& con, node_id id);
+	/* the value of `id` if it is a literal, after its implicit cast */
+	static std::optional<OBJECT> value_of(context& con, node_id id);
+	/* `nullopt` where the result would differ from the instruction's or is
+	 * undefined, such as an integer division by zero */
+	static std::optional<OBJECT> evaluate(token_type op, const OBJECT& lhs, const OBJECT& rhs);
+	/* turns `id` into a literal holding `value` */
+	static void make_literal(context& con, node_id id, const OBJECT& value);
+};
@@ -0,0 +1,130 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "tokenize.hpp"
+#include "token_array.hpp"
+#include "parser.hpp"
+#include "sequence_tree.hpp"
+
+
+/* an editable script for editor integrations, kept as one segment per
+ * top-level statement so an edit re-lexes and re-parses only what it
+ * touches */
+class document {
+public:
+	struct edit {
+		std::size_t offset;
+		std::size_t removed;
+		std::string_view inserted;
+	};
+
+	struct edit_stats {
+		std::size_t relexed_bytes;
+		std::size_t reparsed_statements;
+		std::size_t reused_statements;
+	};
+
+public:
+	document(std::string source);
+	~document() = default;
+
+	document(const document&) = delete;
+	document& operator=(const document&) = delete;
+
+	void apply(const edit& change);
+
+	/* same text the tree parser::parse builds for text() logs */
+	std::string log() const;
+	std::string text() const;
+	std::size_t size() const;
+	/* the token array of text(), ending with eof */
+	token_array tokens() const;
+
+	const edit_stats& last_stats() const;
+
+private:
+	struct definition {
+		symbol name;
+		bool is_mutable;
+		std::size_t type_index;
+
+		bool operator==(const definition&) const = default;
+	};
+	struct segment {
+		std::shared_ptr<const std::string> piece;
+		std::string_view text;
+		/* offsets are from the start of `text` */
+		token_array tokens;
+		std::vector<definition> defines;
+		std::shared_ptr<const syntax_tree> tree;
+		node_id node;
+		/* the parser looked at tokens after the statement, so an edit to
+		 * the next segment re-parses this one too */
+		bool looks_past;
+	};
+	using segment_node = sequence_tree<segment>::node;
+	enum class build_result {
+		ok,
+		need_more,
+		failed,
+	};
+
+	/* lexes and parses `piece` as the text that follows segment `first` - 1.
+	 * a segment's tokens and AST only view the immutable piece of text it
+	 * was lexed from, with token offsets relative to its own start, and
+	 * the statements parsed together share one syntax_tree that lives for
+	 * as long as any of their segments does. need_more means the parser
+	 * looked past the end of a piece that is not the end of the file, so
+	 * the damaged range has to grow. */
+	build_result build(std::shared_ptr<const std::string> piece, std::size_t first, bool at_end,
+		std::vector<segment>& segments) const;
+	/* replaces segments [first, last] by what `region` parses into, growing
+	 * the range as build asks, and adds the names whose definition changed
+	 * to `changed`. the range grows one segment at a time while the parser
+	 * still looks past its end, and takes in the statement before it when
+	 * that one looked past its own; the segments outside it, and their
+	 * subtrees, are left as they are. the statements after it that mention
+	 * a changed name are re-parsed later, and only those. the index past
+	 * the new segments, or nothing when a statement made no progress */
+	std::optional<std::size_t> repair(std::size_t first, std::size_t last, std::string region,
+		std::vector<symbol>& changed);
+	void rebuild_all(std::string text);
+	/* the variables defined before segment `first` that `tokens` mention,
+	 * which are all the parser can look up */
+	parser::symbol_table symbols_before(std::size_t first, const token_array& tokens) const;
+	void add_names(const segment_node* item);
+	void remove_names(const segment_node* item);
+
+	/* weighted by the segments' sizes, so the segments an edit touches,
+	 * and the offset where each starts, are found without walking the
+	 * others. the last segment holds the text after the last statement and
+	 * has no node */
+	sequence_tree<segment> _segments;
+	/* the segment defining each variable, and the segments mentioning each
+	 * identifier */
+	std::unordered_map<symbol, const segment_node*> _definitions;
+	std::unordered_map<symbol, std::unordered_set<const segment_node*>> _mentions;
+	/* segments still to re-parse because a name they mention changed, in
+	 * the order of the text. an edit never reorders the segments it keeps,
+	 * so comparing positions is a strict order for as long as they stay */
+	struct by_position {
+		const sequence_tree<segment>* segments;
+		bool operator()(const segment_node* lhs, const segment_node* rhs) const {
+			return segments->locate(lhs).index < segments->locate(rhs).index;
+		}
+	};
+	std::set<const segment_node*, by_position> _pending { by_position { &_segments } };
+	/* set when a statement made no progress; parse gives up there, so the
+	 * document does the same and re-parses everything on every edit */
+	std::unique_ptr<syntax_tree> _failed_tree;
+	std::shared_ptr<const std::string> _failed_text;
+	edit_stats _stats;
+};
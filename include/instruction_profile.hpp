@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "asm.hpp"
+
+
+/* counts the sequences of two and three instructions a program executes,
+ * by shape: the instruction with the kind of its operand, such as
+ * "push var", but not the operand itself. the superinstructions are the
+ * sequences that come out on top over the benchmark corpus. */
+class instruction_profile {
+public:
+	/* runs the global code of `con` as main does, counting as it goes */
+	void execute(asm_context& con);
+
+	/* the `count` most frequent sequences of `length` instructions, most
+	 * frequent first */
+	std::vector<std::pair<std::string, std::size_t>> top(std::size_t length, std::size_t count) const;
+	std::size_t executed() const;
+
+	static std::string_view shape(const instruct& inst);
+
+private:
+	std::map<std::string, std::size_t> _pairs;
+	std::map<std::string, std::size_t> _triples;
+	std::size_t _executed { 0 };
+};
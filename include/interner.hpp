@@ -0,0 +1,160 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string_view>
+#include <vector>
+
+
+/* dense id of an interned identifier. no_symbol is never handed out, so a
+ * zero-initialized token or instruction does not name anything. */
+using symbol = std::uint32_t;
+static inline constexpr symbol no_symbol = 0;
+
+/* maps every distinct identifier of the process to a symbol once, so later
+ * phases compare and index names as integers. the lexer may run on several
+ * threads, so interning is guarded by a reader-writer lock. name() takes no
+ * lock: the name of an id is written before the id is handed out and is
+ * never moved afterwards.
+ * nothing is ever freed: every name interned, including each partial
+ * identifier typed into a document, stays resident until the process
+ * exits. tables indexed by symbol should be sized by their entries, as
+ * symbol_map is, and not by size(). */
+class interner {
+public:
+	static interner* get_instance() {
+		static interner instance;
+		return &instance;
+	}
+
+	interner();
+
+	interner(const interner&) = delete;
+	interner& operator=(const interner&) = delete;
+
+	symbol intern(std::string_view name);
+	/* the text of `id`, valid for the lifetime of the process */
+	std::string_view name(symbol id) const;
+	/* number of symbols handed out, plus one for no_symbol */
+	std::size_t size() const;
+
+private:
+	/* open addressing slot. the hash is kept next to the id so a probe only
+	 * touches the name of a slot whose hash already matches. */
+	struct slot {
+		std::uint64_t hash;
+		symbol id;
+	};
+
+	symbol intern_locked(std::string_view name, std::uint64_t hash);
+	symbol find(std::string_view name, std::uint64_t hash) const;
+	std::string_view store(std::string_view name);
+	void grow();
+
+	/* the views of symbols live in pages that double in size, so page k holds
+	 * ids [first_page_size * (2^k - 1), first_page_size * (2^(k+1) - 1)) and
+	 * a page is never reallocated once created */
+	static constexpr std::size_t first_page_size = 1024;
+	static constexpr std::size_t max_pages = 23;
+
+	std::string_view& name_at(symbol id);
+	const std::string_view& name_at(symbol id) const;
+
+	/* names live in fixed blocks that are never freed or moved */
+	std::vector<std::unique_ptr<char[]>> _blocks;
+	std::size_t _block_used;
+	std::unique_ptr<std::string_view[]> _pages[max_pages];
+	std::size_t _name_count;
+	std::vector<slot> _slots;
+	mutable std::shared_mutex _mutex;
+};
+
+/* table from symbol to T. symbols are shared by the whole process, so a
+ * table that holds a few of them is open addressing on the id rather than an
+ * array indexed by it, and its size follows its entries instead of the
+ * number of symbols ever interned. */
+template <class T>
+class symbol_map {
+public:
+	T* find(symbol id) {
+		if (_slots.empty()) {
+			return nullptr;
+		}
+		entry& item = _slots[probe(id)];
+		return item.value ? &*item.value : nullptr;
+	}
+	const T* find(symbol id) const {
+		if (_slots.empty()) {
+			return nullptr;
+		}
+		const entry& item = _slots[probe(id)];
+		return item.value ? &*item.value : nullptr;
+	}
+	bool contains(symbol id) const {
+		return find(id) != nullptr;
+	}
+	/* returns false and leaves the table as it is when `id` is present */
+	bool insert(symbol id, T value) {
+		if ((_count + 1) * 4 > _slots.size() * 3) {
+			grow();
+		}
+		entry& item = _slots[probe(id)];
+		if (item.value) {
+			return false;
+		}
+		item.id = id;
+		item.value.emplace(std::move(value));
+		++_count;
+		return true;
+	}
+	std::size_t size() const {
+		return _count;
+	}
+	/* calls func(id, value) for every entry, in symbol order */
+	template <class Func>
+	void for_each(Func func) {
+		std::vector<entry*> entries;
+		entries.reserve(_count);
+		for (entry& item : _slots) {
+			if (item.value) {
+				entries.push_back(&item);
+			}
+		}
+		std::sort(entries.begin(), entries.end(), [](const entry* lhs, const entry* rhs) { return lhs->id < rhs->id; });
+		for (entry* item : entries) {
+			func(item->id, *item->value);
+		}
+	}
+
+private:
+	/* a slot is empty while it has no value; no_symbol is a key like any
+	 * other */
+	struct entry {
+		symbol id { no_symbol };
+		std::optional<T> value;
+	};
+
+	/* the slot that holds `id`, or the empty one where it would go */
+	std::size_t probe(symbol id) const {
+		std::size_t mask = _slots.size() - 1;
+		std::size_t index = (id * 0x9e3779b9u) & mask;
+		while (_slots[index].value && _slots[index].id != id) {
+			index = (index + 1) & mask;
+		}
+		return index;
+	}
+	void grow() {
+		std::vector<entry> old = std::move(_slots);
+		_slots = std::vector<entry>(old.empty() ? 8 : old.size() * 2);
+		for (entry& item : old) {
+			if (item.value) {
+				_slots[probe(item.id)] = std::move(item);
+			}
+		}
+	}
+
+	std::vector<entry> _slots;
+	std::size_t _count { 0 };
+};
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include "asm.hpp"
+#include "bytecode.hpp"
+#include "value.hpp"
+
+
+/* runs bytecode. dispatch goes through a table of label addresses where
+ * the compiler supports computed goto, and through a switch elsewhere.
+ * the operand stack and the frame are allocated once, when the
+ * interpreter is made, from the sizes the bytecode records, so running a
+ * program does not touch the heap. every instruction checks the tags of
+ * its operands and the bounds of the stack and of the frame, and aborts
+ * when they are not what it expects, unless verifier has proven the
+ * program, in which case it runs without any of the checks. the one check
+ * left is on the divisor of an integer division that is not an
+ * immediate, which the verifier cannot know.
+ *
+ * the interpreter runs its own copy of the code, which it quickens: a
+ * cast the first time it runs rewrites its opcode into the one for the
+ * type it found, which only checks that type again, and is rewritten into
+ * a form that takes any type when that check fails. so later runs of the
+ * same interpreter take the specialized path. */
+class interpreter {
+public:
+	/* whether the program is verified is taken now: verifying it after
+	 * does not make this interpreter run it unchecked */
+	explicit interpreter(const bytecode& program);
+
+	interpreter(const interpreter&) = delete;
+	interpreter& operator=(const interpreter&) = delete;
+
+	/* runs the program until it returns or aborts and returns the values
+	 * left on the stack, bottom first. they stay valid until the next run.
+	 * `arguments` go into the first slots of the frame, as they do for the
+	 * body of a function. code that was verified when the interpreter was
+	 * made runs unchecked when the arguments have the types it was
+	 * verified for. */
+	std::span<const value> run(std::span<const value> arguments = {});
+
+	/* instructions rewritten into a specialized form, and specialized ones
+	 * rewritten back because their type changed, over every run so far */
+	std::size_t quickened() const;
+	std::size_t deoptimized() const;
+	/* the code as it is now, quickened instructions included */
+	std::string disassemble() const;
+
+	/* makes an interpreter, runs `program` once and converts what it
+	 * leaves on the stack */
+	static std::vector<OBJECT> evaluate(const bytecode& program);
+
+private:
+	template <bool checked>
+	std::span<const value> execute(std::span<const value> arguments);
+
+	const bytecode& _program;
+	const bool _is_verified;
+	const std::vector<value::tag> _argument_types;
+	std::vector<std::uint8_t> _code;
+	std::size_t _quickened { 0 };
+	std::size_t _deoptimized { 0 };
+	std::unique_ptr<value[]> _stack;
+	std::unique_ptr<value[]> _frame;
+};
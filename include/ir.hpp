@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <string>
+#include <vector>
+#include "asm.hpp"
+#include "interner.hpp"
+#include "types.hpp"
+
+
+/* the SSA form code goes through between the AST and the instructions.
+ * every instruction defines at most one value, named by its index in the
+ * function, and a value never changes once defined: a variable is
+ * renamed to a new value at each assignment instead. */
+enum class ir_opcode : std::uint8_t {
+	constant,
+	/* the argument in slot `index` */
+	argument,
+	/* the value of lhs given to the variable `name` */
+	copy,
+	/* lhs converted to `type`, as cast_instruct does */
+	cast,
+	add,
+	sub,
+	mul,
+	div,
+	/* terminators end their block */
+	ret,
+	abort,
+};
+
+using ir_value = std::uint32_t;
+static inline constexpr ir_value no_value = ~ir_value(0);
+
+struct ir_instruction {
+	ir_opcode op;
+	/* type of the value, none for terminators and for poison: a constant
+	 * of type none stands for what an erroneous node would compute */
+	object_type type { object_type::none };
+	ir_value lhs { no_value };
+	ir_value rhs { no_value };
+	/* constant: the value, argument: the slot in `index` */
+	OBJECT constant;
+	std::uint32_t index { 0 };
+	/* the variable the value belongs to, for the listing */
+	symbol name { no_symbol };
+};
+
+struct ir_block {
+	/* values in execution order */
+	std::vector<ir_value> instructions;
+};
+
+/* one function, or the global code. values live in `values` for as long
+ * as the function does; a pass that drops an instruction only takes it out
+ * of its block. */
+struct ir_function {
+	/* the mangled name, empty for the global code */
+	std::string name;
+	std::list<variable> arguments;
+	std::vector<ir_instruction> values;
+	std::vector<ir_block> blocks;
+
+	ir_value add(const ir_instruction& instruction);
+	/* a block for the instructions after a terminator */
+	void start_block();
+	bool is_terminated() const;
+
+	std::string dump() const;
+};
+
+bool is_terminator(ir_opcode op);
+std::string to_string(ir_opcode op);
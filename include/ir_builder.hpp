@@ -0,0 +1,34 @@
+#pragma once
+#include <vector>
+#include "ast.hpp"
+#include "ir.hpp"
+
+
+/* translates a type checked tree to SSA form. variables are renamed to the
+ * value they hold, so the IR has no loads or stores, and a terminator
+ * starts a new block, which leaves code after `return` unreachable. */
+class ir_builder {
+public:
+	/* the global code first, then the functions defined at the top level.
+	 * a function nested in a body is only visible to that body, which
+	 * cannot call it, so it is left out. */
+	static std::vector<ir_function> build(const syntax_tree& tree, node_id root);
+
+private:
+	struct context {
+		const syntax_tree& tree;
+		ir_function& function;
+		/* the current value of each frame slot */
+		std::vector<ir_value> variables;
+	};
+
+	static void build_statements(context& con, node_id block, std::vector<node_id>* functions);
+	static void build_function(context& con, node_id id);
+	static ir_value build_expression(context& con, node_id id);
+
+	static ir_value poison(context& con);
+	static bool is_poison(context& con, ir_value value);
+	/* `value` converted to `to`, unless it already is */
+	static ir_value convert(context& con, ir_value value, object_type to);
+	static void set_variable(context& con, slot_index slot, ir_value value);
+};
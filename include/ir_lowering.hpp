@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <vector>
+#include "asm.hpp"
+#include "ir.hpp"
+
+
+/* turns SSA form back into stack instructions. a value used once is
+ * computed where it is used; one used more often is computed once into a
+ * frame slot of its own, which is the only place an alloc comes from. */
+class ir_lowering {
+public:
+	/* the global code goes to con.codes and the functions to con.functions */
+	static void lower(const std::vector<ir_function>& functions, asm_context& con);
+	/* `frame_size` is set to the slots the instructions use */
+	static std::list<std::unique_ptr<instruct>> lower(const ir_function& function, std::uint32_t& frame_size);
+
+private:
+	struct context {
+		const ir_function& function;
+		std::list<std::unique_ptr<instruct>> codes;
+		/* how many instructions in a block read each value */
+		std::vector<std::uint32_t> uses;
+		/* where each value that was computed ahead of its uses is kept */
+		std::vector<slot_index> slots;
+		slot_index next_slot { 0 };
+	};
+
+	/* pushes `value`, computing whatever it needs that is not in a slot */
+	static void emit(context& con, ir_value value);
+	static void emit_operation(context& con, const ir_instruction& inst);
+	static symbol name_of(context& con, ir_value value);
+};
@@ -0,0 +1,26 @@
+#pragma once
+#include "ir.hpp"
+
+
+/* whole-function passes over the SSA form. each keeps the function valid,
+ * so they can run in any order; run() applies them in the order that lets
+ * each one clean up after the one before. */
+class ir_optimizer {
+public:
+	static void run(ir_function& function);
+
+	/* uses of a copy read the copied value instead. the variable's name
+	 * moves to that value when it has none. */
+	static void propagate_copies(ir_function& function);
+	/* a computation that repeats an earlier one in the same function is
+	 * replaced by the earlier result */
+	static void eliminate_common_subexpressions(ir_function& function);
+	/* drops the blocks no path reaches, such as the code after a return,
+	 * and the instructions whose value nothing uses. a variable that is
+	 * never read leaves nothing behind, so no slot is allocated for it. */
+	static void eliminate_dead_code(ir_function& function);
+
+private:
+	/* rewrites the operands of every instruction through `replacement` */
+	static void replace_uses(ir_function& function, const std::vector<ir_value>& replacement);
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+
+/* zero-based line and column of a source offset. the column counts code
+ * points, so a multi-byte character moves it by one. */
+struct source_location {
+	std::uint32_t line;
+	std::uint32_t col;
+};
+
+/* start offset of every line of a source, so that a token's offset can be
+ * turned back into a line and column with a binary search. the source may
+ * be appended in several parts; they are treated as one contiguous text.
+ * the table keeps views of the parts, so they must outlive it. */
+class line_table {
+public:
+	line_table();
+	line_table(std::string_view source);
+
+	void append(std::string_view text);
+
+	source_location locate(std::uint32_t offset) const;
+	std::size_t line_count() const;
+	/* total number of bytes appended so far */
+	std::uint32_t size() const;
+
+private:
+	std::vector<std::uint32_t> _line_starts;
+	std::vector<std::string_view> _parts;
+	/* offset of the first byte of every part */
+	std::vector<std::uint32_t> _part_starts;
+	std::uint32_t _size;
+};
@@ -1,167 +1,64 @@
 #pragma once
-#include <memory>
 #include "tokenize.hpp"
+#include "token_stream.hpp"
+#include "ast.hpp"
 #include "asm.hpp"
 #include "types.hpp"
 
 
-class ast_base_node {
-public:
-	virtual ~ast_base_node() = default;
-	virtual std::string log(const std::string& prefix) const = 0;
-	virtual void encode(asm_context& con) const = 0;
-	virtual object_type type() const = 0;
-	virtual ast_base_node* static_class() const = 0;
-};
-
-class ast_error_node : public ast_base_node {
-public:
-	~ast_error_node() = default;
-	std::string log(const std::string& prefix) const override;
-	void encode(asm_context& con) const override;
-	object_type type() const override;
-	ast_base_node* static_class() const override;
-
-public:
-	std::string message;
-	std::unique_ptr<ast_base_node> child;
-};
-
-class ast_value_node : public ast_base_node {
-public:
-	~ast_value_node() = default;
-	std::string log(const std::string& prefix) const override;
-	void encode(asm_context& con) const override;
-	object_type type() const override;
-	ast_base_node* static_class() const override;
-
-public:
-	token value;
-	object_type var_type;
-};
-
-class ast_parenthess_node : public ast_base_node {
-public:
-	~ast_parenthess_node() = default;
-	std::string log(const std::string& prefix) const override;
-	void encode(asm_context& con) const override;
-	object_type type() const override;
-	ast_base_node* static_class() const override;
-
-public:
-	std::unique_ptr<ast_base_node> expr;
-};
-
-class ast_bin_op_node : public ast_base_node {
-public:
-	~ast_bin_op_node() = default;
-	std::string log(const std::string& prefix) const override;
-	void encode(asm_context& con) const override;
-	object_type type() const override;
-	ast_base_node* static_class() const override;
-
-public:
-	token op;
-	std::unique_ptr<ast_base_node> lhs;
-	std::unique_ptr<ast_base_node> rhs;
-};
-
-class ast_expr_node : public ast_base_node {
-public:
-	~ast_expr_node() = default;
-	std::string log(const std::string& prefix) const override;
-	void encode(asm_context& con) const override;
-	object_type type() const override;
-	ast_base_node* static_class() const override;
-
-public:
-	std::unique_ptr<ast_base_node> expr;
-};
-
-class ast_var_define_node : public ast_base_node {
-public:
-	~ast_var_define_node() = default;
-	std::string log(const std::string& prefix) const override;
-	void encode(asm_context& con) const override;
-	object_type type() const override;
-	ast_base_node* static_class() const override;
-
-public:
-	token modifier;
-	token var_type;
-	token name;
-	std::unique_ptr<ast_base_node> initial_value;
-};
-
-class ast_return_node : public ast_base_node {
-public:
-	~ast_return_node() = default;
-	std::string log(const std::string& prefix) const override;
-	void encode(asm_context& con) const override;
-	object_type type() const override;
-	ast_base_node* static_class() const override;
-
-public:
-	std::unique_ptr<ast_base_node> expr;
-};
-
-class ast_block_node : public ast_base_node {
-public:
-	~ast_block_node() = default;
-	std::string log(const std::string& prefix) const override;
-	void encode(asm_context& con) const override;
-	object_type type() const override;
-	ast_base_node* static_class() const override;
-
-public:
-	std::vector<std::unique_ptr<ast_base_node>> nodes;
-	std::string block_name;
-};
-
-class ast_function_node : public ast_base_node {
+class parser {
 public:
-	using token_node = std::variant<token, std::unique_ptr<ast_error_node>>;
-	struct token_node_str_visit {
-		std::string operator()(const token& tok) { return tok.str; }
-		std::string operator()(const auto&) { return "error"; }
+	/* variables visible to the statements that follow. `defined` lists the
+	 * names in definition order so a caller can tell what a statement added. */
+	struct symbol_table {
+		symbol_map<variable> variables;
+		std::vector<symbol> defined;
 	};
-public:
-	~ast_function_node() = default;
-	std::string log(const std::string& prefix) const override;
-	void encode(asm_context& con) const override;
-	object_type type() const override;
-	ast_base_node* static_class() const override;
 
-	std::string get_mangling_name() const;
-
-public:
-	std::unique_ptr<ast_base_node> block;
-	token_node name;
-	struct {
-		token_node modifier;
-		token_node var_type;
-	} return_type;
-	std::vector<std::unique_ptr<ast_base_node>> arguments;
-	std::vector<std::unique_ptr<ast_base_node>> error_list;
-};
+	/* binding power of a binary operator, weakest first */
+	enum class precedence : std::uint8_t {
+		none,
+		assignment,
+		additive,
+		multiplicative,
+	};
+	enum class associativity : std::uint8_t {
+		left,
+		right,
+	};
+	struct operator_info {
+		precedence power;
+		associativity assoc;
+	};
 
-class parser {
 private:
 	struct context {
-		std::vector<token>::const_iterator itr;
+		token_stream::iterator itr;
 
-		std::map<std::string, variable> variables;
+		symbol_table& symbols;
+		syntax_tree& tree;
 	};
 private:
-	static std::unique_ptr<ast_base_node> try_parse_parenthess(context& con);
-	static std::unique_ptr<ast_base_node> try_parse_value(context& con);
-	static std::unique_ptr<ast_base_node> try_parse_mul_div(context& con);
-	static std::unique_ptr<ast_base_node> try_parse_add_sub(context& con);
-	static std::unique_ptr<ast_base_node> try_parse_assign(context& con);
-	static std::unique_ptr<ast_base_node> try_parse_return(context& con);
-	static std::unique_ptr<ast_base_node> try_parse_stmt(context& con);
-	static std::unique_ptr<ast_base_node> try_parse_var_define(context& con);
-	static std::unique_ptr<ast_base_node> try_parse_function_define(context& con);
-public:
-	static std::unique_ptr<ast_base_node> parse(const std::vector<token>& tokens);
+	/* `message` is not copied, so text built at run time has to be stored
+	 * in the tree first */
+	static node_id make_error(context& con, std::string_view message, node_id child = no_node);
+	static node_id try_parse_value(context& con);
+	/* binary operators that bind at least as tightly as `min_power`, and
+	 * parentheses, climbing operator_table on explicit stacks */
+	static node_id try_parse_expression(context& con, precedence min_power);
+	static node_id make_bin_op(context& con, token_type op, std::uint32_t offset, node_id lhs, node_id rhs);
+	static node_id try_parse_return(context& con);
+	static node_id try_parse_stmt(context& con);
+	/* one statement, or the head of a function up to its `{`, in which case
+	 * `block` is set and the caller parses the body into it */
+	static node_id try_parse_single_stmt(context& con, node_id& block);
+	static node_id try_parse_var_define(context& con);
+	static node_id try_parse_function_define(context& con, node_id& block);
+public:
+	/* parses one top-level statement at `itr` into `tree` and moves `itr`
+	 * past it */
+	static node_id parse_statement(token_stream::iterator& itr, symbol_table& symbols, syntax_tree& tree);
+	/* parses the whole stream into `tree` and makes the result its root */
+	static node_id parse(token_stream& tokens, syntax_tree& tree);
+	static node_id parse(const token_array& tokens, syntax_tree& tree);
 };
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "asm.hpp"
+
+
+/* rewrites short runs of encoded instructions into cheaper ones. each rule
+ * looks at an instruction and what produced the values it reads, found by
+ * walking back at most `window` instructions, and the rules are applied
+ * until none of them matches. return and abort end every window, so code
+ * is never moved across them. */
+class peephole_optimizer {
+public:
+	enum class rule : std::uint8_t {
+		/* a value that is pushed or computed only to be popped */
+		push_pop,
+		/* a cast to the type the value already has */
+		identity_cast,
+		/* a cast of a literal, done ahead of time */
+		cast_literal,
+		/* a store that is overwritten before anything reads it, such as
+		 * the first of two moves to the same variable */
+		adjacent_moves,
+	};
+	static inline constexpr std::size_t rule_count = 4;
+
+	struct report {
+		/* instructions each rule took out, net of any it put in */
+		std::array<std::size_t, rule_count> removed {};
+
+		std::size_t total() const;
+		std::string log(const std::string& prefix) const;
+		report& operator+=(const report& other);
+	};
+
+	/* every rule enabled */
+	peephole_optimizer(std::size_t window = 8);
+
+	void enable(rule which, bool enabled);
+	bool is_enabled(rule which) const;
+
+	report run(std::list<std::unique_ptr<instruct>>& codes) const;
+	/* the global code and the body of every function */
+	report run(asm_context& con) const;
+
+	static std::string_view name(rule which);
+
+private:
+	using iterator = std::list<std::unique_ptr<instruct>>::iterator;
+
+	/* the instruction that pushed the value `depth` places below the top
+	 * of the stack as it is just before `at`, or end when the window runs
+	 * out first */
+	iterator producer(std::list<std::unique_ptr<instruct>>& codes, iterator at, std::size_t depth) const;
+	/* the type the value pushed by `inst` has, none if it is not known.
+	 * `slot_types` holds the type of the latest alloc of each slot. */
+	static object_type result_type(const instruct& inst, const std::vector<object_type>& slot_types);
+
+	/* each returns whether it changed the code. `at` is left on the
+	 * instruction to look at next */
+	bool remove_push_pop(std::list<std::unique_ptr<instruct>>& codes, iterator& at, report& result) const;
+	bool remove_identity_cast(std::list<std::unique_ptr<instruct>>& codes, iterator& at,
+		const std::vector<object_type>& slot_types, report& result) const;
+	bool fold_cast_literal(std::list<std::unique_ptr<instruct>>& codes, iterator& at, report& result) const;
+	bool merge_adjacent_moves(std::list<std::unique_ptr<instruct>>& codes, iterator& at, report& result) const;
+
+	std::size_t _window;
+	std::array<bool, rule_count> _enabled;
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ir.hpp"
+#include "value.hpp"
+
+
+/* three-address opcodes over registers. an instruction names the
+ * registers it reads and the one it writes, so an operation costs one
+ * dispatch however its operands were computed. */
+#define REGISTER_OPCODES(X) \
+	X(add) \
+	X(sub) \
+	X(mul) \
+	X(div) \
+	X(addf) \
+	X(subf) \
+	X(mulf) \
+	X(divf) \
+	X(cast_int) \
+	X(cast_float) \
+	X(ret) \
+	X(abort)
+
+enum class register_opcode : std::uint8_t {
+#define REGISTER_ENUM(name) name,
+	REGISTER_OPCODES(REGISTER_ENUM)
+#undef REGISTER_ENUM
+};
+
+/* a = b op c. a cast reads b, ret reads a */
+struct register_instruction {
+	register_opcode op;
+	std::uint32_t a { 0 };
+	std::uint32_t b { 0 };
+	std::uint32_t c { 0 };
+};
+
+/* one function compiled for register_machine. the registers are laid out
+ * as the arguments, then the constants, which are loaded before the code
+ * runs, then the temporaries, which are reused once their value is dead. */
+class register_code {
+public:
+	/* expects the SSA form to have been through ir_optimizer, though any
+	 * valid function compiles */
+	static register_code compile(const ir_function& function);
+
+	const std::vector<register_instruction>& instructions() const;
+	const std::vector<value>& constants() const;
+	/* the first constant register */
+	std::uint32_t constant_base() const;
+	/* registers in all */
+	std::uint32_t register_count() const;
+
+	/* the constants as "rN = value", then one line per instruction */
+	std::string disassemble() const;
+	static std::string_view name(register_opcode op);
+
+private:
+	std::vector<register_instruction> _instructions;
+	std::vector<value> _constants;
+	std::uint32_t _constant_base { 0 };
+	std::uint32_t _register_count { 0 };
+};
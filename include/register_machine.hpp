@@ -0,0 +1,30 @@
+#pragma once
+#include <memory>
+#include <optional>
+#include <vector>
+#include "asm.hpp"
+#include "register_code.hpp"
+#include "value.hpp"
+
+
+/* runs register_code. like interpreter, it allocates its register file
+ * once, dispatches through computed goto where it can and checks the tag
+ * of every operand it reads, and the divisor of every integer division. */
+class register_machine {
+public:
+	explicit register_machine(const register_code& code);
+
+	register_machine(const register_machine&) = delete;
+	register_machine& operator=(const register_machine&) = delete;
+
+	/* the value returned, none when the code aborts */
+	std::optional<value> run();
+
+	/* runs `code` once. the result has the returned value, or nothing
+	 * when the code aborts, like the stack interpreter's */
+	static std::vector<OBJECT> evaluate(const register_code& code);
+
+private:
+	const register_code& _code;
+	std::unique_ptr<value[]> _registers;
+};
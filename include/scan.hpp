@@ -0,0 +1,141 @@
+#pragma once
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SCAN_SSE2 1
+#include <emmintrin.h>
+#endif
+
+
+enum class scan_mode {
+	scalar,
+	sse2,
+	avx2,
+};
+
+/* the lexer's runs of spaces, identifier bytes and digits. each stops at
+ * the first byte outside its class and never reads at or past `end`. they
+ * are inlined into the lexer: a run is a few bytes long, so a call through
+ * a kernel pointer would cost more than the scan. */
+inline const char* scalar_skip_space(const char* p, const char* end) {
+	while (p < end && (*p == ' ' || (*p >= '\t' && *p <= '\r'))) {
+		++p;
+	}
+	return p;
+}
+inline const char* scalar_skip_identifier(const char* p, const char* end) {
+	while (p < end && (static_cast<unsigned char>(*p - '0') <= 9 ||
+		static_cast<unsigned char>((*p | 0x20) - 'a') <= 25 || *p == '_'))
+	{
+		++p;
+	}
+	return p;
+}
+inline const char* scalar_skip_digits(const char* p, const char* end) {
+	while (p < end && static_cast<unsigned char>(*p - '0') <= 9) {
+		++p;
+	}
+	return p;
+}
+
+#ifdef SCAN_SSE2
+/* the same runs 16 bytes at a time. SSE2 is part of x86-64, so these need
+ * no dispatch and inline like the scalar loops. the signed compares see
+ * bytes from 0x80 up as negative, outside every ASCII range. */
+inline __m128i sse2_in_range(__m128i v, char lo, char hi) {
+	return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+}
+/* the index of the first byte whose bit in `in_class` is clear, or 16
+ * when all of them are set */
+inline int sse2_run_length(__m128i in_class) {
+	unsigned int outside = ~static_cast<unsigned int>(_mm_movemask_epi8(in_class)) & 0xffff;
+	return outside ? std::countr_zero(outside) : 16;
+}
+inline const char* sse2_skip_space(const char* p, const char* end) {
+	/* most tokens follow another with no space between them */
+	if (p < end && *p != ' ' && (*p < '\t' || *p > '\r')) {
+		return p;
+	}
+	while (end - p >= 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		int length = sse2_run_length(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), sse2_in_range(v, '\t', '\r')));
+		p += length;
+		if (length < 16) {
+			return p;
+		}
+	}
+	return scalar_skip_space(p, end);
+}
+inline const char* sse2_skip_identifier(const char* p, const char* end) {
+	while (end - p >= 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		__m128i letter = sse2_in_range(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+		__m128i digit = sse2_in_range(v, '0', '9');
+		__m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+		int length = sse2_run_length(_mm_or_si128(_mm_or_si128(letter, digit), underscore));
+		p += length;
+		if (length < 16) {
+			return p;
+		}
+	}
+	return scalar_skip_identifier(p, end);
+}
+inline const char* sse2_skip_digits(const char* p, const char* end) {
+	while (end - p >= 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		int length = sse2_run_length(sse2_in_range(v, '0', '9'));
+		p += length;
+		if (length < 16) {
+			return p;
+		}
+	}
+	return scalar_skip_digits(p, end);
+}
+#endif
+
+/* the vector loops where there are any and `vector` is set. a lexer sets
+ * it when it is made in any mode but scalar; runs are too short for AVX2
+ * to gain over SSE2. */
+inline const char* skip_space(const char* p, const char* end, bool vector) {
+#ifdef SCAN_SSE2
+	if (vector) {
+		return sse2_skip_space(p, end);
+	}
+#endif
+	return scalar_skip_space(p, end);
+}
+inline const char* skip_identifier(const char* p, const char* end, bool vector) {
+#ifdef SCAN_SSE2
+	if (vector) {
+		return sse2_skip_identifier(p, end);
+	}
+#endif
+	return scalar_skip_identifier(p, end);
+}
+inline const char* skip_digits(const char* p, const char* end, bool vector) {
+#ifdef SCAN_SSE2
+	if (vector) {
+		return sse2_skip_digits(p, end);
+	}
+#endif
+	return scalar_skip_digits(p, end);
+}
+
+/* kernels that run over a whole block at once, where vectors pay off.
+ * the vector kernels fall back to the scalar loop for the last partial
+ * block, so `end` only has to be the real end of the buffer. */
+struct scan_kernels {
+	/* first byte of the first ill-formed UTF-8 sequence, or `end` when the
+	 * whole range is well-formed */
+	const char* (*validate_utf8)(const char* p, const char* end);
+};
+
+/* kernels for the best mode the running CPU supports, chosen on first use */
+const scan_kernels& get_scan_kernels();
+
+scan_mode get_scan_mode();
+/* returns false if the CPU does not support `mode` */
+bool set_scan_mode(scan_mode mode);
+bool is_scan_mode_supported(scan_mode mode);
+
+const char* to_string(scan_mode mode);
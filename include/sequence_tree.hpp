@@ -0,0 +1,209 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+/* a sequence of items, each with a weight, kept as a treap ordered by
+ * position. finding the item that covers a weight offset, the position
+ * and offset of an item, and replacing a run of items take time
+ * logarithmic in the length of the sequence, plus the length of the run.
+ * an item stays at the same address for as long as it is in the sequence,
+ * so a pointer to its node identifies it until it is replaced. */
+template <class T>
+class sequence_tree {
+public:
+	class node {
+	public:
+		node(T item, std::size_t weight, std::uint32_t priority) :
+			value(std::move(item)), _weight(weight), _total(weight), _priority(priority)
+		{}
+
+		T value;
+
+	private:
+		friend class sequence_tree;
+
+		std::size_t _weight;
+		/* of the subtree */
+		std::size_t _total;
+		std::size_t _count { 1 };
+		std::uint32_t _priority;
+		node* _parent { nullptr };
+		std::unique_ptr<node> _left;
+		std::unique_ptr<node> _right;
+	};
+
+	struct location {
+		const node* item;
+		std::size_t index;
+		/* weight of the items before it */
+		std::size_t start;
+	};
+
+	/* number of items */
+	std::size_t size() const {
+		return _root ? _root->_count : 0;
+	}
+	/* weight of all the items */
+	std::size_t weight() const {
+		return _root ? _root->_total : 0;
+	}
+	void clear() {
+		_root.reset();
+	}
+
+	const node* at(std::size_t index) const {
+		const node* current = _root.get();
+		for (;;) {
+			std::size_t left = count(current->_left);
+			if (index < left) {
+				current = current->_left.get();
+			} else if (index == left) {
+				return current;
+			} else {
+				index -= left + 1;
+				current = current->_right.get();
+			}
+		}
+	}
+	/* the item whose weight covers `offset`, or the last item when the
+	 * offset is past the end. the sequence must not be empty */
+	location find(std::size_t offset) const {
+		if (offset >= weight()) {
+			const node* last = at(size() - 1);
+			return location { last, size() - 1, weight() - last->_weight };
+		}
+		const node* current = _root.get();
+		std::size_t index = 0;
+		std::size_t start = 0;
+		for (;;) {
+			std::size_t left = total(current->_left);
+			if (offset < left) {
+				current = current->_left.get();
+				continue;
+			}
+			offset -= left;
+			index += count(current->_left);
+			start += left;
+			if (offset < current->_weight) {
+				return location { current, index, start };
+			}
+			offset -= current->_weight;
+			index += 1;
+			start += current->_weight;
+			current = current->_right.get();
+		}
+	}
+	location locate(const node* item) const {
+		std::size_t index = count(item->_left);
+		std::size_t start = total(item->_left);
+		for (const node* child = item; child->_parent; child = child->_parent) {
+			const node* parent = child->_parent;
+			if (parent->_right.get() == child) {
+				index += count(parent->_left) + 1;
+				start += total(parent->_left) + parent->_weight;
+			}
+		}
+		return location { item, index, start };
+	}
+
+	/* replaces items [first, last) with `items`, given with their weights */
+	void replace(std::size_t first, std::size_t last, std::vector<std::pair<T, std::size_t>> items) {
+		auto [before, rest] = split(std::move(_root), first);
+		auto [removed, after] = split(std::move(rest), last - first);
+		removed.reset();
+		std::unique_ptr<node> middle;
+		for (std::pair<T, std::size_t>& item : items) {
+			middle = merge(std::move(middle), std::make_unique<node>(std::move(item.first), item.second, next_priority()));
+		}
+		_root = merge(merge(std::move(before), std::move(middle)), std::move(after));
+		if (_root) {
+			_root->_parent = nullptr;
+		}
+	}
+
+	/* calls func(value) for every item in order */
+	template <class Func>
+	void for_each(Func func) const {
+		visit(_root.get(), func);
+	}
+
+private:
+	static std::size_t count(const std::unique_ptr<node>& item) {
+		return item ? item->_count : 0;
+	}
+	static std::size_t total(const std::unique_ptr<node>& item) {
+		return item ? item->_total : 0;
+	}
+	static void update(node& item) {
+		item._count = 1 + count(item._left) + count(item._right);
+		item._total = item._weight + total(item._left) + total(item._right);
+		if (item._left) {
+			item._left->_parent = &item;
+		}
+		if (item._right) {
+			item._right->_parent = &item;
+		}
+	}
+	/* the first `index` items, and the others */
+	static std::pair<std::unique_ptr<node>, std::unique_ptr<node>> split(std::unique_ptr<node> item, std::size_t index) {
+		if (!item) {
+			return {};
+		}
+		std::size_t left = count(item->_left);
+		if (index <= left) {
+			auto [lhs, rhs] = split(std::move(item->_left), index);
+			item->_left = std::move(rhs);
+			update(*item);
+			if (lhs) {
+				lhs->_parent = nullptr;
+			}
+			return { std::move(lhs), std::move(item) };
+		}
+		auto [lhs, rhs] = split(std::move(item->_right), index - left - 1);
+		item->_right = std::move(lhs);
+		update(*item);
+		if (rhs) {
+			rhs->_parent = nullptr;
+		}
+		return { std::move(item), std::move(rhs) };
+	}
+	static std::unique_ptr<node> merge(std::unique_ptr<node> lhs, std::unique_ptr<node> rhs) {
+		if (!lhs) {
+			return rhs;
+		}
+		if (!rhs) {
+			return lhs;
+		}
+		if (lhs->_priority > rhs->_priority) {
+			lhs->_right = merge(std::move(lhs->_right), std::move(rhs));
+			update(*lhs);
+			return lhs;
+		}
+		rhs->_left = merge(std::move(lhs), std::move(rhs->_left));
+		update(*rhs);
+		return rhs;
+	}
+	template <class Func>
+	static void visit(const node* item, Func& func) {
+		if (!item) {
+			return;
+		}
+		visit(item->_left.get(), func);
+		func(item->value);
+		visit(item->_right.get(), func);
+	}
+	std::uint32_t next_priority() {
+		/* xorshift; any sequence that is not sorted keeps the tree shallow */
+		_seed ^= _seed << 13;
+		_seed ^= _seed >> 17;
+		_seed ^= _seed << 5;
+		return _seed;
+	}
+
+	std::unique_ptr<node> _root;
+	std::uint32_t _seed { 2463534242u };
+};
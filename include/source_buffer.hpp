@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "source_file.hpp"
+#include "line_table.hpp"
+
+
+/* append-only storage for script text.
+ * text is kept in blocks that never move once handed out, so tokens and AST
+ * nodes can keep views into them. every block ends at a line boundary (or at
+ * the end of input) and is followed by a '\0' sentinel. no token spans a
+ * line, so no token spans two blocks either. */
+class source_buffer {
+public:
+	static constexpr std::size_t default_chunk_size = 64 * 1024;
+
+	/* the whole text as a single block */
+	source_buffer(std::string source);
+	/* the file's text as a single block, without copying a mapped file */
+	source_buffer(source_file file);
+	/* blocks are read from `in` on demand, `chunk_size` bytes at a time */
+	source_buffer(std::istream& in, std::size_t chunk_size = default_chunk_size);
+	~source_buffer() = default;
+
+	source_buffer(const source_buffer&) = delete;
+	source_buffer& operator=(const source_buffer&) = delete;
+	source_buffer(source_buffer&&) = delete;
+	source_buffer& operator=(source_buffer&&) = delete;
+
+	/* the next block not handed out yet; empty once the input is exhausted */
+	std::string_view next_block();
+	/* hands the blocks out again from the first one, so the text can be
+	 * lexed again. a stream reads on once the blocks it kept run out */
+	void rewind();
+
+	/* the single block of a buffer built from a string or a file */
+	std::string_view text() const;
+	/* true when the text is read from a stream, so text() is empty */
+	bool is_streaming() const;
+	/* the text is longer than source_file::max_size. the buffer then holds
+	 * nothing, or for a stream only the blocks handed out before the limit */
+	bool is_too_large() const;
+	/* line table of the text handed out so far. it is only built when first
+	 * asked for, and extended by the blocks handed out since the last call. */
+	const line_table& lines();
+
+private:
+	std::string _text;
+	std::optional<source_file> _file;
+	std::string_view _view;
+	std::istream* _in;
+	std::size_t _chunk_size;
+	/* held through unique_ptr so short strings do not move with the vector */
+	std::vector<std::unique_ptr<std::string>> _blocks;
+	std::string _carry;
+	/* blocks handed out since the last rewind */
+	std::size_t _handed;
+	bool _exhausted;
+	bool _is_too_large;
+	/* bytes handed out so far */
+	std::size_t _size;
+	line_table _lines;
+	std::size_t _lined_blocks;
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+
+
+/* read-only text of a script file, always followed by a '\0' sentinel.
+ * a regular file is mapped into memory when the mapping already ends in a
+ * zero byte, i.e. its size is not a multiple of the page size, so the lexer
+ * reads the page cache directly without any copy. other files, including
+ * pipes, are read into an owned buffer in large chunks. */
+class source_file {
+public:
+	/* token offsets and the line table are 32-bit and the end of file token
+	 * sits at the size, so a script is at most this long, just under 4 GiB */
+	static constexpr std::size_t max_size = std::numeric_limits<std::uint32_t>::max();
+
+	/* a file longer than `size_limit` is refused; tests pass a small limit
+	 * to reach that path without a file of max_size bytes */
+	source_file(const std::string& path, std::size_t size_limit = max_size);
+	~source_file();
+
+	source_file(const source_file&) = delete;
+	source_file& operator=(const source_file&) = delete;
+	source_file(source_file&& rhs) noexcept;
+	source_file& operator=(source_file&& rhs) noexcept;
+
+	bool is_open() const;
+	/* the file is longer than the size limit, so it is not open */
+	bool is_too_large() const;
+	bool is_mapped() const;
+	std::string_view text() const;
+
+private:
+	void unmap();
+	bool read_all(const std::string& path, std::size_t size_limit);
+
+	std::string _buffer;
+	const char* _mapped;
+	std::size_t _mapped_size;
+	std::string_view _text;
+	bool _is_open;
+	bool _is_too_large;
+};
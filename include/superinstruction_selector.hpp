@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <list>
+#include <memory>
+#include "asm.hpp"
+
+
+/* replaces the instruction sequences that have a superinstruction with
+ * it. the set comes from the profile the benchmark prints, over its
+ * corpus encoded and run through peephole_optimizer (share of the
+ * executed instructions):
+ *   12.2% push var ; push imm          -> binary_var_imm
+ *    7.3% push var ; push var          -> binary_var_var
+ *    4.9% alloc ; push imm ; init      -> init_from_imm
+ *    4.9% push var ; cast float        -> push_var_cast
+ * the pairs of pushes are only fused with the operation that follows
+ * them. it runs last, since the other passes do not know these
+ * instructions. */
+class superinstruction_selector {
+public:
+	/* returns how many sequences were fused */
+	static std::size_t select(std::list<std::unique_ptr<instruct>>& codes);
+	/* the global code and the body of every function */
+	static std::size_t select(asm_context& con);
+};
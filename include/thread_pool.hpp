@@ -0,0 +1,48 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+
+/* fixed set of worker threads shared by the whole process */
+class thread_pool {
+public:
+	static thread_pool* get_instance() {
+		static thread_pool instance(std::thread::hardware_concurrency());
+		return &instance;
+	}
+
+	thread_pool(unsigned int thread_count);
+	~thread_pool();
+
+	thread_pool(const thread_pool&) = delete;
+	thread_pool& operator=(const thread_pool&) = delete;
+
+	unsigned int size() const;
+
+	template <class Func>
+	std::future<void> submit(Func&& func) {
+		std::shared_ptr<std::packaged_task<void()>> task =
+			std::make_shared<std::packaged_task<void()>>(std::forward<Func>(func));
+		std::future<void> result = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_tasks.push([task]() { (*task)(); });
+		}
+		_cond.notify_one();
+		return result;
+	}
+
+private:
+	void worker();
+
+	std::vector<std::thread> _workers;
+	std::queue<std::function<void()>> _tasks;
+	std::mutex _mutex;
+	std::condition_variable _cond;
+	bool _stop;
+};
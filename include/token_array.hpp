@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "tokenize.hpp"
+
+
+/* a lexed token sequence stored as parallel arrays.
+ * a token is a one-byte kind, a 32-bit offset and a 32-bit payload, nine
+ * bytes against the 32 of a token. the payload of an identifier is its
+ * symbol and that of a number, floating or unknown token is the length of
+ * its text; keywords and punctuators need none, since their kind fixes
+ * their text. operator[] rebuilds the token with a view into the source it
+ * was lexed from, so the source must outlive the array. */
+class token_array {
+public:
+	token_array() = default;
+
+	std::size_t size() const;
+	bool empty() const;
+	void reserve(std::size_t count);
+	void clear();
+
+	token operator[](std::size_t index) const;
+	token back() const;
+	token_type kind(std::size_t index) const;
+	std::uint32_t offset(std::size_t index) const;
+
+	/* inline, since the lexer calls it once per token */
+	void push_back(const token& tok) {
+		std::uint32_t payload = 0;
+		switch (tok.type) {
+		case token_type::number:
+		case token_type::floating:
+		case token_type::unknown:
+			payload = static_cast<std::uint32_t>(tok.str.size());
+			break;
+		case token_type::identifier:
+			payload = tok.sym;
+			break;
+		default:
+			break;
+		}
+		std::uintptr_t base = reinterpret_cast<std::uintptr_t>(tok.str.data()) - tok.offset;
+		if (_origins.empty() || _origins.back().base != base) {
+			add_origin(size(), base);
+		}
+		_kinds.push_back(tok.type);
+		_offsets.push_back(tok.offset);
+		_payloads.push_back(payload);
+	}
+	/* appends tokens [first, last) of `other` */
+	void append(const token_array& other, std::size_t first, std::size_t last);
+
+	/* sizes the array for `count` tokens that are then filled in with
+	 * assign(). the tokens take their text from the same source as `like`,
+	 * which must have been lexed from a single view. */
+	void resize(std::size_t count, const token_array& like);
+	/* copies tokens [0, count) of `other` to `index`. `other` must share
+	 * the view of this array. disjoint ranges may be assigned concurrently. */
+	void assign(std::size_t index, const token_array& other, std::size_t count);
+
+	/* bytes used by the elements, not counting spare capacity */
+	std::size_t memory_size() const;
+
+private:
+	/* tokens from `first` on have their text at base + offset. a new entry
+	 * starts whenever a token comes from another block of the source. */
+	struct origin {
+		std::size_t first;
+		std::uintptr_t base;
+	};
+
+	const char* text_at(std::size_t index) const;
+	/* out of line, since it only runs when the source changes block */
+	void add_origin(std::size_t first, std::uintptr_t base);
+
+	std::vector<token_type> _kinds;
+	std::vector<std::uint32_t> _offsets;
+	std::vector<std::uint32_t> _payloads;
+	std::vector<origin> _origins;
+};
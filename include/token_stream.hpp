@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "tokenize.hpp"
+#include "token_array.hpp"
+
+
+/* the parser's view of the token sequence.
+ * backed either by a lexer or by an already lexed token_array. either way
+ * tokens are pulled on demand into a small ring buffer and dropped once
+ * every iterator has moved past them. the ring doubles when an iterator
+ * looks further ahead than it holds. reading past the end keeps yielding eof. */
+class token_stream {
+public:
+	/* the initial size of the ring */
+	static constexpr std::size_t lookahead = 8;
+	static_assert((lookahead & (lookahead - 1)) == 0, "lookahead must be a power of two");
+
+	/* input iterator used by parser::context */
+	class iterator {
+	public:
+		struct postfix {
+			token tok;
+			const token& operator*() const { return tok; }
+			const token* operator->() const { return &tok; }
+		};
+
+		iterator() = default;
+		iterator(token_stream* stream, std::size_t position) :
+			_stream(stream),
+			_position(position)
+		{}
+
+		const token& operator*() const { return _stream->at(_position); }
+		const token* operator->() const { return &_stream->at(_position); }
+		iterator& operator++() {
+			_stream->release(++_position);
+			return *this;
+		}
+		postfix operator++(int) {
+			postfix prev { .tok = **this };
+			++*this;
+			return prev;
+		}
+		bool operator==(const iterator& rhs) const { return _position == rhs._position; }
+
+		std::size_t position() const { return _position; }
+
+	private:
+		token_stream* _stream { nullptr };
+		std::size_t _position { 0 };
+	};
+
+public:
+	token_stream(lexer& source);
+	token_stream(const token_array& tokens);
+
+	token_stream(const token_stream&) = delete;
+	token_stream& operator=(const token_stream&) = delete;
+
+	iterator begin();
+
+	/* `index` is absolute and must not have been released yet. the
+	 * reference lasts until the next call */
+	const token& at(std::size_t index);
+	/* tokens before `index` are no longer needed */
+	void release(std::size_t index);
+	/* the largest index passed to at() so far */
+	std::size_t furthest() const;
+
+private:
+	lexer* _lexer;
+	const token_array* _tokens;
+	/* a power of two in size */
+	std::vector<token> _ring;
+	std::size_t _released;
+	std::size_t _filled;
+	std::size_t _furthest;
+};
@@ -1,22 +1,33 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <string>
-#include <vector>
-#include <optional>
+#include <string_view>
+#include "interner.hpp"
 
 
-struct code_point {
-	unsigned short line;
-	unsigned short col;
-	const char* line_head;
-};
-
-enum class token_type {
+/* one byte per token. every punctuator has a kind of its own, so the parser
+ * never has to look at a token's text to tell them apart. */
+enum class token_type : std::uint8_t {
 	unknown,
 	number,
 	floating,
-	sign,
 	identifier,
 
+	plus,		/* + */
+	minus,		/* - */
+	asterisk,	/* * */
+	slash,		/* / */
+	l_paren,	/* ( */
+	r_paren,	/* ) */
+	semicolon,	/* ; */
+	colon,		/* : */
+	equal,		/* = */
+	comma,		/* , */
+	arrow,		/* -> */
+	l_brace,	/* { */
+	r_brace,	/* } */
+
 	_return,
 	_fn,
 
@@ -28,27 +39,77 @@ enum class token_type {
 
 	eof,
 };
+static inline constexpr std::size_t token_type_count = static_cast<std::size_t>(token_type::eof) + 1;
 
+/* the fixed text of a keyword or punctuator kind, empty for the others */
+std::string_view spelling(token_type type);
+
+/* str is a view into the source owned by compile_unit and offset is the
+ * byte offset of its first character from the start of the source.
+ * line_table turns the offset into a line and column when one is needed.
+ * sym is the interned name of an identifier and no_symbol otherwise. */
 struct token {
-	std::string str;
+	std::string_view str;
 	token_type type;
-	code_point point;
+	std::uint32_t offset;
+	symbol sym;
 };
 
+class source_buffer;
+class token_array;
+
+/* produces tokens one at a time. the lexer either runs over a single view
+ * or pulls blocks from a source_buffer as it reaches the end of each one.
+ * a view does not have to be the whole source: lexing stops at its end or at
+ * a '\0', whichever comes first, and never looks past it, and `start` is
+ * the offset of its first byte. once the input is exhausted next() keeps returning the eof token.
+ * identifiers may contain any XID_Start / XID_Continue character, and every
+ * byte that is not part of well-formed UTF-8 becomes an unknown token. */
 class lexer {
 private:
+	/* the offset of `p` is base + (p - begin). begin and base move together
+	 * when the lexer steps to the next block of a source_buffer.
+	 * [p, valid_end) is known to be well-formed UTF-8; every block is
+	 * validated as a whole when the lexer enters it. */
 	struct context {
-		code_point point;
-		char* p;
+		const char* p;
+		const char* end;
+		const char* begin;
+		std::uint32_t base;
+		const char* valid_end;
+		const struct scan_kernels* kernels;
+		/* skip runs with the vector loops */
+		bool vector_skip;
+		interner* names;
 	};
 
+public:
+	lexer(std::string_view source, std::uint32_t start = 0);
+	lexer(source_buffer& source);
+
+	token next();
+
 private:
-	static void skip_space(context& con);
-	static std::optional<token> try_parse_number(context& con);
-	static std::optional<token> try_parse_sign(context& con);
-	static std::optional<token> try_parse_keyword(context& con);
-	static std::optional<token> try_parse_identifier(context& con);
+	static token parse_number(context& con);
+	/* `p` is the end of the identifier's first character */
+	static token parse_identifier(context& con, const char* p);
+	static token parse_sign(context& con);
+	static token parse_non_ascii(context& con);
+	static token parse_unknown(context& con);
+	static token make_token(context& con, const char* end, token_type type);
+
+	bool next_block();
+
+	context _con;
+	source_buffer* _source;
 
 public:
-	static std::vector<token> tokenize(const std::string& sourcce);
+	static token_array tokenize(std::string_view source);
+	/* same result as tokenize(), but the source is split at line boundaries
+	 * into chunks of at least `min_chunk_size` bytes that are lexed on the
+	 * thread pool and stitched back together */
+	static token_array tokenize_parallel(std::string_view source,
+		std::size_t min_chunk_size = parallel_min_chunk_size);
+
+	static constexpr std::size_t parallel_min_chunk_size = 1 << 20;
 };
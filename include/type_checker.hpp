@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ast.hpp"
+#include "asm.hpp"
+#include "types.hpp"
+
+
+/* the semantic pass between parsing and encoding. it resolves the type of
+ * every node once, storing it and any implicit cast in the node, and gives
+ * every variable a slot in the frame of the function that defines it, so
+ * the encoder reads all three instead of recomputing them. */
+class type_checker {
+public:
+	struct error {
+		/* the node the error is about, and where it starts in the source */
+		node_id node;
+		std::uint32_t offset;
+		std::string message;
+	};
+
+	/* checks the tree under `root` and returns every error in it, in the
+	 * order the walk finishes the offending nodes. operands that are
+	 * already parse errors are not reported again. */
+	static std::vector<error> check(syntax_tree& tree, node_id root);
+
+private:
+	/* a variable in scope. `shadowed` is the binding its name had before,
+	 * plus one, or zero */
+	struct binding {
+		symbol name;
+		slot_index slot;
+		std::uint32_t function_depth;
+		bool initialized;
+		std::uint32_t shadowed;
+	};
+	/* what leaving a block or function restores */
+	struct scope {
+		std::size_t binding_count;
+		slot_index next_slot;
+		bool is_function;
+	};
+	struct context {
+		syntax_tree& tree;
+		std::vector<error>& errors;
+
+		std::vector<binding> bindings;
+		/* the innermost binding of each symbol plus one, or zero. sized
+		 * by the names the tree declares, not by every symbol interned */
+		symbol_map<std::uint32_t> visible;
+		std::vector<scope> scopes;
+		slot_index next_slot;
+		std::uint32_t function_depth;
+	};
+
+	static void enter_scope(context& con, bool is_function);
+	static void leave_scope(context& con);
+	static void declare(context& con, node_id id, bool initialized);
+	/* the binding of `name` in the current function, if there is one */
+	static binding* lookup(context& con, symbol name);
+
+	static void resolve(context& con, node_id id, bool is_argument);
+	/* `is_target` for a variable assigned with `=`, which is written and
+	 * not read */
+	static void resolve_variable(context& con, node_id id, bool is_target);
+	/* records an error about `id` at its offset */
+	static void report(context& con, node_id id, std::string message);
+	/* marks `id` to be converted to `to` where its value is used */
+	static void convert(syntax_tree& tree, node_id id, object_type to);
+};
@@ -1,7 +1,8 @@
 #pragma once
+#include <cstdint>
 #include <string>
 
-enum class object_type;
+enum class object_type : std::uint8_t;
 
 object_type evaluate_type(object_type lhs_type, object_type rhs_type);
 
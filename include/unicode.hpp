@@ -0,0 +1,8 @@
+#pragma once
+
+
+/* identifier classes of UAX #31. ASCII is answered directly; other code
+ * points are looked up in a sorted range table. '_' counts as continue
+ * only, the lexer admits it as a start character on its own. */
+bool is_xid_start(char32_t c);
+bool is_xid_continue(char32_t c);
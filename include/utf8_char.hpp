@@ -17,6 +17,8 @@ public:
 
 	int char_size() const;
 	const char* data() const;
+	/* the decoded scalar value. only meaningful for a well-formed sequence */
+	char32_t code_point() const;
 
 	bool operator==(const utf8_char& rhs) const;
 	bool operator!=(const utf8_char& rhs) const;
@@ -53,6 +55,8 @@ public:
 
 	int char_size() const;
 	const char* data() const;
+	/* the decoded scalar value. only meaningful for a well-formed sequence */
+	char32_t code_point() const;
 
 	bool operator==(const utf8_char_view rhs) const;
 	bool operator!=(const utf8_char_view rhs) const;
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+#include "asm.hpp"
+
+
+/* a runtime value: a tag and one machine word, 16 bytes, copied as plain
+ * memory. a handle refers to an object that lives outside the stack, so
+ * a value never owns anything. */
+struct value {
+	enum class tag : std::uint8_t {
+		none,
+		integer,
+		floating,
+		handle,
+	};
+
+	tag type;
+	union {
+		std::int32_t integer;
+		double floating;
+		std::uint64_t handle;
+	};
+
+	static value of(std::int32_t number) {
+		value result { .type = tag::integer };
+		result.integer = number;
+		return result;
+	}
+	static value of(double number) {
+		value result { .type = tag::floating };
+		result.floating = number;
+		return result;
+	}
+	static value none() {
+		value result { .type = tag::none };
+		result.handle = 0;
+		return result;
+	}
+
+	/* int and float convert both ways, anything else becomes none */
+	static value from_object(const OBJECT& object);
+	OBJECT to_object() const;
+};
+
+/* int arithmetic is done unsigned and converted back, so that overflow
+ * wraps around instead of being undefined. a float passes through */
+inline std::uint32_t wrapping(std::int32_t number) {
+	return static_cast<std::uint32_t>(number);
+}
+inline double wrapping(double number) {
+	return number;
+}
+
+static_assert(sizeof(value) == 16);
+static_assert(std::is_trivially_copyable_v<value>);
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include "bytecode.hpp"
+#include "register_code.hpp"
+#include "value.hpp"
+
+
+/* proves, before a program runs, what the interpreter would otherwise
+ * check at each instruction: that every operand is in the code, that the
+ * stack never underflows or grows past max_stack, that every slot is in
+ * the frame and allocated before it is written and written before it is
+ * read, that constants are written once, that each instruction finds the
+ * types it expects and that no immediate divisor is 0 or -1. a divisor
+ * that is not an immediate is still checked when it runs. the code has no
+ * jumps, so one walk from the start to the first return or abort sees
+ * every state it can be in. register_code gets the same walk: every
+ * register it names is in the register file, written before it is read
+ * and of the type its instruction expects. */
+class verifier {
+public:
+	struct error {
+		/* offset of the instruction the error is about, its index in
+		 * register_code */
+		std::size_t offset;
+		std::string message;
+	};
+
+	/* an argument of the code, in the slot of its position */
+	struct argument {
+		value::tag type;
+		bool is_mutable;
+	};
+
+	/* nothing when the code is sound, in which case `program` is marked
+	 * verified for arguments of these types */
+	static std::optional<error> verify(bytecode& program, std::span<const argument> arguments = {});
+	/* nothing when register_machine can run the code. it takes no
+	 * arguments, so the argument registers are never written */
+	static std::optional<error> verify(const register_code& code);
+
+private:
+	struct slot_state {
+		/* none until the slot is allocated */
+		value::tag type { value::tag::none };
+		bool is_mutable { false };
+		bool is_init { false };
+	};
+};
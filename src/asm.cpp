@@ -1,31 +1,37 @@
 #include "asm.hpp"
-#include <iostream>
+#include "value.hpp"
 
 
-void push_instruct::execute(asm_context& con) const {
-	if (value.value.index() == INVALID_TYPE_INDEX) {
-		con.codes.push_back(std::make_unique<abort_instruct>());
+/* a temporary the compiler made up has no name and is listed by its slot */
+static std::string variable_name(symbol name, slot_index slot) {
+	if (name == no_symbol) {
+		return "$" + std::to_string(slot);
 	}
+	return std::string(interner::get_instance()->name(name));
+}
+
+void push_instruct::execute(asm_context& con) const {
 	if (value.type == operand_type::variable) {
-		std::string var_name = std::get<std::string>(value.value);
 		con.stack.push_back(operand {
 			.type = operand_type::immidiate,
-			.value = con.variables.find(var_name)->second.value
+			.value = con.frame[value.slot]
 		});
 		return;
 	}
+	if (value.value.index() == INVALID_TYPE_INDEX) {
+		con.is_abort = true;
+	}
 	con.stack.push_back(value);
 }
 std::string push_instruct::log(const std::string& prefix) const {
+	if (value.type == operand_type::variable) {
+		return prefix + "push " + variable_name(value.name, value.slot);
+	}
 	switch (value.value.index()) {
 	case INT_TYPE_INDEX: /* int */
 		return prefix + "push " + std::to_string(std::get<int>(value.value));
 	case DOUBLE_TYPE_INDEX: /* double */
 		return prefix + "push " + std::to_string(std::get<double>(value.value));
-	case STRING_TYPE_INDEX:
-		if (value.type == operand_type::variable) {
-			return prefix + "push " + std::get<std::string>(value.value);
-		}
 	}
 	return prefix + "push none";
 }
@@ -38,22 +44,12 @@ std::string pop_instruct::log(const std::string& prefix) const {
 }
 
 void alloc_instruct::execute(asm_context& con) const {
+	/* a slot is reused once the block that had it closes, so it starts
+	 * over from the zero of its type */
 	OBJECT value;
 	if (type == object_type::integer) { value = 0; }
 	else if (type == object_type::floating) { value = 0.; }
-	if (con.variables.contains(name)) {
-		std::cout << name << "is already defined" << std::endl;
-		con.is_abort = true;
-		return;
-	}
-	con.variables.insert({
-		name,
-		variable {
-			.name = name,
-			.is_mutable = is_mutable,
-			.value = value
-		}
-	});
+	con.frame[slot] = std::move(value);
 }
 std::string alloc_instruct::log(const std::string& prefix) const {
 	std::string type_name;
@@ -62,29 +58,16 @@ std::string alloc_instruct::log(const std::string& prefix) const {
 	} else if (type == object_type::floating) {
 		type_name = "float";
 	}
-	return prefix + "alloc " + type_name + (is_mutable ? " const" : " mut") + " as " + name;
+	return prefix + "alloc " + type_name + (is_mutable ? " mut" : " const") + " as " + variable_name(name, slot);
 }
 
 void init_instruct::execute(asm_context& con) const {
-	operand value = con.stack.back();
+	con.frame[slot] = std::move(con.stack.back().value);
 	con.stack.pop_back();
-	auto itr = con.variables.find(lhs);
-	if (itr == con.variables.end()) {
-		std::cout << "not found variable: " << lhs << std::endl;
-		con.is_abort = true;
-		return;
-	}
-	if (itr->second.is_init) {
-		std::cout << lhs << " is already initialized" << std::endl;
-		con.is_abort = true;
-		return;
-	}
-	itr->second.value = value.value;
-	itr->second.is_init = true;
 }
 std::string init_instruct::log(const std::string& prefix) const {
 	std::string str = prefix + "init ";
-	return str + lhs;
+	return str + variable_name(lhs, slot);
 }
 
 void return_instruct::execute(asm_context& con) const {
@@ -102,27 +85,11 @@ std::string abort_instruct::log(const std::string& prefix) const {
 }
 
 void mov_instruct::execute(asm_context& con) const {
-	operand rhs = con.stack.back(); con.stack.pop_back();
-	auto itr = con.variables.find(lhs);
-	if (itr == con.variables.end()) {
-		std::cout << "not found variable: " << lhs << std::endl;
-		con.is_abort = true;
-		return;
-	}
-	if (!(itr->second.is_mutable)) {
-		std::cout << lhs << "is immutable" << std::endl;
-		con.is_abort = true;
-		return;
-	}
-	if (itr->second.value.index() != rhs.value.index()) {
-		std::cout << "mov is failed (reason: defferent type)" << std::endl;
-		con.is_abort = true;
-		return;
-	}
-	itr->second.value = rhs.value;
+	con.frame[slot] = std::move(con.stack.back().value);
+	con.stack.pop_back();
 }
 std::string mov_instruct::log(const std::string& prefix) const {
-	return prefix + "mov " + lhs + "\n";
+	return prefix + "mov " + variable_name(lhs, slot) + "\n";
 }
 
 void add_instruct::execute(asm_context& con) const {
@@ -131,7 +98,7 @@ void add_instruct::execute(asm_context& con) const {
 
 	operand result;
 	result.type = operand_type::immidiate;
-	result.value = std::get<int>(lhs.value) + std::get<int>(rhs.value);
+	result.value = static_cast<int>(wrapping(std::get<int>(lhs.value)) + wrapping(std::get<int>(rhs.value)));
 
 	con.stack.push_back(std::move(result));
 }
@@ -145,7 +112,7 @@ void sub_instruct::execute(asm_context& con) const {
 
 	operand result;
 	result.type = operand_type::immidiate;
-	result.value = std::get<int>(lhs.value) - std::get<int>(rhs.value);
+	result.value = static_cast<int>(wrapping(std::get<int>(lhs.value)) - wrapping(std::get<int>(rhs.value)));
 
 	con.stack.push_back(std::move(result));
 }
@@ -159,7 +126,7 @@ void mul_instruct::execute(asm_context& con) const {
 
 	operand result;
 	result.type = operand_type::immidiate;
-	result.value = std::get<int>(lhs.value) * std::get<int>(rhs.value);
+	result.value = static_cast<int>(wrapping(std::get<int>(lhs.value)) * wrapping(std::get<int>(rhs.value)));
 
 	con.stack.push_back(std::move(result));
 }
@@ -182,27 +149,11 @@ std::string div_instruct::log(const std::string& prefix) const {
 }
 
 void movf_instruct::execute(asm_context& con) const {
-	operand rhs = con.stack.back(); con.stack.pop_back();
-	auto itr = con.variables.find(lhs);
-	if (itr == con.variables.end()) {
-		std::cout << "not found variable: " << lhs << std::endl;
-		con.is_abort = true;
-		return;
-	}
-	if (!(itr->second.is_mutable)) {
-		std::cout << lhs << "is immutable" << std::endl;
-		con.is_abort = true;
-		return;
-	}
-	if (itr->second.value.index() != rhs.value.index()) {
-		std::cout << "mov is failed (reason: defferent type)" << std::endl;
-		con.is_abort = true;
-		return;
-	}
-	itr->second.value = rhs.value;
+	con.frame[slot] = std::move(con.stack.back().value);
+	con.stack.pop_back();
 }
 std::string movf_instruct::log(const std::string& prefix) const {
-	return prefix + "movf " + lhs + "\n";
+	return prefix + "movf " + variable_name(lhs, slot) + "\n";
 }
 
 void addf_instruct::execute(asm_context& con) const {
@@ -261,10 +212,8 @@ std::string divf_instruct::log(const std::string& prefix) const {
 	return prefix + "divf";
 }
 
-cast_instruct::cast_instruct(object_type type) :
-	to(type)
-{}
-void cast_instruct::execute(asm_context& con) const {
+/* the conversion cast_instruct does: a float to int truncates */
+static OBJECT cast_value(const OBJECT& value, object_type to) {
 	struct cast_to {
 		object_type to;
 		OBJECT operator()(const invalid_type&) { return invalid_type(); }
@@ -288,11 +237,17 @@ void cast_instruct::execute(asm_context& con) const {
 		}
 		OBJECT operator()(...) { return invalid_type(); }
 	};
+	return std::visit(cast_to { .to = to }, value);
+}
+
+cast_instruct::cast_instruct(object_type type) :
+	to(type)
+{}
+void cast_instruct::execute(asm_context& con) const {
 	operand object = con.stack.back(); con.stack.pop_back();
-	cast_to visitor { .to = to };
-	con.stack.push_back(operand{ .type = operand_type::immidiate, .value = std::visit(visitor, object.value) });
+	con.stack.push_back(operand{ .type = operand_type::immidiate, .value = cast_value(object.value, to) });
 	if (con.stack.back().value.index() == INVALID_TYPE_INDEX) {
-		con.codes.push_back(std::make_unique<abort_instruct>());
+		con.is_abort = true;
 	}
 }
 std::string cast_instruct::log(const std::string& prefix) const {
@@ -313,3 +268,77 @@ std::string cast_instruct::log(const std::string& prefix) const {
 	}
 	return str;
 }
+
+template <class T>
+static T compute(arithmetic op, T lhs, T rhs) {
+	switch (op) {
+	case arithmetic::add: return static_cast<T>(wrapping(lhs) + wrapping(rhs));
+	case arithmetic::sub: return static_cast<T>(wrapping(lhs) - wrapping(rhs));
+	case arithmetic::mul: return static_cast<T>(wrapping(lhs) * wrapping(rhs));
+	case arithmetic::div: return lhs / rhs;
+	}
+	return lhs;
+}
+static OBJECT compute(arithmetic op, object_type type, const OBJECT& lhs, const OBJECT& rhs) {
+	if (type == object_type::integer) {
+		return compute(op, std::get<int>(lhs), std::get<int>(rhs));
+	}
+	return compute(op, std::get<double>(lhs), std::get<double>(rhs));
+}
+/* "add", "subf" and so on, as the single instructions are listed */
+static std::string arithmetic_name(arithmetic op, object_type type) {
+	std::string name;
+	switch (op) {
+	case arithmetic::add: name = "add"; break;
+	case arithmetic::sub: name = "sub"; break;
+	case arithmetic::mul: name = "mul"; break;
+	case arithmetic::div: name = "div"; break;
+	}
+	return type == object_type::floating ? name + "f" : name;
+}
+static std::string literal_text(const OBJECT& value) {
+	switch (value.index()) {
+	case INT_TYPE_INDEX: return std::to_string(std::get<int>(value));
+	case DOUBLE_TYPE_INDEX: return std::to_string(std::get<double>(value));
+	}
+	return "none";
+}
+
+void init_from_imm_instruct::execute(asm_context& con) const {
+	con.frame[slot] = value;
+}
+std::string init_from_imm_instruct::log(const std::string& prefix) const {
+	return prefix + "init_from_imm " + (type == object_type::floating ? "float" : "int") +
+		(is_mutable ? " mut " : " const ") + variable_name(name, slot) + ", " +
+		literal_text(value);
+}
+
+void push_var_cast_instruct::execute(asm_context& con) const {
+	con.stack.push_back(operand { .type = operand_type::immidiate, .value = cast_value(con.frame[slot], to) });
+	if (con.stack.back().value.index() == INVALID_TYPE_INDEX) {
+		con.is_abort = true;
+	}
+}
+std::string push_var_cast_instruct::log(const std::string& prefix) const {
+	return prefix + (to == object_type::floating ? "push_var_cast_f " : "push_var_cast_i ") +
+		variable_name(name, slot);
+}
+
+void binary_var_imm_instruct::execute(asm_context& con) const {
+	con.stack.push_back(operand { .type = operand_type::immidiate, .value = compute(op, type, con.frame[slot], rhs) });
+}
+std::string binary_var_imm_instruct::log(const std::string& prefix) const {
+	return prefix + arithmetic_name(op, type) + "_var_imm " + variable_name(lhs, slot) +
+		", " + literal_text(rhs);
+}
+
+void binary_var_var_instruct::execute(asm_context& con) const {
+	con.stack.push_back(operand {
+		.type = operand_type::immidiate,
+		.value = compute(op, type, con.frame[lhs_slot], con.frame[rhs_slot])
+	});
+}
+std::string binary_var_var_instruct::log(const std::string& prefix) const {
+	return prefix + arithmetic_name(op, type) + "_var_var " + variable_name(lhs, lhs_slot) +
+		", " + variable_name(rhs, rhs_slot);
+}
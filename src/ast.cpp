@@ -0,0 +1,525 @@
+#include "ast.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+
+static_assert(std::is_trivially_destructible_v<ast_node>, "releasing a syntax_tree must not visit its nodes");
+
+static constexpr std::size_t text_block_size = 4096;
+
+syntax_tree::syntax_tree() :
+	_nodes { ast_node { .kind = ast_kind::error } },
+	_lists(),
+	_pending(),
+	_text_blocks(),
+	_text_used(text_block_size),
+	_root(no_node)
+{}
+
+node_id syntax_tree::add(const ast_node& node) {
+	_nodes.push_back(node);
+	return static_cast<node_id>(_nodes.size() - 1);
+}
+ast_node& syntax_tree::operator[](node_id id) {
+	return _nodes[id];
+}
+const ast_node& syntax_tree::operator[](node_id id) const {
+	return _nodes[id];
+}
+std::size_t syntax_tree::size() const {
+	return _nodes.size();
+}
+
+std::size_t syntax_tree::begin_list() const {
+	return _pending.size();
+}
+void syntax_tree::push_list(node_id id) {
+	_pending.push_back(id);
+}
+void syntax_tree::end_list(node_id owner, std::size_t mark) {
+	ast_node& node = _nodes[owner];
+	node.list = static_cast<std::uint32_t>(_lists.size());
+	node.list_size = static_cast<std::uint32_t>(_pending.size() - mark);
+	_lists.insert(_lists.end(), _pending.begin() + mark, _pending.end());
+	_pending.resize(mark);
+}
+std::span<const node_id> syntax_tree::list(node_id id) const {
+	const ast_node& node = _nodes[id];
+	return std::span<const node_id>(_lists.data() + node.list, node.list_size);
+}
+
+std::string_view syntax_tree::store(std::string_view text) {
+	if (text.size() > text_block_size) {
+		/* an oversized text gets a block of its own, which is then full */
+		_text_blocks.push_back(std::make_unique<char[]>(text.size()));
+		_text_used = text_block_size;
+		std::memcpy(_text_blocks.back().get(), text.data(), text.size());
+		return std::string_view(_text_blocks.back().get(), text.size());
+	}
+	if (text.size() > text_block_size - _text_used) {
+		_text_blocks.push_back(std::make_unique<char[]>(text_block_size));
+		_text_used = 0;
+	}
+	char* dst = _text_blocks.back().get() + _text_used;
+	std::memcpy(dst, text.data(), text.size());
+	_text_used += text.size();
+	return std::string_view(dst, text.size());
+}
+
+node_id syntax_tree::root() const {
+	return _root;
+}
+void syntax_tree::set_root(node_id id) {
+	_root = id;
+}
+
+void syntax_tree::clear() {
+	_nodes.resize(1);
+	_lists.clear();
+	_pending.clear();
+	_text_blocks.clear();
+	_text_used = text_block_size;
+	_root = no_node;
+}
+std::size_t syntax_tree::memory_size() const {
+	return _nodes.size() * sizeof(ast_node) + _lists.size() * sizeof(node_id) +
+		_text_blocks.size() * text_block_size;
+}
+
+object_type syntax_tree::type(node_id id) const {
+	return id == no_node ? object_type::none : _nodes[id].type;
+}
+OBJECT syntax_tree::literal(node_id id) const {
+	const ast_node& node = _nodes[id];
+	const char* first = node.str.data();
+	const char* last = first + node.str.size();
+	switch (node.type) {
+	case object_type::integer: {
+		int integer = 0;
+		std::from_chars(first, last, integer);
+		return integer;
+	}
+	case object_type::floating: {
+		double floating = 0.;
+		std::from_chars(first, last, floating);
+		return floating;
+	}
+	default:
+		return invalid_type();
+	}
+}
+slot_index syntax_tree::slot(node_id id) const {
+	return _nodes[id].list;
+}
+void syntax_tree::set_slot(node_id id, slot_index slot) {
+	_nodes[id].list = slot;
+}
+
+static std::string type_name(token_type modifier, token_type var_type) {
+	std::string name;
+	if (modifier == token_type::_mut) {
+		name = "mut ";
+	} else if (modifier == token_type::_const) {
+		name = "const ";
+	}
+	if (var_type == token_type::_int) {
+		name += "int";
+	} else if (var_type == token_type::_float) {
+		name += "float";
+	}
+	return name;
+}
+
+std::string syntax_tree::log(node_id id, const std::string& prefix) const {
+	/* nodes open their tag when popped and queue their children between it
+	 * and the closing text, so the output comes out in document order */
+	enum class item_kind : std::uint8_t {
+		node,
+		implement,
+		argument,
+		text,
+	};
+	struct item {
+		item_kind kind;
+		node_id id;
+		std::size_t depth;
+		const char* text;
+	};
+	std::string str;
+	auto indent = [&](std::size_t depth) {
+		str += prefix;
+		str.append(std::min(depth, max_log_indent), '\t');
+	};
+	auto close = [](std::size_t depth, const char* text) {
+		return item { .kind = item_kind::text, .id = no_node, .depth = depth, .text = text };
+	};
+	auto child = [](node_id id, std::size_t depth) {
+		return item { .kind = item_kind::node, .id = id, .depth = depth, .text = nullptr };
+	};
+
+	std::vector<item> work { child(id, 0) };
+	while (!work.empty()) {
+		item current = work.back();
+		work.pop_back();
+		std::size_t depth = current.depth;
+		if (current.kind == item_kind::text) {
+			indent(depth);
+			str += current.text;
+			continue;
+		}
+		const ast_node& node = _nodes[current.id];
+		if (current.kind == item_kind::argument) {
+			indent(depth);
+			str += "<argument name=\"" + std::string(node.str) + "\" ";
+			str += "type=\"" + type_name(node.tok, node.var_type) + "\"></argument>\n";
+			continue;
+		}
+		switch (node.kind) {
+		case ast_kind::error:
+			indent(depth);
+			if (node.lhs == no_node) {
+				str += "<error>" + std::string(node.str) + "</error>\n";
+				break;
+			}
+			str += "<error message=\"" + std::string(node.str) + "\">\n";
+			work.push_back(close(depth, "</error>\n"));
+			work.push_back(child(node.lhs, depth + 1));
+			break;
+		case ast_kind::value:
+			indent(depth);
+			str += "<value>" + std::string(node.str) + "</value>\n";
+			break;
+		case ast_kind::parenthess:
+			indent(depth);
+			str += "<parenthess>\n";
+			work.push_back(close(depth, "</parenthess>\n"));
+			if (node.lhs != no_node) {
+				work.push_back(child(node.lhs, depth + 1));
+			}
+			break;
+		case ast_kind::bin_op:
+			indent(depth);
+			str += "<operator op=\"" + std::string(spelling(node.tok)) + "\">\n";
+			work.push_back(close(depth, "</operator>\n"));
+			if (node.rhs != no_node) {
+				work.push_back(child(node.rhs, depth + 1));
+			}
+			if (node.lhs != no_node) {
+				work.push_back(child(node.lhs, depth + 1));
+			}
+			break;
+		case ast_kind::expr:
+			if (node.lhs != no_node) {
+				work.push_back(child(node.lhs, depth));
+			}
+			break;
+		case ast_kind::var_define:
+			indent(depth);
+			str += "<define name=\"" + std::string(node.str) + "\" type=\"" +
+				type_name(node.tok, node.var_type) + "\">\n";
+			work.push_back(close(depth, "</define>\n"));
+			if (node.lhs != no_node) {
+				work.push_back(child(node.lhs, depth + 1));
+			}
+			break;
+		case ast_kind::_return:
+			indent(depth);
+			str += "<return>\n";
+			work.push_back(close(depth, "</return>\n"));
+			if (node.lhs != no_node) {
+				work.push_back(child(node.lhs, depth + 1));
+			}
+			break;
+		case ast_kind::block: {
+			indent(depth);
+			std::string_view name = current.kind == item_kind::implement ? "implement" : node.str;
+			str += "<block name=\"" + std::string(name) + "\">\n";
+			work.push_back(close(depth, "</block>\n"));
+			std::span<const node_id> children = list(current.id);
+			for (auto itr = children.rbegin(); itr != children.rend(); ++itr) {
+				work.push_back(child(*itr, depth + 1));
+			}
+			break;
+		}
+		case ast_kind::function: {
+			auto return_type_name = [](token_type type) -> std::string {
+				if (type == token_type::eof) {
+					return "";
+				}
+				return type == token_type::unknown ? "error" : std::string(spelling(type));
+			};
+			indent(depth);
+			str += "<function name=\"" + mangled_name(current.id) + "\">\n";
+			indent(depth + 1);
+			str += "<return type=\"" + return_type_name(node.tok) + " " + return_type_name(node.var_type) +
+				"\"></return>\n";
+
+			work.push_back(close(depth, "</function>\n"));
+			std::span<const node_id> children = list(current.id);
+			if (children.size() > node.list_split) {
+				work.push_back(close(depth + 1, "</error>\n"));
+				std::span<const node_id> errors = children.subspan(node.list_split);
+				for (auto itr = errors.rbegin(); itr != errors.rend(); ++itr) {
+					work.push_back(child(*itr, depth + 2));
+				}
+				work.push_back(close(depth + 1, "<error>\n"));
+			}
+			if (node.lhs != no_node && _nodes[node.lhs].kind == ast_kind::block) {
+				work.push_back(item { .kind = item_kind::implement, .id = node.lhs, .depth = depth + 1, .text = nullptr });
+			}
+			std::span<const node_id> arguments = children.first(node.list_split);
+			for (auto itr = arguments.rbegin(); itr != arguments.rend(); ++itr) {
+				item argument = child(*itr, depth + 1);
+				if (_nodes[*itr].kind == ast_kind::var_define) {
+					argument.kind = item_kind::argument;
+				}
+				work.push_back(argument);
+			}
+			break;
+		}
+		}
+	}
+	return str;
+}
+
+std::string syntax_tree::mangled_name(node_id id) const {
+	const ast_node& node = _nodes[id];
+	std::string mangled_name = "fn@" + (node.str.empty() ? std::string("error") : std::string(node.str)) + "(";
+	std::string sep = "";
+	for (node_id child : list(id).first(node.list_split)) {
+		const ast_node& argument = _nodes[child];
+		if (argument.kind == ast_kind::var_define) {
+			mangled_name += std::exchange(sep, ",");
+			mangled_name += spelling(argument.tok);
+			mangled_name += " ";
+			mangled_name += spelling(argument.var_type);
+		}
+	}
+	return mangled_name + ")";
+}
+
+void syntax_tree::encode(node_id id, asm_context& con) const {
+	/* each step is a node and how far its encoding got. a node that has
+	 * instructions to emit after a child pushes itself back with the next
+	 * stage before pushing the child */
+	struct step {
+		node_id id;
+		std::uint32_t stage;
+		asm_context* con;
+	};
+	std::vector<step> work { step { .id = id, .stage = 0, .con = &con } };
+	/* the bodies of the functions being encoded, innermost last */
+	std::vector<std::unique_ptr<asm_context>> bodies;
+	auto then = [&work](const step& current, node_id child) {
+		work.push_back(step { .id = current.id, .stage = current.stage + 1, .con = current.con });
+		work.push_back(step { .id = child, .stage = 0, .con = current.con });
+	};
+
+	while (!work.empty()) {
+		step current = work.back();
+		work.pop_back();
+		if (current.id == no_node) {
+			continue;
+		}
+		asm_context& target = *current.con;
+		const ast_node& node = _nodes[current.id];
+		switch (node.kind) {
+		case ast_kind::error:
+			break;
+		case ast_kind::value:
+			encode_value(current.id, target);
+			break;
+		case ast_kind::parenthess:
+			work.push_back(step { .id = node.lhs, .stage = 0, .con = current.con });
+			break;
+		case ast_kind::bin_op:
+			if (current.stage == 0) {
+				if (node.tok != token_type::equal) {
+					then(current, node.lhs);
+					break;
+				}
+				/* an assignment stores to its target without reading it */
+				current.stage = 1;
+			} else if (current.stage == 1) {
+				encode_cast(node.lhs, target);
+			}
+			if (current.stage == 1) {
+				then(current, node.rhs);
+				break;
+			}
+			encode_cast(node.rhs, target);
+			encode_operator(current.id, target);
+			break;
+		case ast_kind::expr:
+			if (current.stage == 0) {
+				then(current, node.lhs);
+				break;
+			}
+			target.codes.push_back(std::make_unique<pop_instruct>());
+			break;
+		case ast_kind::var_define: {
+			if (current.stage == 0) {
+				std::unique_ptr<alloc_instruct> instruct = std::make_unique<alloc_instruct>();
+				instruct->is_mutable = node.tok == token_type::_mut;
+				instruct->name = node.sym;
+				instruct->slot = slot(current.id);
+				/* the context's frame grows to the highest slot its code uses */
+				if (instruct->slot >= target.frame.size()) {
+					target.frame.resize(instruct->slot + 1);
+				}
+				if (node.var_type == token_type::_int) {
+					instruct->type = object_type::integer;
+				} else if (node.var_type == token_type::_float) {
+					instruct->type = object_type::floating;
+				}
+				target.codes.push_back(std::move(instruct));
+				if (node.lhs != no_node) {
+					then(current, node.lhs);
+				}
+				break;
+			}
+			encode_cast(node.lhs, target);
+			std::unique_ptr<init_instruct> init = std::make_unique<init_instruct>();
+			init->lhs = node.sym;
+			init->slot = slot(current.id);
+			target.codes.push_back(std::move(init));
+			break;
+		}
+		case ast_kind::_return:
+			if (current.stage == 0) {
+				then(current, node.lhs);
+				break;
+			}
+			target.codes.push_back(std::make_unique<return_instruct>());
+			break;
+		case ast_kind::block: {
+			std::span<const node_id> children = list(current.id);
+			if (current.stage < children.size()) {
+				then(current, children[current.stage]);
+			}
+			break;
+		}
+		case ast_kind::function:
+			/* the body is encoded into a context of its own and only its
+			 * instructions are kept */
+			if (current.stage == 0) {
+				bodies.push_back(std::make_unique<asm_context>());
+				work.push_back(step { .id = current.id, .stage = 1, .con = current.con });
+				work.push_back(step { .id = node.lhs, .stage = 0, .con = bodies.back().get() });
+				break;
+			}
+			encode_function(current.id, std::move(*bodies.back()), target);
+			bodies.pop_back();
+			break;
+		}
+	}
+}
+void syntax_tree::encode_value(node_id id, asm_context& con) const {
+	const ast_node& node = _nodes[id];
+	std::unique_ptr<push_instruct> inst = std::make_unique<push_instruct>();
+	if (node.tok == token_type::identifier && slot(id) == no_slot) {
+		/* type_checker has reported it, so the code is never meant to run */
+		con.codes.push_back(std::make_unique<abort_instruct>());
+		return;
+	}
+	if (node.tok == token_type::identifier) {
+		inst->value = operand {
+			.type = operand_type::variable,
+			.value = invalid_type(),
+			.name = node.sym,
+			.slot = slot(id)
+		};
+		con.codes.push_back(std::move(inst));
+		return;
+	}
+	inst->value = operand {
+		.type = operand_type::immidiate,
+		.value = literal(id)
+	};
+	con.codes.push_back(std::move(inst));
+}
+void syntax_tree::encode_cast(node_id id, asm_context& con) const {
+	if (id != no_node && _nodes[id].cast != object_type::none) {
+		con.codes.push_back(std::make_unique<cast_instruct>(_nodes[id].cast));
+	}
+}
+void syntax_tree::encode_operator(node_id id, asm_context& con) const {
+	const ast_node& node = _nodes[id];
+	object_type result_type = node.type;
+	if (node.tok == token_type::equal) {
+		const ast_node& target = _nodes[node.lhs];
+		if (target.kind != ast_kind::value || slot(node.lhs) == no_slot) {
+			con.codes.push_back(std::make_unique<abort_instruct>());
+			return;
+		}
+		object_type lhs_type = type(node.lhs);
+		object_type rhs_type = type(node.rhs);
+		/* the value was converted to the common type above and is stored
+		 * back as the variable's type */
+		if (lhs_type != rhs_type && evaluate_type(lhs_type, rhs_type) != object_type::none) {
+			con.codes.push_back(std::make_unique<cast_instruct>(lhs_type));
+		}
+		if (lhs_type == object_type::integer) {
+			std::unique_ptr<mov_instruct> mov_inst = std::make_unique<mov_instruct>();
+			mov_inst->lhs = target.sym;
+			mov_inst->slot = slot(node.lhs);
+			con.codes.push_back(std::move(mov_inst));
+		} else if (lhs_type == object_type::floating) {
+			std::unique_ptr<movf_instruct> mov_inst = std::make_unique<movf_instruct>();
+			mov_inst->lhs = target.sym;
+			mov_inst->slot = slot(node.lhs);
+			con.codes.push_back(std::move(mov_inst));
+		} else {
+			return;
+		}
+		/* the assignment's own value is what the variable now holds, in
+		 * the type it was checked as */
+		encode_value(node.lhs, con);
+		if (result_type != object_type::none && result_type != lhs_type) {
+			con.codes.push_back(std::make_unique<cast_instruct>(result_type));
+		}
+		return;
+	}
+
+	if (result_type == object_type::integer) {
+		switch (node.tok) {
+		case token_type::plus: con.codes.push_back(std::make_unique<add_instruct>()); break;
+		case token_type::minus: con.codes.push_back(std::make_unique<sub_instruct>()); break;
+		case token_type::asterisk: con.codes.push_back(std::make_unique<mul_instruct>()); break;
+		case token_type::slash: con.codes.push_back(std::make_unique<div_instruct>()); break;
+		default: break;
+		}
+	} else if (result_type == object_type::floating) {
+		switch (node.tok) {
+		case token_type::plus: con.codes.push_back(std::make_unique<addf_instruct>()); break;
+		case token_type::minus: con.codes.push_back(std::make_unique<subf_instruct>()); break;
+		case token_type::asterisk: con.codes.push_back(std::make_unique<mulf_instruct>()); break;
+		case token_type::slash: con.codes.push_back(std::make_unique<divf_instruct>()); break;
+		default: break;
+		}
+	}
+}
+void syntax_tree::encode_function(node_id id, asm_context body, asm_context& con) const {
+	const ast_node& node = _nodes[id];
+	asm_context::function_info info;
+	info.instruction = std::move(body.codes);
+	info.frame_size = static_cast<std::uint32_t>(body.frame.size());
+	for (node_id child : list(id).first(node.list_split)) {
+		const ast_node& argument = _nodes[child];
+		if (argument.kind == ast_kind::var_define) {
+			variable var;
+			var.is_init = argument.lhs != no_node;
+			var.is_mutable = argument.tok == token_type::_mut;
+			var.name = argument.sym;
+			info.argument.push_back(std::move(var));
+			if (slot(child) >= info.frame_size) {
+				info.frame_size = slot(child) + 1;
+			}
+		}
+	}
+
+	con.functions.insert(interner::get_instance()->intern(mangled_name(id)), std::move(info));
+}
@@ -0,0 +1,230 @@
+#include "bytecode.hpp"
+#include <algorithm>
+
+
+namespace {
+	template <class T>
+	const T* as(const instruct& inst) {
+		return dynamic_cast<const T*>(&inst);
+	}
+
+	/* the opcode of a fused operation, laid out in arithmetic order */
+	opcode fused(opcode first, arithmetic op, object_type type) {
+		std::size_t offset = static_cast<std::size_t>(op) + (type == object_type::floating ? 4 : 0);
+		return static_cast<opcode>(static_cast<std::size_t>(first) + offset);
+	}
+}
+
+bytecode bytecode::compile(const asm_context& con) {
+	return compile(con.codes, static_cast<std::uint32_t>(con.frame.size()));
+}
+bytecode bytecode::compile(const std::list<std::unique_ptr<instruct>>& codes, std::uint32_t frame_size) {
+	bytecode program;
+	program._frame_size = frame_size;
+	for (const std::unique_ptr<instruct>& inst : codes) {
+		program.emit_instruction(*inst);
+	}
+	/* running off the end stops as return does */
+	program.emit(opcode::ret);
+	return program;
+}
+
+const std::uint8_t* bytecode::data() const {
+	return _code.data();
+}
+std::size_t bytecode::size() const {
+	return _code.size();
+}
+std::uint32_t bytecode::frame_size() const {
+	return _frame_size;
+}
+std::uint32_t bytecode::max_stack() const {
+	return _max_stack;
+}
+std::size_t bytecode::count() const {
+	return _count;
+}
+bool bytecode::is_verified() const {
+	return _is_verified;
+}
+const std::vector<value::tag>& bytecode::argument_types() const {
+	return _argument_types;
+}
+
+std::string bytecode::disassemble() const {
+	return disassemble(_code.data(), _code.size());
+}
+std::string bytecode::disassemble(const std::uint8_t* code, std::size_t size) {
+	std::string str;
+	for (std::size_t offset = 0; offset < size;) {
+		opcode op = static_cast<opcode>(code[offset]);
+		str += std::to_string(offset) + ": " + std::string(name(op));
+		const std::uint8_t* at = code + offset + 1;
+		switch (layout(op)) {
+		case operand_layout::none:
+			break;
+		case operand_layout::slot:
+			str += " $" + std::to_string(read<std::uint32_t>(at));
+			break;
+		case operand_layout::integer:
+			str += " " + std::to_string(read<std::int32_t>(at));
+			break;
+		case operand_layout::floating:
+			str += " " + std::to_string(read<double>(at));
+			break;
+		case operand_layout::slot_integer:
+			str += " $" + std::to_string(read<std::uint32_t>(at)) + ", " + std::to_string(read<std::int32_t>(at + 4));
+			break;
+		case operand_layout::slot_floating:
+			str += " $" + std::to_string(read<std::uint32_t>(at)) + ", " + std::to_string(read<double>(at + 4));
+			break;
+		case operand_layout::slot_slot:
+			str += " $" + std::to_string(read<std::uint32_t>(at)) + ", $" + std::to_string(read<std::uint32_t>(at + 4));
+			break;
+		}
+		str += "\n";
+		offset += 1 + operand_size(op);
+	}
+	return str;
+}
+
+std::string_view bytecode::name(opcode op) {
+	switch (op) {
+#define BYTECODE_NAME(name, layout, effect) case opcode::name: return #name;
+	BYTECODE_OPCODES(BYTECODE_NAME)
+#undef BYTECODE_NAME
+	}
+	return "";
+}
+operand_layout bytecode::layout(opcode op) {
+	switch (op) {
+#define BYTECODE_LAYOUT(name, layout, effect) case opcode::name: return operand_layout::layout;
+	BYTECODE_OPCODES(BYTECODE_LAYOUT)
+#undef BYTECODE_LAYOUT
+	}
+	return operand_layout::none;
+}
+int bytecode::stack_effect(opcode op) {
+	switch (op) {
+#define BYTECODE_EFFECT(name, layout, effect) case opcode::name: return effect;
+	BYTECODE_OPCODES(BYTECODE_EFFECT)
+#undef BYTECODE_EFFECT
+	}
+	return 0;
+}
+std::size_t bytecode::operand_size(opcode op) {
+	switch (layout(op)) {
+	case operand_layout::none: return 0;
+	case operand_layout::slot: return 4;
+	case operand_layout::integer: return 4;
+	case operand_layout::floating: return 8;
+	case operand_layout::slot_integer: return 8;
+	case operand_layout::slot_floating: return 12;
+	case operand_layout::slot_slot: return 8;
+	}
+	return 0;
+}
+
+void bytecode::emit(opcode op) {
+	_code.push_back(static_cast<std::uint8_t>(op));
+	++_count;
+	/* the code has no jumps, so the depth at each instruction is the sum
+	 * of the effects before it */
+	_depth = std::max<std::int64_t>(_depth + stack_effect(op), 0);
+	_max_stack = std::max(_max_stack, static_cast<std::uint32_t>(_depth));
+}
+void bytecode::emit_push(const OBJECT& value) {
+	if (const int* integer = std::get_if<int>(&value)) {
+		emit(opcode::push_int);
+		emit_operand<std::int32_t>(*integer);
+	} else if (const double* floating = std::get_if<double>(&value)) {
+		emit(opcode::push_float);
+		emit_operand<double>(*floating);
+	} else {
+		/* pushing no value is how the encoder marks code that must not run */
+		emit(opcode::abort);
+	}
+}
+void bytecode::emit_instruction(const instruct& inst) {
+	if (auto* push = as<push_instruct>(inst)) {
+		if (push->value.type == operand_type::variable) {
+			emit(opcode::push_var);
+			emit_operand<std::uint32_t>(push->value.slot);
+		} else {
+			emit_push(push->value.value);
+		}
+	} else if (as<pop_instruct>(inst)) {
+		emit(opcode::pop);
+	} else if (auto* alloc = as<alloc_instruct>(inst)) {
+		if (alloc->is_mutable) {
+			emit(alloc->type == object_type::floating ? opcode::alloc_float : opcode::alloc_int);
+		} else {
+			emit(alloc->type == object_type::floating ? opcode::alloc_const_float : opcode::alloc_const_int);
+		}
+		emit_operand<std::uint32_t>(alloc->slot);
+	} else if (auto* init = as<init_instruct>(inst)) {
+		emit(opcode::init);
+		emit_operand<std::uint32_t>(init->slot);
+	} else if (auto* mov = as<mov_instruct>(inst)) {
+		emit(opcode::store);
+		emit_operand<std::uint32_t>(mov->slot);
+	} else if (auto* movf = as<movf_instruct>(inst)) {
+		emit(opcode::store);
+		emit_operand<std::uint32_t>(movf->slot);
+	} else if (as<return_instruct>(inst)) {
+		emit(opcode::ret);
+	} else if (as<abort_instruct>(inst)) {
+		emit(opcode::abort);
+	} else if (as<add_instruct>(inst)) {
+		emit(opcode::add);
+	} else if (as<sub_instruct>(inst)) {
+		emit(opcode::sub);
+	} else if (as<mul_instruct>(inst)) {
+		emit(opcode::mul);
+	} else if (as<div_instruct>(inst)) {
+		emit(opcode::div);
+	} else if (as<addf_instruct>(inst)) {
+		emit(opcode::addf);
+	} else if (as<subf_instruct>(inst)) {
+		emit(opcode::subf);
+	} else if (as<mulf_instruct>(inst)) {
+		emit(opcode::mulf);
+	} else if (as<divf_instruct>(inst)) {
+		emit(opcode::divf);
+	} else if (auto* cast = as<cast_instruct>(inst)) {
+		if (cast->to == object_type::integer) {
+			emit(opcode::cast_int);
+		} else if (cast->to == object_type::floating) {
+			emit(opcode::cast_float);
+		} else {
+			emit(opcode::abort);
+		}
+	} else if (auto* init_imm = as<init_from_imm_instruct>(inst)) {
+		if (const int* integer = std::get_if<int>(&init_imm->value)) {
+			emit(init_imm->is_mutable ? opcode::store_int : opcode::store_const_int);
+			emit_operand<std::uint32_t>(init_imm->slot);
+			emit_operand<std::int32_t>(*integer);
+		} else {
+			emit(init_imm->is_mutable ? opcode::store_float : opcode::store_const_float);
+			emit_operand<std::uint32_t>(init_imm->slot);
+			emit_operand<double>(std::get<double>(init_imm->value));
+		}
+	} else if (auto* push_cast = as<push_var_cast_instruct>(inst)) {
+		emit(push_cast->to == object_type::floating ? opcode::push_var_cast_float : opcode::push_var_cast_int);
+		emit_operand<std::uint32_t>(push_cast->slot);
+	} else if (auto* var_imm = as<binary_var_imm_instruct>(inst)) {
+		emit(fused(opcode::add_var_imm, var_imm->op, var_imm->type));
+		emit_operand<std::uint32_t>(var_imm->slot);
+		if (var_imm->type == object_type::floating) {
+			emit_operand<double>(std::get<double>(var_imm->rhs));
+		} else {
+			emit_operand<std::int32_t>(std::get<int>(var_imm->rhs));
+		}
+	} else if (auto* var_var = as<binary_var_var_instruct>(inst)) {
+		emit(fused(opcode::add_var_var, var_var->op, var_var->type));
+		emit_operand<std::uint32_t>(var_var->lhs_slot);
+		emit_operand<std::uint32_t>(var_var->rhs_slot);
+	} else {
+		emit(opcode::abort);
+	}
+}
@@ -0,0 +1,84 @@
+#include "compile_unit.hpp"
+#include "token_stream.hpp"
+
+
+compile_unit::compile_unit(std::string source) :
+	_source(std::move(source)),
+	_tokens(),
+	_tree(),
+	_type_errors()
+{}
+compile_unit::compile_unit(source_file file) :
+	_source(std::move(file)),
+	_tokens(),
+	_tree(),
+	_type_errors()
+{}
+compile_unit::compile_unit(std::istream& in, std::size_t chunk_size) :
+	_source(in, chunk_size),
+	_tokens(),
+	_tree(),
+	_type_errors()
+{}
+
+const token_array& compile_unit::tokens() const {
+	return _tokens;
+}
+const syntax_tree& compile_unit::tree() const {
+	return _tree;
+}
+bool compile_unit::is_too_large() const {
+	return _source.is_too_large();
+}
+
+const token_array& compile_unit::tokenize() {
+	if (!_tokens.empty()) {
+		return _tokens;
+	}
+	/* the text may have been lexed by an earlier parse() */
+	_source.rewind();
+	lexer lex(_source);
+	token tok;
+	do {
+		tok = lex.next();
+		_tokens.push_back(tok);
+	} while (tok.type != token_type::eof);
+	return _tokens;
+}
+const token_array& compile_unit::tokenize_parallel() {
+	if (!_tokens.empty() || _source.is_streaming()) {
+		return tokenize();
+	}
+	_tokens = lexer::tokenize_parallel(_source.text());
+	return _tokens;
+}
+const syntax_tree& compile_unit::parse() {
+	_tree.clear();
+	if (!_tokens.empty()) {
+		parser::parse(_tokens, _tree);
+	} else {
+		_source.rewind();
+		lexer lex(_source);
+		token_stream stream(lex);
+		parser::parse(stream, _tree);
+	}
+	if (_source.is_too_large()) {
+		/* a stream only finds out while it is lexed */
+		_tree.clear();
+		_type_errors.clear();
+		return _tree;
+	}
+	_type_errors = type_checker::check(_tree, _tree.root());
+	return _tree;
+}
+const std::vector<type_checker::error>& compile_unit::type_errors() const {
+	return _type_errors;
+}
+const syntax_tree& compile_unit::fold_constants() {
+	constant_folder::fold(_tree, _tree.root());
+	return _tree;
+}
+
+source_location compile_unit::locate(std::uint32_t offset) {
+	return _source.lines().locate(offset);
+}
@@ -0,0 +1,230 @@
+#include "constant_folder.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+
+
+void constant_folder::fold(syntax_tree& tree, node_id root) {
+	if (root == no_node) {
+		return;
+	}
+	context con { .tree = tree, .constants = {} };
+
+	/* post-order on an explicit stack, so operands are folded before the
+	 * operation and a constant is known before the statements after it */
+	struct step {
+		node_id id;
+		bool fold;
+	};
+	std::vector<step> work { step { .id = root, .fold = false } };
+	auto visit = [&work](node_id id) {
+		if (id != no_node) {
+			work.push_back(step { .id = id, .fold = false });
+		}
+	};
+	while (!work.empty()) {
+		step current = work.back();
+		work.pop_back();
+		if (current.fold) {
+			fold_node(con, current.id);
+			continue;
+		}
+		work.push_back(step { .id = current.id, .fold = true });
+		const ast_node& node = tree[current.id];
+		switch (node.kind) {
+		case ast_kind::block:
+		case ast_kind::function: {
+			std::span<const node_id> children = tree.list(current.id);
+			for (auto itr = children.rbegin(); itr != children.rend(); ++itr) {
+				visit(*itr);
+			}
+			visit(node.kind == ast_kind::function ? node.lhs : no_node);
+			break;
+		}
+		case ast_kind::bin_op:
+			visit(node.rhs);
+			/* the target of `=` is written, never read */
+			if (node.tok != token_type::equal) {
+				visit(node.lhs);
+			}
+			break;
+		case ast_kind::value:
+			break;
+		default:
+			visit(node.lhs);
+			break;
+		}
+	}
+}
+
+void constant_folder::fold_node(context& con, node_id id) {
+	const ast_node& node = con.tree[id];
+	switch (node.kind) {
+	case ast_kind::value:
+		if (node.tok == token_type::identifier) {
+			if (const OBJECT* value = con.constants.find(node.sym)) {
+				make_literal(con, id, *value);
+			}
+		} else if (node.cast != object_type::none) {
+			/* the implicit cast is folded into the literal */
+			make_literal(con, id, con.tree.literal(id));
+		}
+		break;
+	case ast_kind::parenthess:
+		if (std::optional<OBJECT> value = value_of(con, node.lhs)) {
+			make_literal(con, id, *value);
+		}
+		break;
+	case ast_kind::bin_op: {
+		if (node.tok == token_type::equal) {
+			break;
+		}
+		std::optional<OBJECT> lhs = value_of(con, node.lhs);
+		std::optional<OBJECT> rhs = value_of(con, node.rhs);
+		if (!lhs || !rhs) {
+			break;
+		}
+		if (std::optional<OBJECT> result = evaluate(node.tok, *lhs, *rhs)) {
+			make_literal(con, id, *result);
+		}
+		break;
+	}
+	case ast_kind::var_define:
+		if (node.tok == token_type::_const) {
+			if (std::optional<OBJECT> value = value_of(con, node.lhs)) {
+				con.constants.insert(node.sym, *value);
+			}
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+std::optional<OBJECT> constant_folder::value_of(context& con, node_id id) {
+	if (id == no_node) {
+		return std::nullopt;
+	}
+	const ast_node& node = con.tree[id];
+	if (node.kind != ast_kind::value || node.tok == token_type::identifier) {
+		return std::nullopt;
+	}
+	OBJECT value = con.tree.literal(id);
+	if (value.index() == INVALID_TYPE_INDEX) {
+		return std::nullopt;
+	}
+	if (node.cast == object_type::none) {
+		return value;
+	}
+	return cast(value, node.cast);
+}
+
+template <class Type>
+static std::optional<Type> apply(token_type op, Type lhs, Type rhs) {
+	if constexpr (std::is_same_v<Type, int>) {
+		/* in 64 bits none of the three can overflow, so the result is
+		 * compared against the range of int instead */
+		std::int64_t result = 0;
+		switch (op) {
+		case token_type::plus: result = std::int64_t(lhs) + rhs; break;
+		case token_type::minus: result = std::int64_t(lhs) - rhs; break;
+		case token_type::asterisk: result = std::int64_t(lhs) * rhs; break;
+		case token_type::slash:
+			if (rhs == 0 || (lhs == std::numeric_limits<int>::min() && rhs == -1)) {
+				return std::nullopt;
+			}
+			return lhs / rhs;
+		default:
+			return std::nullopt;
+		}
+		if (result < std::numeric_limits<int>::min() || result > std::numeric_limits<int>::max()) {
+			return std::nullopt;
+		}
+		return static_cast<int>(result);
+	} else {
+		switch (op) {
+		case token_type::plus: return lhs + rhs;
+		case token_type::minus: return lhs - rhs;
+		case token_type::asterisk: return lhs * rhs;
+		case token_type::slash: return lhs / rhs;
+		default: return std::nullopt;
+		}
+	}
+}
+std::optional<OBJECT> constant_folder::evaluate(token_type op, const OBJECT& lhs, const OBJECT& rhs) {
+	/* the type checker cast both operands to the operation's type */
+	if (lhs.index() != rhs.index()) {
+		return std::nullopt;
+	}
+	if (const int* value = std::get_if<int>(&lhs)) {
+		std::optional<int> result = apply(op, *value, std::get<int>(rhs));
+		return result ? std::optional<OBJECT>(*result) : std::nullopt;
+	}
+	if (const double* value = std::get_if<double>(&lhs)) {
+		std::optional<double> result = apply(op, *value, std::get<double>(rhs));
+		return result ? std::optional<OBJECT>(*result) : std::nullopt;
+	}
+	return std::nullopt;
+}
+std::optional<OBJECT> constant_folder::cast(const OBJECT& value, object_type to) {
+	if (const int* integer = std::get_if<int>(&value)) {
+		switch (to) {
+		case object_type::integer: return value;
+		case object_type::floating: return OBJECT(static_cast<double>(*integer));
+		default: return std::nullopt;
+		}
+	}
+	if (const double* floating = std::get_if<double>(&value)) {
+		switch (to) {
+		case object_type::integer:
+			/* a value an int cannot hold is left to the instruction */
+			if (!(*floating > static_cast<double>(std::numeric_limits<int>::min()) - 1. &&
+				*floating < static_cast<double>(std::numeric_limits<int>::max()) + 1.)) {
+				return std::nullopt;
+			}
+			return OBJECT(static_cast<int>(*floating));
+		case object_type::floating: return value;
+		default: return std::nullopt;
+		}
+	}
+	return std::nullopt;
+}
+
+void constant_folder::make_literal(context& con, node_id id, const OBJECT& value) {
+	/* the node's own implicit cast is folded in as well, unless the
+	 * instruction has to do it */
+	object_type pending = con.tree[id].cast;
+	OBJECT folded = value;
+	if (pending != object_type::none) {
+		if (std::optional<OBJECT> converted = cast(value, pending)) {
+			folded = std::move(*converted);
+			pending = object_type::none;
+		}
+	}
+
+	/* the shortest text that reads back to the same value */
+	char buffer[64];
+	std::to_chars_result result;
+	token_type tok;
+	object_type type;
+	if (const int* integer = std::get_if<int>(&folded)) {
+		result = std::to_chars(buffer, buffer + sizeof(buffer), *integer);
+		tok = token_type::number;
+		type = object_type::integer;
+	} else {
+		result = std::to_chars(buffer, buffer + sizeof(buffer), std::get<double>(folded));
+		tok = token_type::floating;
+		type = object_type::floating;
+	}
+	con.tree[id] = ast_node {
+		.kind = ast_kind::value,
+		.tok = tok,
+		.type = type,
+		.cast = pending,
+		.offset = con.tree[id].offset,
+		.str = con.tree.store(std::string_view(buffer, result.ptr - buffer))
+	};
+}
@@ -0,0 +1,384 @@
+#include "document.hpp"
+#include "token_stream.hpp"
+#include <algorithm>
+
+
+namespace {
+	/* appends tokens [first, last) of `from` with `shift` added to their
+	 * offsets */
+	void append_shifted(token_array& to, const token_array& from, std::size_t first, std::size_t last, std::int64_t shift) {
+		last = std::min(last, from.size());
+		for (std::size_t index = first; index < last; ++index) {
+			token tok = from[index];
+			tok.offset = static_cast<std::uint32_t>(tok.offset + shift);
+			to.push_back(tok);
+		}
+	}
+}
+
+document::document(std::string source) :
+	_segments(),
+	_failed_tree(),
+	_failed_text(),
+	_stats()
+{
+	rebuild_all(std::move(source));
+}
+
+void document::apply(const edit& change) {
+	std::size_t total = size();
+	std::size_t offset = std::min(change.offset, total);
+	std::size_t removed = std::min(change.removed, total - offset);
+
+	if (_failed_tree) {
+		std::string source = text();
+		source.replace(offset, removed, change.inserted);
+		rebuild_all(std::move(source));
+		return;
+	}
+	_stats = edit_stats {};
+
+	/* `first` also covers the byte before the edit and `last` the byte after
+	 * it, since the edit may join a token with its neighbour */
+	sequence_tree<segment>::location first = _segments.find(offset == 0 ? 0 : offset - 1);
+	while (first.index > 0) {
+		const segment_node* previous = _segments.at(first.index - 1);
+		if (!previous->value.looks_past) {
+			break;
+		}
+		first = { previous, first.index - 1, first.start - previous->value.text.size() };
+	}
+	std::size_t last = _segments.find(offset + removed).index;
+	std::string region;
+	for (std::size_t index = first.index; index <= last; ++index) {
+		region += _segments.at(index)->value.text;
+	}
+	region.replace(offset - first.start, removed, change.inserted);
+
+	std::vector<symbol> changed;
+	std::optional<std::size_t> end = repair(first.index, last, std::move(region), changed);
+	if (!end) {
+		std::string source = text();
+		source.replace(offset, removed, change.inserted);
+		rebuild_all(std::move(source));
+		return;
+	}
+	/* statements after the range only see the variables it defines, and
+	 * only those that mention a changed one can parse differently */
+	for (;;) {
+		for (symbol name : changed) {
+			auto found = _mentions.find(name);
+			if (found == _mentions.end()) {
+				continue;
+			}
+			for (const segment_node* item : found->second) {
+				if (_segments.locate(item).index >= *end) {
+					_pending.insert(item);
+				}
+			}
+		}
+		changed.clear();
+		if (_pending.empty()) {
+			break;
+		}
+		const segment_node* item = *_pending.begin();
+		_pending.erase(_pending.begin());
+		std::size_t index = _segments.locate(item).index;
+		end = repair(index, index, std::string(item->value.text), changed);
+		if (!end) {
+			/* the edit is already in the segments */
+			_pending.clear();
+			rebuild_all(text());
+			return;
+		}
+	}
+	_stats.reused_statements = _segments.size() - 1 - _stats.reparsed_statements;
+}
+
+std::string document::log() const {
+	if (_failed_tree) {
+		return _failed_tree->log(_failed_tree->root(), "");
+	}
+	std::string str = "<block name=\"global\">\n";
+	_segments.for_each([&str](const segment& seg) {
+		if (seg.tree) {
+			str += seg.tree->log(seg.node, "\t");
+		}
+	});
+	return str + "</block>\n";
+}
+std::string document::text() const {
+	if (_failed_text) {
+		return *_failed_text;
+	}
+	std::string str;
+	str.reserve(size());
+	_segments.for_each([&str](const segment& seg) {
+		str += seg.text;
+	});
+	return str;
+}
+std::size_t document::size() const {
+	if (_failed_text) {
+		return _failed_text->size();
+	}
+	return _segments.weight();
+}
+token_array document::tokens() const {
+	if (_failed_text) {
+		return lexer::tokenize(*_failed_text);
+	}
+	token_array tokens;
+	std::size_t start = 0;
+	_segments.for_each([&tokens, &start](const segment& seg) {
+		append_shifted(tokens, seg.tokens, 0, seg.tokens.size(), static_cast<std::int64_t>(start));
+		start += seg.text.size();
+	});
+	const segment& back = _segments.at(_segments.size() - 1)->value;
+	tokens.push_back(token {
+		.str = std::string_view(back.text.data() + back.text.size(), 0),
+		.type = token_type::eof,
+		.offset = static_cast<std::uint32_t>(size()),
+		.sym = no_symbol
+	});
+	return tokens;
+}
+const document::edit_stats& document::last_stats() const {
+	return _stats;
+}
+
+document::build_result document::build(
+	std::shared_ptr<const std::string> piece, std::size_t first, bool at_end,
+	std::vector<segment>& segments
+) const {
+	token_array tokens;
+	lexer lex(*piece);
+	token tok;
+	do {
+		tok = lex.next();
+		tokens.push_back(tok);
+	} while (tok.type != token_type::eof);
+	const std::size_t eof_index = tokens.size() - 1;
+
+	parser::symbol_table symbols = symbols_before(first, tokens);
+	std::shared_ptr<syntax_tree> tree = std::make_shared<syntax_tree>();
+	token_stream stream(tokens);
+	token_stream::iterator itr = stream.begin();
+	const char* text_begin = piece->data();
+	const char* piece_end = piece->data() + piece->size();
+
+	while (itr.position() < eof_index) {
+		std::size_t token_begin = itr.position();
+		std::size_t defined_begin = symbols.defined.size();
+		node_id node = parser::parse_statement(itr, symbols, *tree);
+		if (!at_end && stream.furthest() >= eof_index) {
+			return build_result::need_more;
+		}
+		/* a statement that steps past eof never ended, so it is no segment
+		 * of its own; parse does the same over the whole text */
+		if (!node || itr.position() == token_begin || itr.position() > eof_index) {
+			return build_result::failed;
+		}
+
+		segment seg {
+			.piece = piece,
+			.text = {},
+			.tokens = {},
+			.defines = {},
+			.tree = tree,
+			.node = node,
+			.looks_past = stream.furthest() >= itr.position()
+		};
+		append_shifted(seg.tokens, tokens, token_begin, itr.position(), piece->data() - text_begin);
+		if (seg.tokens.empty()) {
+			return build_result::failed;
+		}
+		token back = seg.tokens.back();
+		const char* text_end = back.str.data() + back.str.size();
+		seg.text = std::string_view(text_begin, text_end - text_begin);
+		for (std::size_t index = defined_begin; index < symbols.defined.size(); ++index) {
+			const variable* var = symbols.variables.find(symbols.defined[index]);
+			seg.defines.push_back(definition {
+				.name = symbols.defined[index],
+				.is_mutable = var->is_mutable,
+				.type_index = var->value.index()
+			});
+		}
+		text_begin = text_end;
+		segments.push_back(std::move(seg));
+	}
+
+	if (!at_end) {
+		if (segments.empty()) {
+			return build_result::need_more;
+		}
+		/* only whitespace is left, keep it with the last statement */
+		segment& back = segments.back();
+		back.text = std::string_view(back.text.data(), piece_end - back.text.data());
+	} else {
+		segments.push_back(segment {
+			.piece = piece,
+			.text = std::string_view(text_begin, piece_end - text_begin),
+			.tokens = {},
+			.defines = {},
+			.tree = nullptr,
+			.node = no_node,
+			.looks_past = false
+		});
+	}
+	return build_result::ok;
+}
+
+std::optional<std::size_t> document::repair(std::size_t first, std::size_t last, std::string region,
+	std::vector<symbol>& changed)
+{
+	std::vector<segment> segments;
+	std::size_t relexed = 0;
+	for (;;) {
+		bool at_end = last == _segments.size() - 1;
+		segments.clear();
+		relexed += region.size();
+		build_result result = build(std::make_shared<const std::string>(region), first, at_end, segments);
+		if (result == build_result::failed) {
+			return std::nullopt;
+		}
+		if (result == build_result::need_more) {
+			region += _segments.at(++last)->value.text;
+			continue;
+		}
+		break;
+	}
+
+	std::vector<definition> old_defines;
+	for (std::size_t index = first; index <= last; ++index) {
+		const segment_node* item = _segments.at(index);
+		old_defines.insert(old_defines.end(), item->value.defines.begin(), item->value.defines.end());
+		remove_names(item);
+	}
+	std::vector<definition> new_defines;
+	std::vector<std::pair<segment, std::size_t>> items;
+	std::size_t reparsed = 0;
+	for (segment& seg : segments) {
+		new_defines.insert(new_defines.end(), seg.defines.begin(), seg.defines.end());
+		reparsed += seg.tree != nullptr;
+		std::size_t weight = seg.text.size();
+		items.emplace_back(std::move(seg), weight);
+	}
+	std::size_t count = items.size();
+	_segments.replace(first, last + 1, std::move(items));
+	for (std::size_t index = first; index < first + count; ++index) {
+		add_names(_segments.at(index));
+	}
+
+	for (const definition& def : old_defines) {
+		if (std::find(new_defines.begin(), new_defines.end(), def) == new_defines.end()) {
+			changed.push_back(def.name);
+		}
+	}
+	for (const definition& def : new_defines) {
+		if (std::find(old_defines.begin(), old_defines.end(), def) == old_defines.end()) {
+			changed.push_back(def.name);
+		}
+	}
+	_stats.relexed_bytes += relexed;
+	_stats.reparsed_statements += reparsed;
+	return first + count;
+}
+
+void document::rebuild_all(std::string text) {
+	std::shared_ptr<const std::string> piece = std::make_shared<const std::string>(std::move(text));
+	_pending.clear();
+	_definitions.clear();
+	_mentions.clear();
+	_segments.clear();
+	_failed_tree.reset();
+	_failed_text.reset();
+
+	std::vector<segment> segments;
+	if (build(piece, 0, true, segments) == build_result::failed) {
+		_failed_text = piece;
+		_failed_tree = std::make_unique<syntax_tree>();
+		parser::parse(lexer::tokenize(*piece), *_failed_tree);
+		_stats.reparsed_statements = 0;
+	} else {
+		std::vector<std::pair<segment, std::size_t>> items;
+		for (segment& seg : segments) {
+			std::size_t weight = seg.text.size();
+			items.emplace_back(std::move(seg), weight);
+		}
+		_segments.replace(0, 0, std::move(items));
+		for (std::size_t index = 0; index < _segments.size(); ++index) {
+			add_names(_segments.at(index));
+		}
+		_stats.reparsed_statements = _segments.size() - 1;
+	}
+	_stats.relexed_bytes = piece->size();
+	_stats.reused_statements = 0;
+}
+
+parser::symbol_table document::symbols_before(std::size_t first, const token_array& tokens) const {
+	parser::symbol_table symbols;
+	std::unordered_set<symbol> seen;
+	for (std::size_t index = 0; index < tokens.size(); ++index) {
+		if (tokens.kind(index) != token_type::identifier) {
+			continue;
+		}
+		symbol name = tokens[index].sym;
+		if (!seen.insert(name).second) {
+			continue;
+		}
+		auto found = _definitions.find(name);
+		if (found == _definitions.end() || _segments.locate(found->second).index >= first) {
+			continue;
+		}
+		const std::vector<definition>& defines = found->second->value.defines;
+		const definition& def = *std::find_if(defines.begin(), defines.end(),
+			[name](const definition& item) { return item.name == name; });
+		OBJECT value;
+		if (def.type_index == INT_TYPE_INDEX) {
+			value = 0;
+		} else if (def.type_index == DOUBLE_TYPE_INDEX) {
+			value = 0.;
+		}
+		symbols.variables.insert(def.name, variable {
+			.name = def.name,
+			.is_mutable = def.is_mutable,
+			.value = std::move(value)
+		});
+		symbols.defined.push_back(def.name);
+	}
+	return symbols;
+}
+void document::add_names(const segment_node* item) {
+	for (const definition& def : item->value.defines) {
+		_definitions[def.name] = item;
+	}
+	const token_array& tokens = item->value.tokens;
+	for (std::size_t index = 0; index < tokens.size(); ++index) {
+		if (tokens.kind(index) == token_type::identifier) {
+			_mentions[tokens[index].sym].insert(item);
+		}
+	}
+}
+void document::remove_names(const segment_node* item) {
+	_pending.erase(item);
+	for (const definition& def : item->value.defines) {
+		auto found = _definitions.find(def.name);
+		if (found != _definitions.end() && found->second == item) {
+			_definitions.erase(found);
+		}
+	}
+	const token_array& tokens = item->value.tokens;
+	for (std::size_t index = 0; index < tokens.size(); ++index) {
+		if (tokens.kind(index) != token_type::identifier) {
+			continue;
+		}
+		auto found = _mentions.find(tokens[index].sym);
+		if (found != _mentions.end()) {
+			found->second.erase(item);
+			if (found->second.empty()) {
+				_mentions.erase(found);
+			}
+		}
+	}
+}
@@ -0,0 +1,68 @@
+#include "instruction_profile.hpp"
+#include <algorithm>
+
+
+void instruction_profile::execute(asm_context& con) {
+	std::string_view previous[2];
+	for (const std::unique_ptr<instruct>& inst : con.codes) {
+		std::string_view current = shape(*inst);
+		if (!previous[1].empty()) {
+			++_pairs[std::string(previous[1]) + " ; " + std::string(current)];
+			if (!previous[0].empty()) {
+				++_triples[std::string(previous[0]) + " ; " + std::string(previous[1]) + " ; " + std::string(current)];
+			}
+		}
+		previous[0] = previous[1];
+		previous[1] = current;
+		++_executed;
+
+		inst->execute(con);
+		if (con.is_abort) {
+			break;
+		}
+	}
+}
+
+std::vector<std::pair<std::string, std::size_t>> instruction_profile::top(std::size_t length, std::size_t count) const {
+	const std::map<std::string, std::size_t>& counts = length == 2 ? _pairs : _triples;
+	std::vector<std::pair<std::string, std::size_t>> sorted(counts.begin(), counts.end());
+	std::stable_sort(sorted.begin(), sorted.end(), [](const auto& lhs, const auto& rhs) {
+		return lhs.second > rhs.second;
+	});
+	if (sorted.size() > count) {
+		sorted.resize(count);
+	}
+	return sorted;
+}
+std::size_t instruction_profile::executed() const {
+	return _executed;
+}
+
+std::string_view instruction_profile::shape(const instruct& inst) {
+	if (auto* push = dynamic_cast<const push_instruct*>(&inst)) {
+		return push->value.type == operand_type::variable ? "push var" : "push imm";
+	}
+	if (dynamic_cast<const pop_instruct*>(&inst)) { return "pop"; }
+	if (dynamic_cast<const alloc_instruct*>(&inst)) { return "alloc"; }
+	if (dynamic_cast<const init_instruct*>(&inst)) { return "init"; }
+	if (dynamic_cast<const return_instruct*>(&inst)) { return "return"; }
+	if (dynamic_cast<const abort_instruct*>(&inst)) { return "abort"; }
+	if (dynamic_cast<const mov_instruct*>(&inst)) { return "mov"; }
+	if (dynamic_cast<const movf_instruct*>(&inst)) { return "movf"; }
+	if (dynamic_cast<const add_instruct*>(&inst)) { return "add"; }
+	if (dynamic_cast<const sub_instruct*>(&inst)) { return "sub"; }
+	if (dynamic_cast<const mul_instruct*>(&inst)) { return "mul"; }
+	if (dynamic_cast<const div_instruct*>(&inst)) { return "div"; }
+	if (dynamic_cast<const addf_instruct*>(&inst)) { return "addf"; }
+	if (dynamic_cast<const subf_instruct*>(&inst)) { return "subf"; }
+	if (dynamic_cast<const mulf_instruct*>(&inst)) { return "mulf"; }
+	if (dynamic_cast<const divf_instruct*>(&inst)) { return "divf"; }
+	if (auto* cast = dynamic_cast<const cast_instruct*>(&inst)) {
+		return cast->to == object_type::floating ? "cast float" : "cast int";
+	}
+	if (dynamic_cast<const init_from_imm_instruct*>(&inst)) { return "init_from_imm"; }
+	if (dynamic_cast<const push_var_cast_instruct*>(&inst)) { return "push_var_cast"; }
+	if (dynamic_cast<const binary_var_imm_instruct*>(&inst)) { return "binary_var_imm"; }
+	if (dynamic_cast<const binary_var_var_instruct*>(&inst)) { return "binary_var_var"; }
+	return "other";
+}
@@ -0,0 +1,145 @@
+#include "interner.hpp"
+#include <bit>
+#include <cstring>
+#include <mutex>
+
+
+static constexpr std::size_t name_block_size = 64 * 1024;
+static constexpr std::size_t initial_slot_count = 1024;
+
+static std::uint64_t hash_name(std::string_view name) {
+	/* FNV-1a */
+	std::uint64_t hash = 14695981039346656037ull;
+	for (char c : name) {
+		hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+	}
+	return hash;
+}
+
+/* most identifiers repeat, so each thread remembers recently interned names
+ * in a small direct-mapped table and only takes the lock on a miss. the
+ * cached views point into name blocks, which are never freed. */
+struct intern_cache_entry {
+	const interner* owner;
+	std::string_view name;
+	symbol id;
+};
+static constexpr std::size_t intern_cache_size = 256;
+
+interner::interner() :
+	_blocks(),
+	_block_used(name_block_size),
+	_pages(),
+	_name_count(1),
+	_slots(initial_slot_count, slot { .hash = 0, .id = no_symbol }),
+	_mutex()
+{
+	_pages[0] = std::make_unique<std::string_view[]>(first_page_size);
+}
+
+symbol interner::intern(std::string_view name) {
+	if (name.empty()) {
+		return no_symbol;
+	}
+	std::uint64_t hash = hash_name(name);
+	thread_local intern_cache_entry cache[intern_cache_size] {};
+	intern_cache_entry& entry = cache[hash & (intern_cache_size - 1)];
+	if (entry.owner == this && entry.name == name) {
+		return entry.id;
+	}
+	symbol id = intern_locked(name, hash);
+	entry = intern_cache_entry { .owner = this, .name = this->name(id), .id = id };
+	return id;
+}
+std::string_view interner::name(symbol id) const {
+	return name_at(id);
+}
+std::size_t interner::size() const {
+	std::shared_lock<std::shared_mutex> lock(_mutex);
+	return _name_count;
+}
+
+std::string_view& interner::name_at(symbol id) {
+	std::size_t page = std::bit_width(id / first_page_size + 1) - 1;
+	return _pages[page][id - first_page_size * ((std::size_t(1) << page) - 1)];
+}
+const std::string_view& interner::name_at(symbol id) const {
+	std::size_t page = std::bit_width(id / first_page_size + 1) - 1;
+	return _pages[page][id - first_page_size * ((std::size_t(1) << page) - 1)];
+}
+
+symbol interner::intern_locked(std::string_view name, std::uint64_t hash) {
+	{
+		std::shared_lock<std::shared_mutex> lock(_mutex);
+		if (symbol id = find(name, hash)) {
+			return id;
+		}
+	}
+	std::unique_lock<std::shared_mutex> lock(_mutex);
+	if (symbol id = find(name, hash)) {
+		return id;
+	}
+	/* keep the load factor at or below one half */
+	if ((_name_count + 1) * 2 > _slots.size()) {
+		grow();
+	}
+	symbol id = static_cast<symbol>(_name_count);
+	std::size_t page = std::bit_width(id / first_page_size + 1) - 1;
+	if (!_pages[page]) {
+		_pages[page] = std::make_unique<std::string_view[]>(first_page_size << page);
+	}
+	name_at(id) = store(name);
+	++_name_count;
+	std::size_t mask = _slots.size() - 1;
+	for (std::size_t index = hash & mask;; index = (index + 1) & mask) {
+		if (_slots[index].id == no_symbol) {
+			_slots[index] = slot { .hash = hash, .id = id };
+			break;
+		}
+	}
+	return id;
+}
+symbol interner::find(std::string_view name, std::uint64_t hash) const {
+	std::size_t mask = _slots.size() - 1;
+	for (std::size_t index = hash & mask;; index = (index + 1) & mask) {
+		const slot& entry = _slots[index];
+		if (entry.id == no_symbol) {
+			return no_symbol;
+		}
+		if (entry.hash == hash && name_at(entry.id) == name) {
+			return entry.id;
+		}
+	}
+}
+std::string_view interner::store(std::string_view name) {
+	if (name.size() > name_block_size) {
+		/* an oversized name gets a block of its own, which is then full */
+		_blocks.push_back(std::make_unique<char[]>(name.size()));
+		_block_used = name_block_size;
+		std::memcpy(_blocks.back().get(), name.data(), name.size());
+		return std::string_view(_blocks.back().get(), name.size());
+	}
+	if (name.size() > name_block_size - _block_used) {
+		_blocks.push_back(std::make_unique<char[]>(name_block_size));
+		_block_used = 0;
+	}
+	char* dst = _blocks.back().get() + _block_used;
+	std::memcpy(dst, name.data(), name.size());
+	_block_used += name.size();
+	return std::string_view(dst, name.size());
+}
+void interner::grow() {
+	std::vector<slot> slots(_slots.size() * 2, slot { .hash = 0, .id = no_symbol });
+	std::size_t mask = slots.size() - 1;
+	for (const slot& entry : _slots) {
+		if (entry.id == no_symbol) {
+			continue;
+		}
+		std::size_t index = entry.hash & mask;
+		while (slots[index].id != no_symbol) {
+			index = (index + 1) & mask;
+		}
+		slots[index] = entry;
+	}
+	_slots = std::move(slots);
+}
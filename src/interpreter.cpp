@@ -0,0 +1,324 @@
+#include "interpreter.hpp"
+#include <algorithm>
+#include <limits>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define INTERPRETER_COMPUTED_GOTO
+#endif
+
+
+interpreter::interpreter(const bytecode& program) :
+	_program(program),
+	_is_verified(program.is_verified()),
+	_argument_types(program.argument_types()),
+	_code(program.data(), program.data() + program.size()),
+	_stack(std::make_unique<value[]>(program.max_stack())),
+	_frame(std::make_unique<value[]>(program.frame_size()))
+{}
+
+std::vector<OBJECT> interpreter::evaluate(const bytecode& program) {
+	interpreter runner(program);
+	std::vector<OBJECT> objects;
+	for (const value& item : runner.run()) {
+		objects.push_back(item.to_object());
+	}
+	return objects;
+}
+
+std::size_t interpreter::quickened() const {
+	return _quickened;
+}
+std::size_t interpreter::deoptimized() const {
+	return _deoptimized;
+}
+std::string interpreter::disassemble() const {
+	return bytecode::disassemble(_code.data(), _code.size());
+}
+
+std::span<const value> interpreter::run(std::span<const value> arguments) {
+	bool checked = !_is_verified || arguments.size() != _argument_types.size();
+	for (std::size_t index = 0; !checked && index < arguments.size(); ++index) {
+		checked = arguments[index].type != _argument_types[index];
+	}
+	return checked ? execute<true>(arguments) : execute<false>(arguments);
+}
+
+template <bool checked>
+std::span<const value> interpreter::execute(std::span<const value> arguments) {
+	value* const base = _stack.get();
+	value* const limit = base + _program.max_stack();
+	value* sp = base;
+	value* const frame = _frame.get();
+	const std::uint32_t frame_size = _program.frame_size();
+	std::fill_n(frame, frame_size, value::none());
+	std::copy_n(arguments.begin(), std::min<std::size_t>(arguments.size(), frame_size), frame);
+	std::uint8_t* pc = _code.data();
+
+	auto slot = [&pc]() {
+		std::uint32_t index = bytecode::read<std::uint32_t>(pc);
+		pc += sizeof(std::uint32_t);
+		return index;
+	};
+	auto integer = [&pc]() {
+		std::int32_t number = bytecode::read<std::int32_t>(pc);
+		pc += sizeof(std::int32_t);
+		return number;
+	};
+	auto floating = [&pc]() {
+		double number = bytecode::read<double>(pc);
+		pc += sizeof(double);
+		return number;
+	};
+
+#ifdef INTERPRETER_COMPUTED_GOTO
+	static const void* const labels[] = {
+#define INTERPRETER_LABEL(name, layout, effect) &&op_##name,
+		BYTECODE_OPCODES(INTERPRETER_LABEL)
+#undef INTERPRETER_LABEL
+	};
+#define CASE(name) op_##name:
+#define NEXT() goto *labels[*pc++]
+	NEXT();
+#else
+#define CASE(name) case opcode::name:
+#define NEXT() continue
+	for (;;) switch (static_cast<opcode>(*pc++)) {
+#endif
+
+#define STOP() return std::span<const value>(base, sp)
+/* what verified code is known to pass */
+#define NEED(count) if (checked && sp - base < (count)) { STOP(); }
+#define ROOM() if (checked && sp == limit) { STOP(); }
+#define EXPECT(item, kind) if (checked && (item).type != value::tag::kind) { STOP(); }
+/* reads a slot operand into `name` */
+#define SLOT(name) const std::uint32_t name = slot(); if (checked && name >= frame_size) { STOP(); }
+/* the operation on the two values on top, which are of type `kind` */
+#define ARITHMETIC(kind, op) { \
+		NEED(2); \
+		EXPECT(sp[-2], kind); \
+		EXPECT(sp[-1], kind); \
+		sp[-2].kind = static_cast<decltype(sp[-2].kind)>(wrapping(sp[-2].kind) op wrapping(sp[-1].kind)); \
+		--sp; \
+		NEXT(); \
+	}
+#define VAR_IMM(kind, read, op) { \
+		ROOM(); \
+		SLOT(index); \
+		const value& lhs = frame[index]; \
+		EXPECT(lhs, kind); \
+		*sp++ = value::of(static_cast<decltype(lhs.kind)>(wrapping(lhs.kind) op wrapping(read()))); \
+		NEXT(); \
+	}
+#define VAR_VAR(kind, op) { \
+		ROOM(); \
+		SLOT(first); \
+		SLOT(second); \
+		const value& lhs = frame[first]; \
+		const value& rhs = frame[second]; \
+		EXPECT(lhs, kind); \
+		EXPECT(rhs, kind); \
+		*sp++ = value::of(static_cast<decltype(lhs.kind)>(wrapping(lhs.kind) op wrapping(rhs.kind))); \
+		NEXT(); \
+	}
+/* aborts, leaving nothing, on the divisors an integer division has no
+ * quotient for */
+#define DIVISOR(lhs, rhs) \
+	if ((rhs) == 0 || ((rhs) == -1 && (lhs) == std::numeric_limits<std::int32_t>::min())) { \
+		return std::span<const value>(); \
+	}
+/* rewrites the instruction at `at` into `name` and runs it again */
+#define REWRITE(at, name) { \
+		*(at) = static_cast<std::uint8_t>(opcode::name); \
+		pc = (at); \
+		NEXT(); \
+	}
+#define QUICKEN(at, name) { ++_quickened; REWRITE(at, name) }
+#define DEOPTIMIZE(at, name) { ++_deoptimized; REWRITE(at, name) }
+/* a cast quickened for `from`, which goes back to `generic` when the value
+ * is of another type */
+#define CAST(from, to, generic) { \
+		NEED(1); \
+		if (sp[-1].type != value::tag::from) DEOPTIMIZE(pc - 1, generic) \
+		sp[-1] = value::of(static_cast<to>(sp[-1].from)); \
+		NEXT(); \
+	}
+#define PUSH_VAR_CAST(from, to, generic) { \
+		ROOM(); \
+		std::uint8_t* const at = pc - 1; \
+		SLOT(index); \
+		const value& source = frame[index]; \
+		if (source.type != value::tag::from) DEOPTIMIZE(at, generic) \
+		*sp++ = value::of(static_cast<to>(source.from)); \
+		NEXT(); \
+	}
+
+	CASE(push_int) ROOM(); *sp++ = value::of(integer()); NEXT();
+	CASE(push_float) ROOM(); *sp++ = value::of(floating()); NEXT();
+	CASE(push_var) { ROOM(); SLOT(source); *sp++ = frame[source]; NEXT(); }
+	CASE(pop) NEED(1); --sp; NEXT();
+	CASE(alloc_int) { SLOT(target); frame[target] = value::of(std::int32_t(0)); NEXT(); }
+	CASE(alloc_float) { SLOT(target); frame[target] = value::of(0.); NEXT(); }
+	CASE(alloc_const_int) { SLOT(target); frame[target] = value::of(std::int32_t(0)); NEXT(); }
+	CASE(alloc_const_float) { SLOT(target); frame[target] = value::of(0.); NEXT(); }
+	CASE(init) { NEED(1); SLOT(target); frame[target] = *--sp; NEXT(); }
+	CASE(store) { NEED(1); SLOT(target); frame[target] = *--sp; NEXT(); }
+	CASE(store_int) { SLOT(target); frame[target] = value::of(integer()); NEXT(); }
+	CASE(store_float) { SLOT(target); frame[target] = value::of(floating()); NEXT(); }
+	CASE(store_const_int) { SLOT(target); frame[target] = value::of(integer()); NEXT(); }
+	CASE(store_const_float) { SLOT(target); frame[target] = value::of(floating()); NEXT(); }
+	CASE(add) ARITHMETIC(integer, +)
+	CASE(sub) ARITHMETIC(integer, -)
+	CASE(mul) ARITHMETIC(integer, *)
+	CASE(div) {
+		NEED(2);
+		EXPECT(sp[-2], integer);
+		EXPECT(sp[-1], integer);
+		/* the divisor is not known before it runs, so verified code checks it too */
+		DIVISOR(sp[-2].integer, sp[-1].integer);
+		sp[-2].integer /= sp[-1].integer;
+		--sp;
+		NEXT();
+	}
+	CASE(addf) ARITHMETIC(floating, +)
+	CASE(subf) ARITHMETIC(floating, -)
+	CASE(mulf) ARITHMETIC(floating, *)
+	CASE(divf) ARITHMETIC(floating, /)
+	CASE(cast_int)
+		NEED(1);
+		if (sp[-1].type == value::tag::floating) QUICKEN(pc - 1, cast_f2i)
+		if (sp[-1].type == value::tag::integer) QUICKEN(pc - 1, cast_i2i)
+		STOP();
+	CASE(cast_float)
+		NEED(1);
+		if (sp[-1].type == value::tag::integer) QUICKEN(pc - 1, cast_i2f)
+		if (sp[-1].type == value::tag::floating) QUICKEN(pc - 1, cast_f2f)
+		STOP();
+	CASE(push_var_cast_int) {
+		ROOM();
+		std::uint8_t* const at = pc - 1;
+		SLOT(index);
+		const value& source = frame[index];
+		if (source.type == value::tag::floating) QUICKEN(at, push_var_f2i)
+		if (source.type == value::tag::integer) QUICKEN(at, push_var_i2i)
+		STOP();
+	}
+	CASE(push_var_cast_float) {
+		ROOM();
+		std::uint8_t* const at = pc - 1;
+		SLOT(index);
+		const value& source = frame[index];
+		if (source.type == value::tag::integer) QUICKEN(at, push_var_i2f)
+		if (source.type == value::tag::floating) QUICKEN(at, push_var_f2f)
+		STOP();
+	}
+	CASE(cast_i2i) CAST(integer, std::int32_t, cast_int_any)
+	CASE(cast_f2i) CAST(floating, std::int32_t, cast_int_any)
+	CASE(cast_i2f) CAST(integer, double, cast_float_any)
+	CASE(cast_f2f) CAST(floating, double, cast_float_any)
+	CASE(push_var_i2i) PUSH_VAR_CAST(integer, std::int32_t, push_var_cast_int_any)
+	CASE(push_var_f2i) PUSH_VAR_CAST(floating, std::int32_t, push_var_cast_int_any)
+	CASE(push_var_i2f) PUSH_VAR_CAST(integer, double, push_var_cast_float_any)
+	CASE(push_var_f2f) PUSH_VAR_CAST(floating, double, push_var_cast_float_any)
+	CASE(cast_int_any)
+		NEED(1);
+		if (sp[-1].type == value::tag::floating) {
+			sp[-1] = value::of(static_cast<std::int32_t>(sp[-1].floating));
+		} else if (sp[-1].type != value::tag::integer) {
+			STOP();
+		}
+		NEXT();
+	CASE(cast_float_any)
+		NEED(1);
+		if (sp[-1].type == value::tag::integer) {
+			sp[-1] = value::of(static_cast<double>(sp[-1].integer));
+		} else if (sp[-1].type != value::tag::floating) {
+			STOP();
+		}
+		NEXT();
+	CASE(push_var_cast_int_any) {
+		ROOM();
+		SLOT(index);
+		const value& source = frame[index];
+		if (source.type == value::tag::floating) {
+			*sp++ = value::of(static_cast<std::int32_t>(source.floating));
+		} else {
+			EXPECT(source, integer);
+			*sp++ = source;
+		}
+		NEXT();
+	}
+	CASE(push_var_cast_float_any) {
+		ROOM();
+		SLOT(index);
+		const value& source = frame[index];
+		if (source.type == value::tag::integer) {
+			*sp++ = value::of(static_cast<double>(source.integer));
+		} else {
+			EXPECT(source, floating);
+			*sp++ = source;
+		}
+		NEXT();
+	}
+	CASE(add_var_imm) VAR_IMM(integer, integer, +)
+	CASE(sub_var_imm) VAR_IMM(integer, integer, -)
+	CASE(mul_var_imm) VAR_IMM(integer, integer, *)
+	CASE(div_var_imm) {
+		ROOM();
+		SLOT(index);
+		const value& lhs = frame[index];
+		EXPECT(lhs, integer);
+		const std::int32_t rhs = integer();
+		/* verifier only accepts immediate divisors that are neither */
+		if (checked) {
+			DIVISOR(lhs.integer, rhs);
+		}
+		*sp++ = value::of(lhs.integer / rhs);
+		NEXT();
+	}
+	CASE(addf_var_imm) VAR_IMM(floating, floating, +)
+	CASE(subf_var_imm) VAR_IMM(floating, floating, -)
+	CASE(mulf_var_imm) VAR_IMM(floating, floating, *)
+	CASE(divf_var_imm) VAR_IMM(floating, floating, /)
+	CASE(add_var_var) VAR_VAR(integer, +)
+	CASE(sub_var_var) VAR_VAR(integer, -)
+	CASE(mul_var_var) VAR_VAR(integer, *)
+	CASE(div_var_var) {
+		ROOM();
+		SLOT(first);
+		SLOT(second);
+		const value& lhs = frame[first];
+		const value& rhs = frame[second];
+		EXPECT(lhs, integer);
+		EXPECT(rhs, integer);
+		DIVISOR(lhs.integer, rhs.integer);
+		*sp++ = value::of(lhs.integer / rhs.integer);
+		NEXT();
+	}
+	CASE(addf_var_var) VAR_VAR(floating, +)
+	CASE(subf_var_var) VAR_VAR(floating, -)
+	CASE(mulf_var_var) VAR_VAR(floating, *)
+	CASE(divf_var_var) VAR_VAR(floating, /)
+	CASE(ret) STOP();
+	CASE(abort) STOP();
+
+#ifndef INTERPRETER_COMPUTED_GOTO
+	}
+#endif
+#undef PUSH_VAR_CAST
+#undef CAST
+#undef DEOPTIMIZE
+#undef QUICKEN
+#undef REWRITE
+#undef DIVISOR
+#undef VAR_VAR
+#undef VAR_IMM
+#undef ARITHMETIC
+#undef SLOT
+#undef EXPECT
+#undef ROOM
+#undef NEED
+#undef STOP
+#undef NEXT
+#undef CASE
+	return std::span<const value>(base, sp);
+}
@@ -0,0 +1,90 @@
+#include "ir.hpp"
+
+
+ir_value ir_function::add(const ir_instruction& instruction) {
+	if (blocks.empty()) {
+		start_block();
+	}
+	values.push_back(instruction);
+	ir_value value = static_cast<ir_value>(values.size() - 1);
+	blocks.back().instructions.push_back(value);
+	return value;
+}
+void ir_function::start_block() {
+	blocks.push_back(ir_block {});
+}
+bool ir_function::is_terminated() const {
+	return !blocks.empty() && !blocks.back().instructions.empty() &&
+		is_terminator(values[blocks.back().instructions.back()].op);
+}
+
+bool is_terminator(ir_opcode op) {
+	return op == ir_opcode::ret || op == ir_opcode::abort;
+}
+std::string to_string(ir_opcode op) {
+	switch (op) {
+	case ir_opcode::constant: return "const";
+	case ir_opcode::argument: return "arg";
+	case ir_opcode::copy: return "copy";
+	case ir_opcode::cast: return "cast";
+	case ir_opcode::add: return "add";
+	case ir_opcode::sub: return "sub";
+	case ir_opcode::mul: return "mul";
+	case ir_opcode::div: return "div";
+	case ir_opcode::ret: return "ret";
+	case ir_opcode::abort: return "abort";
+	}
+	return "";
+}
+
+static std::string value_name(ir_value value) {
+	return "%" + std::to_string(value);
+}
+static std::string constant_text(const OBJECT& constant) {
+	if (const int* integer = std::get_if<int>(&constant)) {
+		return std::to_string(*integer);
+	}
+	if (const double* floating = std::get_if<double>(&constant)) {
+		return std::to_string(*floating);
+	}
+	return "poison";
+}
+
+std::string ir_function::dump() const {
+	std::string str = "function " + (name.empty() ? std::string("global") : name) + "\n";
+	for (std::size_t index = 0; index < blocks.size(); ++index) {
+		str += "block " + std::to_string(index) + ":\n";
+		for (ir_value value : blocks[index].instructions) {
+			const ir_instruction& inst = values[value];
+			str += "\t";
+			if (!is_terminator(inst.op)) {
+				str += value_name(value) + " = ";
+			}
+			str += to_string(inst.op);
+			if (inst.type != object_type::none) {
+				str += " " + ::to_string(inst.type);
+			}
+			switch (inst.op) {
+			case ir_opcode::constant:
+				str += " " + constant_text(inst.constant);
+				break;
+			case ir_opcode::argument:
+				str += " " + std::to_string(inst.index);
+				break;
+			default:
+				if (inst.lhs != no_value) {
+					str += " " + value_name(inst.lhs);
+				}
+				if (inst.rhs != no_value) {
+					str += ", " + value_name(inst.rhs);
+				}
+				break;
+			}
+			if (inst.name != no_symbol) {
+				str += " ; " + std::string(interner::get_instance()->name(inst.name));
+			}
+			str += "\n";
+		}
+	}
+	return str;
+}
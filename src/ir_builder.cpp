@@ -0,0 +1,230 @@
+#include "ir_builder.hpp"
+
+
+std::vector<ir_function> ir_builder::build(const syntax_tree& tree, node_id root) {
+	std::vector<ir_function> functions(1);
+	std::vector<node_id> defined;
+	if (root != no_node && tree[root].kind == ast_kind::block) {
+		context con { .tree = tree, .function = functions.front(), .variables = {} };
+		build_statements(con, root, &defined);
+	}
+	/* a context holds a reference into `functions`, so they are all added
+	 * before any of them is built */
+	functions.resize(defined.size() + 1);
+	for (std::size_t index = 0; index < defined.size(); ++index) {
+		context con { .tree = tree, .function = functions[index + 1], .variables = {} };
+		build_function(con, defined[index]);
+	}
+	return functions;
+}
+
+void ir_builder::build_statements(context& con, node_id block, std::vector<node_id>* functions) {
+	const syntax_tree& tree = con.tree;
+	for (node_id id : tree.list(block)) {
+		const ast_node& node = tree[id];
+		switch (node.kind) {
+		case ast_kind::expr:
+			build_expression(con, node.lhs);
+			break;
+		case ast_kind::var_define: {
+			ir_value value;
+			if (node.lhs != no_node) {
+				value = build_expression(con, node.lhs);
+			} else {
+				/* alloc starts a variable at the zero of its type */
+				value = con.function.add(ir_instruction {
+					.op = ir_opcode::constant,
+					.type = node.type,
+					.constant = node.type == object_type::floating ? OBJECT(0.) : OBJECT(0)
+				});
+			}
+			set_variable(con, tree.slot(id), con.function.add(ir_instruction {
+				.op = ir_opcode::copy,
+				.type = con.function.values[value].type,
+				.lhs = value,
+				.name = node.sym
+			}));
+			break;
+		}
+		case ast_kind::_return: {
+			ir_value value = node.lhs != no_node ? build_expression(con, node.lhs) : no_value;
+			if (value == no_value || is_poison(con, value)) {
+				con.function.add(ir_instruction { .op = ir_opcode::abort });
+			} else {
+				con.function.add(ir_instruction { .op = ir_opcode::ret, .lhs = value });
+			}
+			con.function.start_block();
+			break;
+		}
+		case ast_kind::function:
+			if (functions) {
+				functions->push_back(id);
+			}
+			break;
+		default:
+			/* parse errors compile to nothing, as they always have */
+			break;
+		}
+	}
+}
+void ir_builder::build_function(context& con, node_id id) {
+	const syntax_tree& tree = con.tree;
+	const ast_node& node = tree[id];
+	con.function.name = tree.mangled_name(id);
+	std::span<const node_id> children = tree.list(id);
+	for (node_id child : children.first(node.list_split)) {
+		const ast_node& argument = tree[child];
+		if (argument.kind != ast_kind::var_define) {
+			continue;
+		}
+		con.function.arguments.push_back(variable {
+			.name = argument.sym,
+			.is_mutable = argument.tok == token_type::_mut,
+			.is_init = argument.lhs != no_node
+		});
+		set_variable(con, tree.slot(child), con.function.add(ir_instruction {
+			.op = ir_opcode::argument,
+			.type = argument.type,
+			.index = tree.slot(child),
+			.name = argument.sym
+		}));
+	}
+	if (node.lhs != no_node && tree[node.lhs].kind == ast_kind::block) {
+		build_statements(con, node.lhs, nullptr);
+	}
+}
+
+ir_value ir_builder::build_expression(context& con, node_id id) {
+	const syntax_tree& tree = con.tree;
+	/* post-order on an explicit stack. each node leaves its value, already
+	 * converted the way its parent wants, on `values` */
+	struct step {
+		node_id id;
+		bool expanded;
+	};
+	std::vector<step> work { step { .id = id, .expanded = false } };
+	std::vector<ir_value> values;
+	while (!work.empty()) {
+		step current = work.back();
+		work.pop_back();
+		const ast_node& node = tree[current.id];
+		if (!current.expanded) {
+			switch (node.kind) {
+			case ast_kind::parenthess:
+				work.push_back(step { .id = current.id, .expanded = true });
+				work.push_back(step { .id = node.lhs, .expanded = false });
+				continue;
+			case ast_kind::bin_op:
+				work.push_back(step { .id = current.id, .expanded = true });
+				work.push_back(step { .id = node.rhs, .expanded = false });
+				/* the target of `=` is written, never read */
+				if (node.tok != token_type::equal) {
+					work.push_back(step { .id = node.lhs, .expanded = false });
+				}
+				continue;
+			default:
+				break;
+			}
+		}
+
+		ir_value value;
+		switch (node.kind) {
+		case ast_kind::value:
+			if (node.tok != token_type::identifier) {
+				value = con.function.add(ir_instruction {
+					.op = ir_opcode::constant,
+					.type = node.type,
+					.constant = tree.literal(current.id)
+				});
+			} else {
+				slot_index slot = tree.slot(current.id);
+				value = slot < con.variables.size() && con.variables[slot] != no_value ?
+					con.variables[slot] : poison(con);
+			}
+			break;
+		case ast_kind::parenthess:
+			value = values.back();
+			values.pop_back();
+			break;
+		case ast_kind::bin_op: {
+			if (node.tok == token_type::equal) {
+				value = values.back();
+				values.pop_back();
+				const ast_node& target = tree[node.lhs];
+				if (target.kind != ast_kind::value || tree.slot(node.lhs) == no_slot || is_poison(con, value)) {
+					value = poison(con);
+					/* so that reading the variable later aborts too */
+					if (target.kind == ast_kind::value) {
+						set_variable(con, tree.slot(node.lhs), value);
+					}
+					break;
+				}
+				/* stored as the variable's own type */
+				object_type target_type = target.type;
+				object_type value_type = con.function.values[value].type;
+				if (target_type != value_type && evaluate_type(target_type, value_type) != object_type::none) {
+					value = convert(con, value, target_type);
+				}
+				value = con.function.add(ir_instruction {
+					.op = ir_opcode::copy,
+					.type = con.function.values[value].type,
+					.lhs = value,
+					.name = target.sym
+				});
+				set_variable(con, tree.slot(node.lhs), value);
+				break;
+			}
+			ir_value rhs = values.back();
+			values.pop_back();
+			ir_value lhs = values.back();
+			values.pop_back();
+			if (node.type == object_type::none || is_poison(con, lhs) || is_poison(con, rhs)) {
+				value = poison(con);
+				break;
+			}
+			ir_opcode op = ir_opcode::add;
+			switch (node.tok) {
+			case token_type::minus: op = ir_opcode::sub; break;
+			case token_type::asterisk: op = ir_opcode::mul; break;
+			case token_type::slash: op = ir_opcode::div; break;
+			default: break;
+			}
+			value = con.function.add(ir_instruction { .op = op, .type = node.type, .lhs = lhs, .rhs = rhs });
+			break;
+		}
+		default:
+			value = poison(con);
+			break;
+		}
+		if (node.cast != object_type::none) {
+			value = convert(con, value, node.cast);
+		}
+		values.push_back(value);
+	}
+	return values.back();
+}
+
+ir_value ir_builder::poison(context& con) {
+	return con.function.add(ir_instruction { .op = ir_opcode::constant, .constant = invalid_type() });
+}
+bool ir_builder::is_poison(context& con, ir_value value) {
+	return con.function.values[value].type == object_type::none;
+}
+ir_value ir_builder::convert(context& con, ir_value value, object_type to) {
+	if (is_poison(con, value)) {
+		return value;
+	}
+	if (con.function.values[value].type == to) {
+		return value;
+	}
+	return con.function.add(ir_instruction { .op = ir_opcode::cast, .type = to, .lhs = value });
+}
+void ir_builder::set_variable(context& con, slot_index slot, ir_value value) {
+	if (slot == no_slot) {
+		return;
+	}
+	if (slot >= con.variables.size()) {
+		con.variables.resize(slot + 1, no_value);
+	}
+	con.variables[slot] = value;
+}
@@ -0,0 +1,154 @@
+#include "ir_lowering.hpp"
+
+
+void ir_lowering::lower(const std::vector<ir_function>& functions, asm_context& con) {
+	for (const ir_function& function : functions) {
+		std::uint32_t frame_size = 0;
+		std::list<std::unique_ptr<instruct>> codes = lower(function, frame_size);
+		if (function.name.empty()) {
+			con.codes.splice(con.codes.end(), codes);
+			if (frame_size > con.frame.size()) {
+				con.frame.resize(frame_size);
+			}
+			continue;
+		}
+		asm_context::function_info info;
+		info.argument = function.arguments;
+		info.instruction = std::move(codes);
+		info.frame_size = frame_size;
+		con.functions.insert(interner::get_instance()->intern(function.name), std::move(info));
+	}
+}
+
+std::list<std::unique_ptr<instruct>> ir_lowering::lower(const ir_function& function, std::uint32_t& frame_size) {
+	context con {
+		.function = function,
+		.codes = {},
+		.uses = std::vector<std::uint32_t>(function.values.size(), 0),
+		.slots = std::vector<slot_index>(function.values.size(), no_slot)
+	};
+	for (const ir_block& block : function.blocks) {
+		for (ir_value value : block.instructions) {
+			const ir_instruction& inst = function.values[value];
+			if (inst.lhs != no_value) {
+				++con.uses[inst.lhs];
+			}
+			if (inst.rhs != no_value) {
+				++con.uses[inst.rhs];
+			}
+			/* the arguments keep the slots they come in */
+			if (inst.op == ir_opcode::argument && inst.index >= con.next_slot) {
+				con.next_slot = inst.index + 1;
+			}
+		}
+	}
+
+	for (const ir_block& block : function.blocks) {
+		for (ir_value value : block.instructions) {
+			const ir_instruction& inst = function.values[value];
+			switch (inst.op) {
+			case ir_opcode::ret:
+				emit(con, inst.lhs);
+				con.codes.push_back(std::make_unique<return_instruct>());
+				continue;
+			case ir_opcode::abort:
+				con.codes.push_back(std::make_unique<abort_instruct>());
+				continue;
+			case ir_opcode::constant:
+			case ir_opcode::argument:
+				/* pushed as they are wherever they are used */
+				continue;
+			default:
+				break;
+			}
+			if (con.uses[value] < 2) {
+				continue;
+			}
+			std::unique_ptr<alloc_instruct> alloc = std::make_unique<alloc_instruct>();
+			alloc->name = name_of(con, value);
+			alloc->slot = con.next_slot++;
+			alloc->type = inst.type;
+			con.codes.push_back(std::move(alloc));
+			emit(con, value);
+			std::unique_ptr<init_instruct> init = std::make_unique<init_instruct>();
+			init->lhs = name_of(con, value);
+			init->slot = con.next_slot - 1;
+			con.codes.push_back(std::move(init));
+			con.slots[value] = con.next_slot - 1;
+		}
+	}
+	frame_size = con.next_slot;
+	return std::move(con.codes);
+}
+
+void ir_lowering::emit(context& con, ir_value value) {
+	/* post-order on an explicit stack, like the tree walks */
+	struct step {
+		ir_value value;
+		bool expanded;
+	};
+	std::vector<step> work { step { .value = value, .expanded = false } };
+	while (!work.empty()) {
+		step current = work.back();
+		work.pop_back();
+		const ir_instruction& inst = con.function.values[current.value];
+		if (con.slots[current.value] != no_slot || inst.op == ir_opcode::argument) {
+			std::unique_ptr<push_instruct> push = std::make_unique<push_instruct>();
+			push->value = operand {
+				.type = operand_type::variable,
+				.value = invalid_type(),
+				.name = name_of(con, current.value),
+				.slot = con.slots[current.value] != no_slot ? con.slots[current.value] : inst.index
+			};
+			con.codes.push_back(std::move(push));
+			continue;
+		}
+		if (inst.op == ir_opcode::constant) {
+			std::unique_ptr<push_instruct> push = std::make_unique<push_instruct>();
+			push->value = operand { .type = operand_type::immidiate, .value = inst.constant };
+			con.codes.push_back(std::move(push));
+			continue;
+		}
+		if (inst.op == ir_opcode::copy) {
+			work.push_back(step { .value = inst.lhs, .expanded = false });
+			continue;
+		}
+		if (current.expanded) {
+			emit_operation(con, inst);
+			continue;
+		}
+		work.push_back(step { .value = current.value, .expanded = true });
+		if (inst.rhs != no_value) {
+			work.push_back(step { .value = inst.rhs, .expanded = false });
+		}
+		work.push_back(step { .value = inst.lhs, .expanded = false });
+	}
+}
+void ir_lowering::emit_operation(context& con, const ir_instruction& inst) {
+	if (inst.op == ir_opcode::cast) {
+		con.codes.push_back(std::make_unique<cast_instruct>(inst.type));
+		return;
+	}
+	if (inst.type == object_type::integer) {
+		switch (inst.op) {
+		case ir_opcode::add: con.codes.push_back(std::make_unique<add_instruct>()); break;
+		case ir_opcode::sub: con.codes.push_back(std::make_unique<sub_instruct>()); break;
+		case ir_opcode::mul: con.codes.push_back(std::make_unique<mul_instruct>()); break;
+		case ir_opcode::div: con.codes.push_back(std::make_unique<div_instruct>()); break;
+		default: break;
+		}
+	} else if (inst.type == object_type::floating) {
+		switch (inst.op) {
+		case ir_opcode::add: con.codes.push_back(std::make_unique<addf_instruct>()); break;
+		case ir_opcode::sub: con.codes.push_back(std::make_unique<subf_instruct>()); break;
+		case ir_opcode::mul: con.codes.push_back(std::make_unique<mulf_instruct>()); break;
+		case ir_opcode::div: con.codes.push_back(std::make_unique<divf_instruct>()); break;
+		default: break;
+		}
+	}
+}
+symbol ir_lowering::name_of(context& con, ir_value value) {
+	/* a value that belongs to no variable has no name, the listing shows
+	 * its slot */
+	return con.function.values[value].name;
+}
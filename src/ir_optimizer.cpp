@@ -0,0 +1,120 @@
+#include "ir_optimizer.hpp"
+#include <bit>
+#include <map>
+#include <tuple>
+
+
+void ir_optimizer::run(ir_function& function) {
+	propagate_copies(function);
+	eliminate_common_subexpressions(function);
+	eliminate_dead_code(function);
+}
+
+void ir_optimizer::propagate_copies(ir_function& function) {
+	std::vector<ir_value> replacement(function.values.size(), no_value);
+	for (const ir_block& block : function.blocks) {
+		for (ir_value value : block.instructions) {
+			ir_instruction& inst = function.values[value];
+			if (inst.op != ir_opcode::copy) {
+				continue;
+			}
+			/* a copy comes after its operand, whose own copies are already
+			 * resolved, so one step reaches the original */
+			ir_value source = replacement[inst.lhs] != no_value ? replacement[inst.lhs] : inst.lhs;
+			replacement[value] = source;
+			if (function.values[source].name == no_symbol) {
+				function.values[source].name = inst.name;
+			}
+		}
+	}
+	replace_uses(function, replacement);
+}
+
+void ir_optimizer::eliminate_common_subexpressions(ir_function& function) {
+	/* value numbering: the key is everything an instruction computes from */
+	using key = std::tuple<ir_opcode, object_type, ir_value, ir_value, std::size_t, std::uint64_t, std::uint32_t>;
+	auto constant_bits = [](const OBJECT& constant) -> std::uint64_t {
+		if (const int* integer = std::get_if<int>(&constant)) {
+			return static_cast<std::uint64_t>(static_cast<std::uint32_t>(*integer));
+		}
+		if (const double* floating = std::get_if<double>(&constant)) {
+			return std::bit_cast<std::uint64_t>(*floating);
+		}
+		return 0;
+	};
+
+	std::map<key, ir_value> known;
+	std::vector<ir_value> replacement(function.values.size(), no_value);
+	for (const ir_block& block : function.blocks) {
+		for (ir_value value : block.instructions) {
+			ir_instruction& inst = function.values[value];
+			/* operands first, so equal trees get equal keys bottom up */
+			if (inst.lhs != no_value && replacement[inst.lhs] != no_value) {
+				inst.lhs = replacement[inst.lhs];
+			}
+			if (inst.rhs != no_value && replacement[inst.rhs] != no_value) {
+				inst.rhs = replacement[inst.rhs];
+			}
+			if (is_terminator(inst.op) || inst.op == ir_opcode::copy) {
+				continue;
+			}
+			key id { inst.op, inst.type, inst.lhs, inst.rhs, inst.constant.index(), constant_bits(inst.constant), inst.index };
+			auto [itr, inserted] = known.try_emplace(id, value);
+			if (!inserted) {
+				replacement[value] = itr->second;
+				if (function.values[itr->second].name == no_symbol) {
+					function.values[itr->second].name = inst.name;
+				}
+			}
+		}
+	}
+}
+
+void ir_optimizer::eliminate_dead_code(ir_function& function) {
+	/* there are no branches, so a block is only entered by falling out of
+	 * the one before it, and nothing after a terminator is reachable */
+	std::size_t reachable = 0;
+	while (reachable < function.blocks.size()) {
+		const ir_block& block = function.blocks[reachable++];
+		if (!block.instructions.empty() && is_terminator(function.values[block.instructions.back()].op)) {
+			break;
+		}
+	}
+	function.blocks.resize(reachable);
+
+	/* a value is live when a terminator or a live value uses it. operands
+	 * come before their users, so one backward sweep finds them all. */
+	std::vector<bool> live(function.values.size(), false);
+	for (auto block = function.blocks.rbegin(); block != function.blocks.rend(); ++block) {
+		for (auto itr = block->instructions.rbegin(); itr != block->instructions.rend(); ++itr) {
+			const ir_instruction& inst = function.values[*itr];
+			if (!is_terminator(inst.op) && !live[*itr]) {
+				continue;
+			}
+			live[*itr] = true;
+			if (inst.lhs != no_value) {
+				live[inst.lhs] = true;
+			}
+			if (inst.rhs != no_value) {
+				live[inst.rhs] = true;
+			}
+		}
+	}
+	for (ir_block& block : function.blocks) {
+		std::erase_if(block.instructions, [&live](ir_value value) { return !live[value]; });
+	}
+}
+
+void ir_optimizer::replace_uses(ir_function& function, const std::vector<ir_value>& replacement) {
+	for (const ir_block& block : function.blocks) {
+		for (ir_value value : block.instructions) {
+			ir_instruction& inst = function.values[value];
+			if (inst.lhs != no_value && replacement[inst.lhs] != no_value) {
+				inst.lhs = replacement[inst.lhs];
+			}
+			if (inst.rhs != no_value && replacement[inst.rhs] != no_value) {
+				inst.rhs = replacement[inst.rhs];
+			}
+		}
+	}
+}
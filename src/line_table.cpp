@@ -0,0 +1,67 @@
+#include "line_table.hpp"
+#include <algorithm>
+#include <cstring>
+
+
+line_table::line_table() :
+	_line_starts { 0 },
+	_parts(),
+	_part_starts(),
+	_size(0)
+{}
+line_table::line_table(std::string_view source) :
+	line_table()
+{
+	append(source);
+}
+
+void line_table::append(std::string_view text) {
+	if (text.empty()) {
+		return;
+	}
+	_parts.push_back(text);
+	_part_starts.push_back(_size);
+	const char* begin = text.data();
+	const char* end = text.data() + text.size();
+	for (const char* p = begin; p < end;) {
+		const void* newline = std::memchr(p, '\n', end - p);
+		if (!newline) {
+			break;
+		}
+		p = static_cast<const char*>(newline) + 1;
+		_line_starts.push_back(static_cast<std::uint32_t>(_size + (p - begin)));
+	}
+	_size = static_cast<std::uint32_t>(_size + text.size());
+}
+
+source_location line_table::locate(std::uint32_t offset) const {
+	/* the last line that starts at or before `offset` */
+	std::vector<std::uint32_t>::const_iterator next =
+		std::upper_bound(_line_starts.begin(), _line_starts.end(), offset);
+	std::uint32_t line = static_cast<std::uint32_t>(next - _line_starts.begin() - 1);
+
+	/* count the bytes from the line start to `offset` that begin a character */
+	std::uint32_t col = 0;
+	std::uint32_t pos = _line_starts[line];
+	std::size_t part = std::upper_bound(_part_starts.begin(), _part_starts.end(), pos) - _part_starts.begin();
+	while (pos < offset && part > 0 && part - 1 < _parts.size()) {
+		std::string_view text = _parts[part - 1];
+		std::uint32_t part_end = _part_starts[part - 1] + static_cast<std::uint32_t>(text.size());
+		std::uint32_t stop = std::min(offset, part_end);
+		for (; pos < stop; ++pos) {
+			unsigned char c = static_cast<unsigned char>(text[pos - _part_starts[part - 1]]);
+			col += (c & 0xc0) != 0x80;
+		}
+		++part;
+	}
+	return source_location {
+		.line = line,
+		.col = col + (offset - pos)
+	};
+}
+std::size_t line_table::line_count() const {
+	return _line_starts.size();
+}
+std::uint32_t line_table::size() const {
+	return _size;
+}
@@ -1,44 +1,133 @@
 #include <iostream>
-#include <fstream>
+#include <optional>
 #include <string>
 #include "utf8_char.hpp"
 #include "tokenize.hpp"
 #include "parser.hpp"
 #include "asm.hpp"
+#include "compile_unit.hpp"
+#include "ir_builder.hpp"
+#include "ir_optimizer.hpp"
+#include "ir_lowering.hpp"
+#include "peephole_optimizer.hpp"
+#include "superinstruction_selector.hpp"
+#include "interpreter.hpp"
+#include "verifier.hpp"
+#include "register_machine.hpp"
+#include "source_file.hpp"
 
 
 int main(int argc, const char** argv) {
-	if (argc == 1) {
+	const char* path = nullptr;
+	bool parallel_lex = false;
+	bool dump_ir = false;
+	bool peephole_report = false;
+	/* the stack machine unless --engine=register */
+	bool register_engine = false;
+	for (int index = 1; index < argc; ++index) {
+		std::string arg = argv[index];
+		if (arg == "--parallel-lex") {
+			parallel_lex = true;
+		} else if (arg == "--dump-ir") {
+			dump_ir = true;
+		} else if (arg == "--peephole-report") {
+			peephole_report = true;
+		} else if (arg == "--engine=stack") {
+			register_engine = false;
+		} else if (arg == "--engine=register") {
+			register_engine = true;
+		} else {
+			path = argv[index];
+		}
+	}
+	if (!path) {
 		std::cout << "no input" << std::endl;
 		return 1;
 	}
-	std::ifstream in(argv[1]);
-	if (in.fail()) {
-		std::cout << "could not found file: " << argv[1] << std::endl;
-		return 2;
+	std::unique_ptr<compile_unit> unit;
+	if (std::string(path) == "-") {
+		unit = std::make_unique<compile_unit>(std::cin);
+	} else {
+		source_file file(path);
+		if (file.is_too_large()) {
+			std::cout << "file is too large: " << path << " (4 GiB or more)" << std::endl;
+			return 2;
+		}
+		if (!file.is_open()) {
+			std::cout << "could not found file: " << path << std::endl;
+			return 2;
+		}
+		unit = std::make_unique<compile_unit>(std::move(file));
+	}
+	if (parallel_lex) {
+		unit->tokenize_parallel();
 	}
-	std::string source((std::istreambuf_iterator<char>(in)), (std::istreambuf_iterator<char>()));
-	source.push_back('\0');
 
-	std::vector<token> tokens = lexer::tokenize(source);
-	std::unique_ptr<ast_base_node> node = parser::parse(tokens);
-	if (!node) {
+	const syntax_tree& tree = unit->parse();
+	if (unit->is_too_large()) {
+		std::cout << "source is too large (4 GiB or more)" << std::endl;
+		return 2;
+	}
+	if (tree.root() == no_node) {
 		std::cout << "failed to build AST" << std::endl;
 		return 3;
 	}
-	std::cout << node->log("") << std::endl;
+	std::cout << tree.log(tree.root(), "") << std::endl;
+	for (const type_checker::error& error : unit->type_errors()) {
+		/* lines and columns count from one, as editors show them */
+		source_location at = unit->locate(error.offset);
+		std::cout << "type error at " << at.line + 1 << ":" << at.col + 1 << ": " << error.message << std::endl;
+	}
+	if (!unit->type_errors().empty()) {
+		/* the code would refer to variables that have no slot */
+		return 4;
+	}
 	std::cout << "===========" << std::endl;
 
-	asm_context con;
-	node->encode(con);
-	for (const std::unique_ptr<instruct>& inst : con.codes) {
-		std::cout << inst->log("") << std::endl;
+	unit->fold_constants();
+	std::vector<ir_function> functions = ir_builder::build(tree, tree.root());
+	if (dump_ir) {
+		for (const ir_function& function : functions) {
+			std::cout << function.dump();
+		}
+		std::cout << "=========== optimized" << std::endl;
+	}
+	for (ir_function& function : functions) {
+		ir_optimizer::run(function);
+		if (dump_ir) {
+			std::cout << function.dump();
+		}
 	}
-	for (const std::unique_ptr<instruct>& inst : con.codes) {
-		inst->execute(con);
-		if (con.is_abort) {
-			break;
+	if (dump_ir) {
+		std::cout << "===========" << std::endl;
+	}
+	std::vector<OBJECT> stack;
+	if (register_engine) {
+		register_code code = register_code::compile(functions.front());
+		std::cout << code.disassemble();
+		if (std::optional<verifier::error> error = verifier::verify(code)) {
+			std::cout << "verify error at " << error->offset << ": " << error->message << std::endl;
+			return 5;
+		}
+		stack = register_machine::evaluate(code);
+	} else {
+		asm_context con;
+		ir_lowering::lower(functions, con);
+		peephole_optimizer::report removed = peephole_optimizer().run(con);
+		if (peephole_report) {
+			std::cout << removed.log("peephole ");
+		}
+		superinstruction_selector::select(con);
+		for (const std::unique_ptr<instruct>& inst : con.codes) {
+			std::cout << inst->log("") << std::endl;
+		}
+		/* the instructions above are only the listing; the bytecode runs */
+		bytecode program = bytecode::compile(con);
+		if (std::optional<verifier::error> error = verifier::verify(program)) {
+			std::cout << "verify error at " << error->offset << ": " << error->message << std::endl;
+			return 5;
 		}
+		stack = interpreter::evaluate(program);
 	}
 
 	std::cout << "--------------" << std::endl;
@@ -53,8 +142,8 @@ int main(int argc, const char** argv) {
 			std::cout << "invalid type" << std::endl;
 		}
 	};
-	if (!con.stack.empty()) {
-		std::visit(print{}, con.stack.back().value);
+	if (!stack.empty()) {
+		std::visit(print{}, stack.back());
 	}
 
 	return 0;
@@ -1,578 +1,266 @@
 #include "parser.hpp"
-
-
-std::string ast_error_node::log(const std::string& prefix) const {
-	if (!child) {
-		return prefix + "<error>" + message + "</error>\n";
-	}
-	std::string str = prefix + "<error message=\"" + message + "\">\n";
-	str += child->log(prefix + "\t");
-	return str + prefix + "</error>\n";
-}
-void ast_error_node::encode(asm_context& con) const {}
-object_type ast_error_node::type() const { return object_type::none; }
-ast_base_node* ast_error_node::static_class() const {
-	static ast_error_node instance;
-	return &instance;
-}
-
-std::string ast_value_node::log(const std::string& prefix) const {
-	return prefix + "<value>" + value.str + "</value>\n";
-}
-void ast_value_node::encode(asm_context& con) const {
-	std::unique_ptr<push_instruct> inst = std::make_unique<push_instruct>();
-	if (value.type == token_type::identifier) {
-		inst->value = operand {
-			.type = operand_type::variable,
-			.value = value.str
-		};
-		con.codes.push_back(std::move(inst));
-		return;
-	}
-	OBJECT object;
-	switch (type()) {
-	case object_type::integer:
-		object = std::atoi(value.str.c_str()); 
-		break;
-	case object_type::floating:
-		object = std::atof(value.str.c_str()); 
-		break;
-	default:
-		object = invalid_type();
-		break;
-	}
-	inst->value = operand {
-						.type = operand_type::immidiate,
-						.value = object
-					};
-	con.codes.push_back(std::move(inst));
-}
-object_type ast_value_node::type() const {
-	if (value.type == token_type::number) {
-		return object_type::integer;
-	}
-	if (value.type == token_type::floating) {
-		return object_type::floating;
-	}
-	if (value.type == token_type::identifier) {
-		return var_type;
-	}
-	return object_type::none;
-}
-ast_base_node* ast_value_node::static_class() const {
-	static ast_value_node instance;
-	return &instance;
-}
-
-std::string ast_parenthess_node::log(const std::string& prefix) const {
-	std::string str = prefix + "<parenthess>\n";
-	if (expr) {
-		str += expr->log(prefix + "\t");
-	}
-	return str + prefix + "</parenthess>\n";
-}
-void ast_parenthess_node::encode(asm_context& con) const {
-	if (expr) {
-		expr->encode(con);
-	}
-}
-object_type ast_parenthess_node::type() const {
-	return expr ? expr->type() : object_type::none;
-}
-ast_base_node* ast_parenthess_node::static_class() const {
-	static ast_parenthess_node instance;
-	return &instance;
+#include <array>
+#include <vector>
+
+
+/* adding a binary operator is one entry here plus its encoding. `=` is
+ * only accepted where a statement starts, so the other expressions start
+ * climbing at additive. */
+static constexpr std::array<parser::operator_info, token_type_count> make_operator_table() {
+	std::array<parser::operator_info, token_type_count> table {};
+	auto set = [&table](token_type type, parser::precedence power, parser::associativity assoc) {
+		table[static_cast<std::size_t>(type)] = parser::operator_info { .power = power, .assoc = assoc };
+	};
+	set(token_type::equal, parser::precedence::assignment, parser::associativity::left);
+	set(token_type::plus, parser::precedence::additive, parser::associativity::left);
+	set(token_type::minus, parser::precedence::additive, parser::associativity::left);
+	set(token_type::asterisk, parser::precedence::multiplicative, parser::associativity::left);
+	set(token_type::slash, parser::precedence::multiplicative, parser::associativity::left);
+	return table;
+}
+static constexpr std::array<parser::operator_info, token_type_count> operator_table = make_operator_table();
+
+node_id parser::make_error(context& con, std::string_view message, node_id child) {
+	return con.tree.add(ast_node {
+		.kind = ast_kind::error,
+		.lhs = child,
+		.offset = con.itr->offset,
+		.str = message
+	});
 }
 
-std::string ast_bin_op_node::log(const std::string& prefix) const {
-	std::string str = prefix + "<operator op=\"" + op.str + "\">\n";
-	if (lhs) {
-		str += lhs->log(prefix + "\t");
-	}
-	if (rhs) {
-		str += rhs->log(prefix + "\t");
-	}
-	return str + prefix + "</operator>\n";
-}
-void ast_bin_op_node::encode(asm_context& con) const {
-	if (lhs) {
-		lhs->encode(con);
-		if (lhs->type() != type()) {
-			con.codes.push_back(std::make_unique<cast_instruct>(type()));
-		}
-	}
-	if (rhs) {
-		rhs->encode(con);
-		if (rhs->type() != type()) {
-			con.codes.push_back(std::make_unique<cast_instruct>(type()));
-		}
-	}
-
-	if (op.str == "=") {
-		ast_value_node* node = static_cast<ast_value_node*>(lhs.get());
-		if (node->type() != rhs->type() &&
-			evaluate_type(node->type(), rhs->type()) != object_type::none) {
-			con.codes.push_back(std::make_unique<cast_instruct>(node->type()));
-		}
-		if (node->type() == object_type::integer) {
-			std::unique_ptr<mov_instruct> mov_inst = std::make_unique<mov_instruct>();
-			mov_inst->lhs = node->value.str;
-			con.codes.push_back(std::move(mov_inst));
-		} else if (node->type() == object_type::floating) {
-			std::unique_ptr<movf_instruct> mov_inst = std::make_unique<movf_instruct>();
-			mov_inst->lhs = node->value.str;
-			con.codes.push_back(std::move(mov_inst));
-		}
-		return;
-	}
-
-	if (type() == object_type::integer) {
-		if (op.str == "+") {
-			con.codes.push_back(std::make_unique<add_instruct>());
-		} else if (op.str == "-") {
-			con.codes.push_back(std::make_unique<sub_instruct>());
-		} else if (op.str == "*") {
-			con.codes.push_back(std::make_unique<mul_instruct>());
-		} else if (op.str == "/") {
-			con.codes.push_back(std::make_unique<div_instruct>());
-		}
-	} else if (type() == object_type::floating) {
-		if (op.str == "+") {
-			con.codes.push_back(std::make_unique<addf_instruct>());
-		} else if (op.str == "-") {
-			con.codes.push_back(std::make_unique<subf_instruct>());
-		} else if (op.str == "*") {
-			con.codes.push_back(std::make_unique<mulf_instruct>());
-		} else if (op.str == "/") {
-			con.codes.push_back(std::make_unique<divf_instruct>());
+node_id parser::try_parse_value(context& con) {
+	if (con.itr->type == token_type::identifier){
+		token value = *con.itr++;
+		node_id node = con.tree.add(ast_node {
+			.kind = ast_kind::value,
+			.tok = value.type,
+			.sym = value.sym,
+			.offset = value.offset,
+			.str = value.str
+		});
+		const variable* var = con.symbols.variables.find(value.sym);
+		if (!var) {
+			return make_error(con, "value type is not appropriate", node);
 		}
-	}
-}
-object_type ast_bin_op_node::type() const {
-	object_type lhs_type = lhs ? lhs->type() : object_type::none;
-	object_type rhs_type = rhs ? rhs->type() : object_type::none;
-	return evaluate_type(lhs_type, rhs_type);
-}
-ast_base_node* ast_bin_op_node::static_class() const {
-	static ast_bin_op_node instance;
-	return &instance;
-}
-
-std::string ast_expr_node::log(const std::string& prefix) const {
-	if (expr) {
-		return expr->log(prefix);
-	}
-	return "";
-}
-void ast_expr_node::encode(asm_context& con) const {
-	if (expr) {
-		expr->encode(con);
-	}
-	con.codes.push_back(std::make_unique<pop_instruct>());
-}
-object_type ast_expr_node::type() const {
-	return expr ? expr->type() : object_type::none;
-}
-ast_base_node* ast_expr_node::static_class() const {
-	static ast_expr_node instance;
-	return &instance;
+		con.tree[node].type = object_type(var->value.index());
+		return node;
+	} else if (con.itr->type != token_type::number &&
+				con.itr->type != token_type::floating) {	
+		return make_error(con, "value type is not appropriate");
+	}
+	token value = *con.itr++;
+	return con.tree.add(ast_node {
+		.kind = ast_kind::value,
+		.tok = value.type,
+		.offset = value.offset,
+		.str = value.str
+	});
 }
+node_id parser::try_parse_expression(context& con, precedence min_power) {
+	/* operators still waiting for their right operand and the open
+	 * parentheses around them are kept on heap stacks, so neither the
+	 * nesting depth nor the length of a chain is bounded by the call stack */
+	struct pending {
+		token_type op;
+		precedence power;
+		std::uint32_t offset;
+	};
+	std::vector<pending> operators;
+	std::vector<node_id> operands;
+	std::size_t open_parens = 0;
+	auto reduce = [&]() {
+		pending op = operators.back();
+		operators.pop_back();
+		node_id rhs = operands.back();
+		operands.pop_back();
+		node_id lhs = operands.back();
+		operands.back() = make_bin_op(con, op.op, op.offset, lhs, rhs);
+	};
 
-std::string ast_var_define_node::log(const std::string& prefix) const {
-	std::string type_name;
-	if (modifier.type == token_type::_mut) {
-		type_name = "mut ";
-	} else if (modifier.type == token_type::_const) {
-		type_name = "const ";
-	}
-	if (var_type.type == token_type::_int) {
-		type_name += "int";
-	} else if (var_type.type == token_type::_float) {
-		type_name += "float";
-	}
-	std::string str = prefix + "<define name=\"" + name.str +"\" type=\"" + type_name + "\">\n";
-	if (initial_value) {
-		str += initial_value->log(prefix + "\t");
-	}
-	return str + prefix + "</define>\n";
-}
-void ast_var_define_node::encode(asm_context& con) const {
-	std::unique_ptr<alloc_instruct> instruct = std::make_unique<alloc_instruct>();
-	instruct->is_mutable = modifier.type == token_type::_mut ? true : false;
-	instruct->name = name.str;
-	if (var_type.type == token_type::_int) {
-		instruct->type = object_type::integer;
-	} else if (var_type.type == token_type::_float) {
-		instruct->type = object_type::floating;
-	}
-	con.codes.push_back(std::move(instruct));
-	if (initial_value) {
-		initial_value->encode(con);
-		if (initial_value->type() != type()) {
-			std::unique_ptr<cast_instruct> cast_inst = std::make_unique<cast_instruct>(type());
-			con.codes.push_back(std::move(cast_inst));
+	for (;;) {
+		while (con.itr->type == token_type::l_paren) {
+			operators.push_back(pending { .op = token_type::l_paren, .power = precedence::none, .offset = con.itr->offset });
+			++con.itr;
+			++open_parens;
 		}
-		std::unique_ptr<init_instruct> instruct = std::make_unique<init_instruct>();
-		instruct->lhs = name.str;
-		con.codes.push_back(std::move(instruct));
-	}
-}
-object_type ast_var_define_node::type() const {
-	if (var_type.type == token_type::_int) {
-		return object_type::integer;
-	}
-	if (var_type.type == token_type::_float) {
-		return object_type::floating;
-	}
-	return object_type::none;
-}
-ast_base_node* ast_var_define_node::static_class() const {
-	static ast_var_define_node instance;
-	return &instance;
-}
-
-std::string ast_return_node::log(const std::string& prefix) const {
-	std::string str = prefix + "<return>\n";
-	if (expr) {
-		str += expr->log(prefix + "\t");
-	}
-	return str + prefix + "</return>\n";
-}
-void ast_return_node::encode(asm_context& con) const {
-	if (expr) {
-		expr->encode(con);
-	}
-	con.codes.push_back(std::make_unique<return_instruct>());
-}
-object_type ast_return_node::type() const {
-	return expr ? expr->type() : object_type::none;
-}
-ast_base_node* ast_return_node::static_class() const {
-	static ast_return_node instance;
-	return &instance;
-}
-
-std::string ast_block_node::log(const std::string& prefix) const {
-	std::string str = prefix + "<block name=\"" + block_name + "\">\n";
-	for (const std::unique_ptr<ast_base_node>& node : nodes) {
-		str += node->log(prefix + "\t");
-	}
-	return str + prefix + "</block>\n";
-}
-void ast_block_node::encode(asm_context& con) const {
-	for (const std::unique_ptr<ast_base_node>& node : nodes) {
-		node->encode(con);
-	}
-}
-object_type ast_block_node::type() const {
-	return object_type::none;
-}
-ast_base_node* ast_block_node::static_class() const {
-	static ast_block_node instance;
-	return &instance;
-}
-
-std::string ast_function_node::log(const std::string& prefix) const {
-	std::string ret = prefix + "<function name=\"" + get_mangling_name() + "\">\n";
-	ret += prefix + "\t<return type=\"";
-	ret += std::visit(token_node_str_visit {}, return_type.modifier);
-	ret += " ";
-	ret += std::visit(token_node_str_visit {}, return_type.var_type);
-	ret += "\"></return>\n";
+		operands.push_back(try_parse_value(con));
+
+		for (;;) {
+			const operator_info& info = operator_table[static_cast<std::size_t>(con.itr->type)];
+			precedence floor = open_parens ? precedence::additive : min_power;
+			if (info.power != precedence::none && info.power >= floor) {
+				/* a left associative operator folds the pending ones of its
+				 * own level into its lhs, a right associative one only the
+				 * tighter ones */
+				while (!operators.empty() && operators.back().op != token_type::l_paren &&
+					(operators.back().power > info.power ||
+					(operators.back().power == info.power && info.assoc == associativity::left))) {
+					reduce();
+				}
+				operators.push_back(pending { .op = con.itr->type, .power = info.power, .offset = con.itr->offset });
+				++con.itr;
+				break;
+			}
 
-	for (const std::unique_ptr<ast_base_node>& ptr : arguments) {
-		if (ptr->static_class() == ast_var_define_node().static_class()) {
-			ast_var_define_node* node = static_cast<ast_var_define_node*>(ptr.get());
-			std::string type_name;
-			if (node->modifier.type == token_type::_mut) {
-				type_name = "mut ";
-			} else if (node->modifier.type == token_type::_const) {
-				type_name = "const ";
+			while (!operators.empty() && operators.back().op != token_type::l_paren) {
+				reduce();
 			}
-			if (node->var_type.type == token_type::_int) {
-				type_name += "int";
-			} else if (node->var_type.type == token_type::_float) {
-				type_name += "float";
+			if (operators.empty()) {
+				return operands.back();
 			}
-			ret += prefix + "\t<argument name=\"" + node->name.str + "\" ";
-			ret += "type=\"" + type_name +"\"></argument>\n";
-		} else {
-			ret += ptr->log(prefix + "\t");
-		}
-		
-	}
-	
-	if (block) {
-		if (ast_block_node* casted_block = dynamic_cast<ast_block_node*>(block.get())) {
-			casted_block->block_name = "implement";
-			ret += block->log(prefix + "\t");
-			casted_block->block_name = get_mangling_name();
-		}
-	}
-	if (!error_list.empty()) {
-		ret += prefix + "\t<error>\n";
-		for (const std::unique_ptr<ast_base_node>& ptr : error_list) {
-			ret += ptr->log(prefix + "\t\t");
+			std::uint32_t paren = operators.back().offset;
+			operators.pop_back();
+			--open_parens;
+			if (con.itr->type != token_type::r_paren) {
+				++con.itr;
+				operands.back() = make_error(con, "not found `)`");
+				continue;
+			}
+			++con.itr;
+			operands.back() = con.tree.add(ast_node { .kind = ast_kind::parenthess, .lhs = operands.back(), .offset = paren });
 		}
-		ret += prefix + "\t</error>\n";
 	}
-	ret += prefix + "</function>\n";
-	return ret;
 }
-void ast_function_node::encode(asm_context& con) const {
-	asm_context::function_info info;
-	{
-		asm_context dmy_con;
-		block->encode(dmy_con);
-		info.instruction = std::move(dmy_con.codes);
+node_id parser::make_bin_op(context& con, token_type op, std::uint32_t offset, node_id lhs, node_id rhs) {
+	node_id node = con.tree.add(ast_node { .kind = ast_kind::bin_op, .tok = op, .lhs = lhs, .rhs = rhs, .offset = offset });
+	if (op != token_type::equal) {
+		return node;
 	}
-	for (const std::unique_ptr<ast_base_node>& ptr : arguments) {
-		if (ptr->static_class() == ast_var_define_node().static_class()) {
-			ast_var_define_node* node = static_cast<ast_var_define_node*>(ptr.get());
-			variable var;
-			var.is_init = node->initial_value ? true : false;
-			var.is_mutable = node->modifier.type == token_type::_mut;
-			var.name = node->name.str;
-			info.argument.push_back(std::move(var));
-		}
+	/* whether the value can be stored is up to type_checker */
+	if (con.tree[lhs].kind != ast_kind::value) {
+		/* is lhs assignable? */
+		return make_error(con, "assign operator's lhs is not a variable", node);
 	}
-
-	con.functions.insert({get_mangling_name(), std::move(info)});
-}
-object_type ast_function_node::type() const {
-	return object_type::none;
-}
-ast_base_node* ast_function_node::static_class() const {
-	static ast_block_node instance;
-	return &instance;
-}
-std::string ast_function_node::get_mangling_name() const {
-	std::string mangled_name = "fn@" + std::visit(token_node_str_visit {}, name) + "(";
-	std::string sep = "";
-	
-	for (const std::unique_ptr<ast_base_node>& ptr : arguments) {
-		if (ptr->static_class() == ast_var_define_node().static_class()) {
-			ast_var_define_node* node = static_cast<ast_var_define_node*>(ptr.get());
-			mangled_name += std::exchange(sep, ",");
-			mangled_name += node->modifier.str + " " + node->var_type.str;
-		}
+	const variable* var = con.symbols.variables.find(con.tree[lhs].sym);
+	if (!var || !var->is_mutable) {
+		/* is lhs mutable? */
+		return make_error(con, "assign operator's lhs is not mutable", node);
 	}
-	return mangled_name + ")";
+	return node;
 }
 
-std::unique_ptr<ast_base_node> parser::try_parse_parenthess(context& con) {
-	if (con.itr->str != "(") {
-		return nullptr;
+node_id parser::try_parse_return(context& con) {
+	if (con.itr->type != token_type::_return) {
+		return no_node;
 	}
+	std::uint32_t offset = con.itr->offset;
 	++con.itr;
-
-	std::unique_ptr<ast_base_node> expr = parser::try_parse_add_sub(con);
-	if (!expr) {
-		std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-		error->message = "empty parenthess";
-		++con.itr;
-		return error;
-	}
-	if (con.itr->str != ")") {
-		std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-		error->message = "not found `)`";
-		++con.itr;
-		return error;
+	node_id expr = try_parse_expression(con, precedence::additive);
+	if (con.itr->type != token_type::semicolon) {
+		return make_error(con, "not found semicolon");
 	}
 	++con.itr;
-	std::unique_ptr<ast_parenthess_node> node = std::make_unique<ast_parenthess_node>();
-	node->expr = std::move(expr);
-	return std::move(node);
-}
-std::unique_ptr<ast_base_node> parser::try_parse_value(context& con) {
-	std::unique_ptr<ast_base_node> expr = parser::try_parse_parenthess(con);
-	if (expr) {
-		return std::move(expr);
-	}
-
-	if (con.itr->type == token_type::identifier){
-		std::unique_ptr<ast_value_node> node = std::make_unique<ast_value_node>();
-		node->value = *con.itr++;
-		auto itr = con.variables.find(node->value.str);
-		if (itr == con.variables.end()) {
-			node->var_type = object_type::none;
-			std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-			error->message = "value type is not appropriate";
-			error->child = std::move(node);
-			return std::move(error);
-		}
-		node->var_type = object_type(itr->second.value.index());
-		return std::move(node);
-	} else if (con.itr->type != token_type::number &&
-				con.itr->type != token_type::floating) {	
-		std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-		error->message = "value type is not appropriate";
-		return std::move(error);
-	}
-	std::unique_ptr<ast_value_node> node = std::make_unique<ast_value_node>();
-	node->value = *con.itr++;
-	return std::move(node);
-}
-std::unique_ptr<ast_base_node> parser::try_parse_mul_div(context& con) {
-	std::unique_ptr<ast_base_node> lhs = try_parse_value(con);
-
-	while (lhs) {
-		if (con.itr->str == "*" || con.itr->str == "/") {
-			std::unique_ptr<ast_bin_op_node> node = std::make_unique<ast_bin_op_node>();
-			node->op = *con.itr++;
-			node->lhs = std::move(lhs);
-			node->rhs = try_parse_value(con);
-			lhs = std::move(node);
-		}
-		else {
-			return lhs;
-		}
-	}
-	return nullptr;
-}
-std::unique_ptr<ast_base_node> parser::try_parse_add_sub(context& con) {
-	std::unique_ptr<ast_base_node> lhs = try_parse_mul_div(con);
+	return con.tree.add(ast_node { .kind = ast_kind::_return, .lhs = expr, .offset = offset });
+}
+node_id parser::try_parse_stmt(context& con) {
+	/* functions whose body is still being parsed, innermost last. keeping
+	 * them here instead of recursing lets functions nest as deep as memory
+	 * allows */
+	struct open_function {
+		node_id function;
+		node_id block;
+		std::size_t mark;
+	};
+	std::vector<open_function> open;
 
-	while (lhs) {
-		if (con.itr->str == "+" || con.itr->str == "-") {
-			std::unique_ptr<ast_bin_op_node> node = std::make_unique<ast_bin_op_node>();
-			node->op = *con.itr++;
-			node->lhs = std::move(lhs);
-			node->rhs = try_parse_mul_div(con);
-			lhs = std::move(node);
+	for (;;) {
+		node_id node;
+		/* a statement that consumes no token would be parsed again forever */
+		bool is_stuck = false;
+		if (!open.empty() && con.itr->type == token_type::r_brace) {
+			++con.itr;
+			const open_function& body = open.back();
+			con.tree.end_list(body.block, body.mark);
+			con.tree[body.function].lhs = body.block;
+			node = body.function;
+			open.pop_back();
 		} else {
-			return lhs;
-		}
-	}
-	return nullptr;
-}
-
-std::unique_ptr<ast_base_node> parser::try_parse_assign(context& con) {
-	std::unique_ptr<ast_base_node> lhs = parser::try_parse_add_sub(con);
-	if (!lhs) {
-		return nullptr;
-	}
-	while (lhs) {
-		if (con.itr->str == "=") {
-			std::unique_ptr<ast_bin_op_node> node = std::make_unique<ast_bin_op_node>();
-			node->op = *con.itr++;
-			node->lhs = std::move(lhs);
-			node->rhs = try_parse_add_sub(con);
-			if (evaluate_type(node->lhs->type(), node->rhs->type()) == object_type::none) {
-				/* is castable? */
-				std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-				error->message = "failed to cast " + to_string(node->rhs->type()) + " -> " + to_string(node->lhs->type());
-				error->child = std::move(node);
-				lhs = std::move(error);
-				continue;
-			} else if (node->lhs->static_class() != ast_value_node().static_class()) {
-				/* is lhs assignable? */
-				std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-				error->message = "assign operator's lhs is not a variable";
-				error->child = std::move(node);
-				lhs = std::move(error);
+			node_id block = no_node;
+			token_stream::iterator before = con.itr;
+			node = try_parse_single_stmt(con, block);
+			is_stuck = con.itr == before;
+			if (block) {
+				open.push_back(open_function { .function = node, .block = block, .mark = con.tree.begin_list() });
 				continue;
-			} else if (ast_value_node* value = static_cast<ast_value_node*>(node->lhs.get())) {
-				auto itr = con.variables.find(value->value.str);
-				if (!itr->second.is_mutable) {
-					/* is lhs mutable? */
-					std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-					error->message = "assign operator's lhs is not mutable";
-					error->child = std::move(node);
-					lhs = std::move(error);
-					continue;
-				}
 			}
-			lhs = std::move(node);
-		} else {
-			return lhs;
 		}
-	}
-	return nullptr;
-}
 
-std::unique_ptr<ast_base_node> parser::try_parse_return(context& con) {
-	if (con.itr->type != token_type::_return) {
-		return nullptr;
-	}
-	++con.itr;
-	std::unique_ptr<ast_base_node> expr = try_parse_add_sub(con);
-	if (con.itr->str != ";") {
-		std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-		error->message = "not found semicolon";
-		return std::move(error);
+		/* hand the finished statement to the body it belongs to. running
+		 * out of tokens, or getting stuck, closes every open body with an
+		 * error and leaves the rest to the caller */
+		for (;;) {
+			if (open.empty()) {
+				return node;
+			}
+			const open_function& body = open.back();
+			con.tree.push_list(node ? node : make_error(con, "invalid expression"));
+			if (con.itr->type != token_type::eof && !is_stuck) {
+				break;
+			}
+			con.tree.end_list(body.block, body.mark);
+			node = make_error(con, "invalid expression", body.function);
+			open.pop_back();
+		}
 	}
-	++con.itr;
-	std::unique_ptr<ast_return_node> node = std::make_unique<ast_return_node>();
-	node->expr = std::move(expr);
-	return std::move(node);
 }
-std::unique_ptr<ast_base_node> parser::try_parse_stmt(context& con) {
-	if (con.itr->str == ";") {
+node_id parser::try_parse_single_stmt(context& con, node_id& block) {
+	while (con.itr->type == token_type::semicolon) {
 		++con.itr;
-		return try_parse_stmt(con);
 	}
-	std::unique_ptr<ast_base_node> node;
+	std::uint32_t offset = con.itr->offset;
+	node_id node;
 
 	node = try_parse_var_define(con);
 	if (node) {
-		if (con.itr->str != ";") {
-			std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-			error->message = "not found semicolon";
-			error->child = std::move(node);
-			return std::move(error);
+		if (con.itr->type != token_type::semicolon) {
+			return make_error(con, "not found semicolon", node);
 		}
 		++con.itr;
-		return std::move(node);
+		return node;
 	}
 
-	node = try_parse_function_define(con);
+	node = try_parse_function_define(con, block);
 	if (node) {
-		return std::move(node);
+		return node;
 	}
 
 	node = parser::try_parse_return(con);
 	if (node) {
-		return std::move(node);
+		return node;
 	}
 
-	node = parser::try_parse_assign(con);
-	if (node && node->static_class() == ast_error_node().static_class()) {
-		return std::move(node);
+	node = parser::try_parse_expression(con, precedence::assignment);
+	if (node && con.tree[node].kind == ast_kind::error) {
+		return node;
 	}
-	if (con.itr->str != ";") {
-		std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-		error->message = "not found semicolon";
-		return std::move(error);
+	if (con.itr->type != token_type::semicolon) {
+		return make_error(con, "not found semicolon");
 	}
 	++con.itr;
-	std::unique_ptr<ast_expr_node> expr = std::make_unique<ast_expr_node>();
-	expr->expr = std::move(node);
-	return std::move(expr);
+	return con.tree.add(ast_node { .kind = ast_kind::expr, .lhs = node, .offset = offset });
 }
-std::unique_ptr<ast_base_node> parser::try_parse_var_define(context& con) {
+node_id parser::try_parse_var_define(context& con) {
 	if (con.itr->type != token_type::_const &&
 		con.itr->type != token_type::_mut) {
-		return nullptr;
+		return no_node;
 	}
-	token modifier = *con.itr++;
+	token_type modifier = con.itr->type;
+	++con.itr;
 	token name = *con.itr++;
-	if (con.itr->str != ":") {
-		std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-		error->message = "not found colon";
-		return std::move(error);
+	if (con.itr->type != token_type::colon) {
+		return make_error(con, "not found colon");
 	}
 	++con.itr;
 
 	if (con.itr->type != token_type::_int &&
 		con.itr->type != token_type::_float) {
-		std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-		error->message = "invalid type";
-		return std::move(error);
+		return make_error(con, "invalid type");
 	}
-	token type = *con.itr++;
+	token_type type = con.itr->type;
+	++con.itr;
 	OBJECT dummy_value;
-	switch (type.type) {
+	switch (type) {
 	case token_type::_int:
 		dummy_value = 0;
 		break;
@@ -582,79 +270,76 @@ std::unique_ptr<ast_base_node> parser::try_parse_var_define(context& con) {
 	default: break;
 	}
 
-	std::unique_ptr<ast_var_define_node> node = std::make_unique<ast_var_define_node>();
-	node->modifier = modifier;
-	node->var_type = type;
-	node->name = name;
-	if (con.variables.contains(name.str)) {
-		std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-		error->message = name.str + " is already defined";
-		return std::move(error);
+	if (con.symbols.variables.contains(name.sym)) {
+		std::string message = std::string(name.str) + " is already defined";
+		return make_error(con, con.tree.store(message));
 	}
-	con.variables.insert({
-		name.str, 
-		variable {
-			.name = name.str,
-			.is_mutable = (modifier.type == token_type::_mut),
-			.value = std::move(dummy_value)
-		}
+	con.symbols.variables.insert(name.sym, variable {
+		.name = name.sym,
+		.is_mutable = (modifier == token_type::_mut),
+		.value = std::move(dummy_value)
 	});
-
-	if (con.itr->str != "=") {
-		return std::move(node);
+	con.symbols.defined.push_back(name.sym);
+
+	node_id node = con.tree.add(ast_node {
+		.kind = ast_kind::var_define,
+		.tok = modifier,
+		.var_type = type,
+		.sym = name.sym,
+		.offset = name.offset,
+		.str = name.str
+	});
+	if (con.itr->type != token_type::equal) {
+		return node;
 	}
 	++con.itr;
-	std::unique_ptr<ast_base_node> initial_value = try_parse_add_sub(con);
-	node->initial_value = std::move(initial_value);
-	return std::move(node);
+	node_id initial_value = try_parse_expression(con, precedence::additive);
+	con.tree[node].lhs = initial_value;
+	return node;
 }
-std::unique_ptr<ast_base_node> parser::try_parse_function_define(context& con) {
+node_id parser::try_parse_function_define(context& con, node_id& block) {
 	if (con.itr->type != token_type::_fn) {
-		return nullptr;
+		return no_node;
 	}
+	node_id function = con.tree.add(ast_node { .kind = ast_kind::function, .offset = con.itr->offset });
 	++con.itr;
-	std::unique_ptr<ast_function_node> function = std::make_unique<ast_function_node>();
 
-	if (con.itr->type != token_type::identifier) {
-		std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-		error->message = "expected identifer: " + con.itr->str;
-		function->name = std::move(error);
-	} else {
-		function->name = *con.itr;
+	/* a missing name leaves str empty */
+	if (con.itr->type == token_type::identifier) {
+		con.tree[function].str = con.itr->str;
+		con.tree[function].sym = con.itr->sym;
 	}
 	++con.itr;
 
-	if (con.itr->str != "(") {
-		std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-		error->message = "expected `(`: " + con.itr->str;
-		return std::move(error);
+	if (con.itr->type != token_type::l_paren) {
+		std::string message = "expected `(`: " + std::string(con.itr->str);
+		return make_error(con, con.tree.store(message));
 	}
 	++con.itr;
+	/* errors go after the arguments in the function's list, and there are
+	 * seldom any, so they wait here until the arguments are done */
+	std::size_t mark = con.tree.begin_list();
+	std::vector<node_id> errors;
 	for (;;) {
-		std::unique_ptr<ast_base_node> node = try_parse_var_define(con);
+		node_id node = try_parse_var_define(con);
 		if (!node) {
-			std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-			error->message = "expected variable";
-			function->error_list.push_back(std::move(error));
+			errors.push_back(make_error(con, "expected variable"));
 		} else {
-			function->arguments.push_back(std::move(node));
+			con.tree.push_list(node);
 		}
 		if (con.itr->type == token_type::eof) {
-			std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-			error->message = "expected `)`";
-			return std::move(error);
+			con.tree.end_list(function, mark);
+			return make_error(con, "expected `)`");
 		}
-		if (con.itr->str == ")") {
+		if (con.itr->type == token_type::r_paren) {
 			break;
 		}
 
-		if (con.itr->str == ",") {
+		if (con.itr->type == token_type::comma) {
 			++con.itr;
 			continue;
 		} else {
-			std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-			error->message = "expected comma";
-			function->error_list.push_back(std::move(error));
+			errors.push_back(make_error(con, "expected comma"));
 			if (con.itr->type != token_type::_const &&
 				con.itr->type != token_type::_mut) {
 				++con.itr;
@@ -662,85 +347,78 @@ std::unique_ptr<ast_base_node> parser::try_parse_function_define(context& con) {
 		}
 	}
 	++con.itr;
+	std::uint32_t argument_count = static_cast<std::uint32_t>(con.tree.begin_list() - mark);
+	for (node_id error : errors) {
+		con.tree.push_list(error);
+	}
+	con.tree.end_list(function, mark);
+	con.tree[function].list_split = argument_count;
 
-	if (con.itr->str != "->") {
-		std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-		error->message = "expected `->`";
-		error->child = std::move(function);
-		return std::move(error);
+	if (con.itr->type != token_type::arrow) {
+		return make_error(con, "expected `->`", function);
 	}
 	++con.itr;
 
 	if (con.itr->type != token_type::_const &&
 		con.itr->type != token_type::_mut) {
-		std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-		error->message = "expected `const` or `mut`";
-		function->return_type.modifier = std::move(error);
+		con.tree[function].tok = token_type::unknown;
 	} else {
-		function->return_type.modifier = *con.itr;
+		con.tree[function].tok = con.itr->type;
 	}
 	++con.itr;
 
 	if (con.itr->type != token_type::_int &&
 		con.itr->type != token_type::_float) {
-		std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-		error->message = "expected `int` or `float`";
-		function->return_type.var_type = std::move(error);
+		con.tree[function].var_type = token_type::unknown;
 	} else {
-		function->return_type.var_type = *con.itr;
+		con.tree[function].var_type = con.itr->type;
 	}
 	++con.itr;
 
-	if (con.itr->str != "{") {
-		std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-		error->message = "expected `{`";
-		function->block = std::move(error);
-		return std::move(function);
-	}
-	++con.itr;
-	std::unique_ptr<ast_block_node> block = std::make_unique<ast_block_node>();
-	block->block_name = function->get_mangling_name();
-	while (con.itr->str != "}") {
-		std::unique_ptr<ast_base_node> node = try_parse_stmt(con);
-		if (!node) {
-			std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-			error->message = "invalid expression";
-			block->nodes.push_back(std::move(error));
-		} else {
-			block->nodes.push_back(std::move(node));
-		}
-		if (con.itr->type == token_type::eof) {
-			std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-			error->message = "invalid expression";
-			error->child = std::move(function);
-			return std::move(error);
-		}
+	if (con.itr->type != token_type::l_brace) {
+		con.tree[function].lhs = make_error(con, "expected `{`");
+		return function;
 	}
+	block = con.tree.add(ast_node {
+		.kind = ast_kind::block,
+		.offset = con.itr->offset,
+		.str = con.tree.store(con.tree.mangled_name(function))
+	});
 	++con.itr;
-	function->block = std::move(block);
-	return std::move(function);
+	return function;
 }
 
-std::unique_ptr<ast_base_node> parser::parse(const std::vector<token>& tokens) {
-	context con { .itr = tokens.begin() };
+node_id parser::parse(const token_array& tokens, syntax_tree& tree) {
+	token_stream stream(tokens);
+	return parse(stream, tree);
+}
+node_id parser::parse_statement(token_stream::iterator& itr, symbol_table& symbols, syntax_tree& tree) {
+	context con { .itr = itr, .symbols = symbols, .tree = tree };
+	node_id node = try_parse_stmt(con);
+	itr = con.itr;
+	return node;
+}
+node_id parser::parse(token_stream& tokens, syntax_tree& tree) {
+	symbol_table symbols;
+	token_stream::iterator current = tokens.begin();
 
-	std::unique_ptr<ast_block_node> block = std::make_unique<ast_block_node>();
-	block->block_name = "global";
-	std::vector<token>::const_iterator itr;
-	while (con.itr->type != token_type::eof) {
-		itr = con.itr;
-		std::unique_ptr<ast_base_node> node = try_parse_stmt(con);
+	node_id block = tree.add(ast_node { .kind = ast_kind::block, .str = "global" });
+	std::size_t mark = tree.begin_list();
+	token_stream::iterator itr;
+	while (current->type != token_type::eof) {
+		itr = current;
+		node_id node = parse_statement(current, symbols, tree);
 		if (!node) {
 			break;
 		}
-		block->nodes.push_back(std::move(node));
-		if (itr == con.itr) {
-			std::unique_ptr<ast_error_node> error = std::make_unique<ast_error_node>();
-			error->message = "failed to parse.";
-			error->child = std::move(block);
-			return std::move(error);
+		tree.push_list(node);
+		if (itr == current) {
+			tree.end_list(block, mark);
+			tree.set_root(tree.add(ast_node { .kind = ast_kind::error, .lhs = block, .offset = current->offset, .str = "failed to parse." }));
+			return tree.root();
 		}
 	}
-
-	return std::move(block);
-}
\ No newline at end of file
+	tree.end_list(block, mark);
+	tree.set_root(block);
+	return block;
+}
@@ -0,0 +1,287 @@
+#include "peephole_optimizer.hpp"
+#include "constant_folder.hpp"
+
+
+namespace {
+	/* what an instruction does to the stack. a barrier ends every window */
+	struct stack_effect {
+		std::size_t pops;
+		std::size_t pushes;
+		bool barrier;
+	};
+
+	template <class T>
+	T* as(const std::unique_ptr<instruct>& inst) {
+		return dynamic_cast<T*>(inst.get());
+	}
+	bool is_integer_operation(const instruct& inst) {
+		return dynamic_cast<const add_instruct*>(&inst) || dynamic_cast<const sub_instruct*>(&inst) ||
+			dynamic_cast<const mul_instruct*>(&inst) || dynamic_cast<const div_instruct*>(&inst);
+	}
+	bool is_float_operation(const instruct& inst) {
+		return dynamic_cast<const addf_instruct*>(&inst) || dynamic_cast<const subf_instruct*>(&inst) ||
+			dynamic_cast<const mulf_instruct*>(&inst) || dynamic_cast<const divf_instruct*>(&inst);
+	}
+	/* the slot a store writes, no_slot for any other instruction */
+	slot_index stored_slot(const instruct& inst) {
+		if (auto* init = dynamic_cast<const init_instruct*>(&inst)) { return init->slot; }
+		if (auto* mov = dynamic_cast<const mov_instruct*>(&inst)) { return mov->slot; }
+		if (auto* movf = dynamic_cast<const movf_instruct*>(&inst)) { return movf->slot; }
+		return no_slot;
+	}
+	/* a push that only puts a value on the stack. a push of no value is
+	 * how the encoder aborts, so it has to stay */
+	bool is_plain_push(const instruct& inst) {
+		auto* push = dynamic_cast<const push_instruct*>(&inst);
+		return push && (push->value.type == operand_type::variable ||
+			push->value.value.index() != INVALID_TYPE_INDEX);
+	}
+
+	stack_effect effect_of(const instruct& inst) {
+		if (dynamic_cast<const push_instruct*>(&inst)) {
+			return stack_effect { .pops = 0, .pushes = 1, .barrier = false };
+		}
+		if (dynamic_cast<const pop_instruct*>(&inst) || stored_slot(inst) != no_slot) {
+			return stack_effect { .pops = 1, .pushes = 0, .barrier = false };
+		}
+		if (dynamic_cast<const alloc_instruct*>(&inst)) {
+			return stack_effect { .pops = 0, .pushes = 0, .barrier = false };
+		}
+		if (dynamic_cast<const cast_instruct*>(&inst)) {
+			return stack_effect { .pops = 1, .pushes = 1, .barrier = false };
+		}
+		if (is_integer_operation(inst) || is_float_operation(inst)) {
+			return stack_effect { .pops = 2, .pushes = 1, .barrier = false };
+		}
+		return stack_effect { .pops = 0, .pushes = 0, .barrier = true };
+	}
+}
+
+std::size_t peephole_optimizer::report::total() const {
+	std::size_t sum = 0;
+	for (std::size_t count : removed) {
+		sum += count;
+	}
+	return sum;
+}
+std::string peephole_optimizer::report::log(const std::string& prefix) const {
+	std::string str;
+	for (std::size_t index = 0; index < rule_count; ++index) {
+		str += prefix + std::string(name(static_cast<rule>(index))) + ": " +
+			std::to_string(removed[index]) + " removed\n";
+	}
+	return str;
+}
+peephole_optimizer::report& peephole_optimizer::report::operator+=(const report& other) {
+	for (std::size_t index = 0; index < rule_count; ++index) {
+		removed[index] += other.removed[index];
+	}
+	return *this;
+}
+
+peephole_optimizer::peephole_optimizer(std::size_t window) :
+	_window(window)
+{
+	_enabled.fill(true);
+}
+
+void peephole_optimizer::enable(rule which, bool enabled) {
+	_enabled[static_cast<std::size_t>(which)] = enabled;
+}
+bool peephole_optimizer::is_enabled(rule which) const {
+	return _enabled[static_cast<std::size_t>(which)];
+}
+
+peephole_optimizer::report peephole_optimizer::run(std::list<std::unique_ptr<instruct>>& codes) const {
+	report result;
+	/* a rewrite can open up another one behind it that the window has
+	 * already passed, so the scan repeats until nothing changes */
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		std::vector<object_type> slot_types;
+		for (iterator at = codes.begin(); at != codes.end();) {
+			if (alloc_instruct* alloc = as<alloc_instruct>(*at)) {
+				if (alloc->slot >= slot_types.size()) {
+					slot_types.resize(alloc->slot + 1, object_type::none);
+				}
+				slot_types[alloc->slot] = alloc->type;
+			}
+			bool rewritten =
+				(is_enabled(rule::push_pop) && remove_push_pop(codes, at, result)) ||
+				(is_enabled(rule::identity_cast) && remove_identity_cast(codes, at, slot_types, result)) ||
+				(is_enabled(rule::cast_literal) && fold_cast_literal(codes, at, result)) ||
+				(is_enabled(rule::adjacent_moves) && merge_adjacent_moves(codes, at, result));
+			if (rewritten) {
+				changed = true;
+				continue;
+			}
+			++at;
+		}
+	}
+	return result;
+}
+peephole_optimizer::report peephole_optimizer::run(asm_context& con) const {
+	report result = run(con.codes);
+	con.functions.for_each([this, &result](symbol, asm_context::function_info& info) {
+		result += run(info.instruction);
+	});
+	return result;
+}
+
+std::string_view peephole_optimizer::name(rule which) {
+	switch (which) {
+	case rule::push_pop: return "push_pop";
+	case rule::identity_cast: return "identity_cast";
+	case rule::cast_literal: return "cast_literal";
+	case rule::adjacent_moves: return "adjacent_moves";
+	}
+	return "";
+}
+
+peephole_optimizer::iterator peephole_optimizer::producer(std::list<std::unique_ptr<instruct>>& codes,
+	iterator at, std::size_t depth) const
+{
+	for (std::size_t steps = 0; at != codes.begin() && steps < _window; ++steps) {
+		--at;
+		stack_effect effect = effect_of(**at);
+		if (effect.barrier) {
+			break;
+		}
+		if (depth < effect.pushes) {
+			return at;
+		}
+		depth = depth - effect.pushes + effect.pops;
+	}
+	return codes.end();
+}
+object_type peephole_optimizer::result_type(const instruct& inst, const std::vector<object_type>& slot_types) {
+	if (auto* push = dynamic_cast<const push_instruct*>(&inst)) {
+		if (push->value.type == operand_type::immidiate) {
+			return static_cast<object_type>(push->value.value.index());
+		}
+		/* arguments have no alloc, so their type is not known here */
+		return push->value.slot < slot_types.size() ? slot_types[push->value.slot] : object_type::none;
+	}
+	if (auto* cast = dynamic_cast<const cast_instruct*>(&inst)) {
+		return cast->to;
+	}
+	if (is_integer_operation(inst)) {
+		return object_type::integer;
+	}
+	if (is_float_operation(inst)) {
+		return object_type::floating;
+	}
+	return object_type::none;
+}
+
+bool peephole_optimizer::remove_push_pop(std::list<std::unique_ptr<instruct>>& codes, iterator& at, report& result) const {
+	if (!as<pop_instruct>(*at)) {
+		return false;
+	}
+	iterator source = producer(codes, at, 0);
+	if (source == codes.end()) {
+		return false;
+	}
+	std::size_t& removed = result.removed[static_cast<std::size_t>(rule::push_pop)];
+	if (is_plain_push(**source)) {
+		codes.erase(source);
+		at = codes.erase(at);
+		removed += 2;
+		return true;
+	}
+	if (!as<cast_instruct>(*source) && !is_integer_operation(**source) && !is_float_operation(**source)) {
+		return false;
+	}
+	/* an unused result leaves its operands unused too. they are popped
+	 * here instead, for the rule to meet their producers next */
+	std::size_t operands = effect_of(**source).pops;
+	codes.erase(source);
+	iterator first = at;
+	for (std::size_t index = 0; index < operands; ++index) {
+		iterator inserted = codes.insert(at, std::make_unique<pop_instruct>());
+		if (index == 0) {
+			first = inserted;
+		}
+	}
+	codes.erase(at);
+	at = first;
+	removed += 2 - operands;
+	return true;
+}
+bool peephole_optimizer::remove_identity_cast(std::list<std::unique_ptr<instruct>>& codes, iterator& at,
+	const std::vector<object_type>& slot_types, report& result) const
+{
+	cast_instruct* cast = as<cast_instruct>(*at);
+	if (!cast || cast->to == object_type::none) {
+		return false;
+	}
+	iterator source = producer(codes, at, 0);
+	if (source == codes.end() || result_type(**source, slot_types) != cast->to) {
+		return false;
+	}
+	at = codes.erase(at);
+	++result.removed[static_cast<std::size_t>(rule::identity_cast)];
+	return true;
+}
+bool peephole_optimizer::fold_cast_literal(std::list<std::unique_ptr<instruct>>& codes, iterator& at, report& result) const {
+	cast_instruct* cast = as<cast_instruct>(*at);
+	if (!cast) {
+		return false;
+	}
+	iterator source = producer(codes, at, 0);
+	if (source == codes.end()) {
+		return false;
+	}
+	push_instruct* push = as<push_instruct>(*source);
+	if (!push || push->value.type != operand_type::immidiate) {
+		return false;
+	}
+	std::optional<OBJECT> value = constant_folder::cast(push->value.value, cast->to);
+	if (!value) {
+		return false;
+	}
+	push->value.value = std::move(*value);
+	at = codes.erase(at);
+	++result.removed[static_cast<std::size_t>(rule::cast_literal)];
+	return true;
+}
+bool peephole_optimizer::merge_adjacent_moves(std::list<std::unique_ptr<instruct>>& codes, iterator& at, report& result) const {
+	slot_index slot = stored_slot(**at);
+	if (slot == no_slot) {
+		return false;
+	}
+	/* the store is dead when the slot is written again before it is read */
+	iterator next = std::next(at);
+	bool overwritten = false;
+	for (std::size_t steps = 0; next != codes.end() && steps < _window; ++steps, ++next) {
+		if (effect_of(**next).barrier) {
+			break;
+		}
+		if (auto* push = as<push_instruct>(*next)) {
+			if (push->value.type == operand_type::variable && push->value.slot == slot) {
+				break;
+			}
+			continue;
+		}
+		auto* alloc = as<alloc_instruct>(*next);
+		if (stored_slot(**next) == slot || (alloc && alloc->slot == slot)) {
+			overwritten = true;
+			break;
+		}
+	}
+	if (!overwritten) {
+		return false;
+	}
+	iterator source = producer(codes, at, 0);
+	std::size_t& removed = result.removed[static_cast<std::size_t>(rule::adjacent_moves)];
+	if (source != codes.end() && is_plain_push(**source)) {
+		codes.erase(source);
+		at = codes.erase(at);
+		removed += 2;
+		return true;
+	}
+	/* the value is still computed, but only to be dropped */
+	*at = std::make_unique<pop_instruct>();
+	return true;
+}
@@ -0,0 +1,205 @@
+#include "register_code.hpp"
+#include <algorithm>
+#include <optional>
+#include "constant_folder.hpp"
+
+
+namespace {
+	/* whether the instruction reads its operands where it stands. a copy
+	 * only renames its operand */
+	bool reads_operands(ir_opcode op) {
+		return op != ir_opcode::constant && op != ir_opcode::argument && op != ir_opcode::copy;
+	}
+	register_opcode operation(ir_opcode op, object_type type) {
+		std::size_t offset = type == object_type::floating ? 4 : 0;
+		switch (op) {
+		case ir_opcode::sub: offset += 1; break;
+		case ir_opcode::mul: offset += 2; break;
+		case ir_opcode::div: offset += 3; break;
+		default: break;
+		}
+		return static_cast<register_opcode>(static_cast<std::size_t>(register_opcode::add) + offset);
+	}
+}
+
+register_code register_code::compile(const ir_function& function) {
+	register_code code;
+	const std::vector<ir_instruction>& values = function.values;
+	std::vector<ir_value> order;
+	for (const ir_block& block : function.blocks) {
+		order.insert(order.end(), block.instructions.begin(), block.instructions.end());
+	}
+
+	/* a copy is its source under another name, so it shares the register */
+	std::vector<ir_value> source(values.size());
+	for (ir_value index = 0; index < values.size(); ++index) {
+		source[index] = index;
+	}
+	for (ir_value value : order) {
+		if (values[value].op == ir_opcode::copy) {
+			source[value] = source[values[value].lhs];
+		}
+	}
+
+	/* the position of the last instruction that reads each value */
+	constexpr std::size_t never = ~std::size_t(0);
+	std::vector<std::size_t> last_use(values.size(), never);
+	for (std::size_t position = 0; position < order.size(); ++position) {
+		const ir_instruction& inst = values[order[position]];
+		if (!reads_operands(inst.op)) {
+			continue;
+		}
+		if (inst.lhs != no_value) {
+			last_use[source[inst.lhs]] = position;
+		}
+		if (inst.rhs != no_value) {
+			last_use[source[inst.rhs]] = position;
+		}
+	}
+
+	constexpr std::uint32_t unassigned = ~std::uint32_t(0);
+	std::vector<std::uint32_t> registers(values.size(), unassigned);
+	for (ir_value value : order) {
+		if (values[value].op == ir_opcode::argument) {
+			registers[value] = values[value].index;
+			code._constant_base = std::max(code._constant_base, values[value].index + 1);
+		}
+	}
+	/* a cast of a constant is a constant too, converted here once */
+	std::vector<std::optional<OBJECT>> known(values.size());
+	for (ir_value value : order) {
+		const ir_instruction& inst = values[value];
+		if (inst.op == ir_opcode::constant) {
+			known[value] = inst.constant;
+		} else if (inst.op == ir_opcode::cast && known[source[inst.lhs]]) {
+			known[value] = constant_folder::cast(*known[source[inst.lhs]], inst.type);
+		}
+		if (known[value]) {
+			registers[value] = code._constant_base + static_cast<std::uint32_t>(code._constants.size());
+			code._constants.push_back(value::from_object(*known[value]));
+		}
+	}
+	std::uint32_t temporaries = code._constant_base + static_cast<std::uint32_t>(code._constants.size());
+	std::uint32_t next = temporaries;
+	std::vector<std::uint32_t> free;
+	auto is_temporary = [&](ir_value root) {
+		return registers[root] != unassigned && registers[root] >= temporaries;
+	};
+
+	for (std::size_t position = 0; position < order.size(); ++position) {
+		ir_value value = order[position];
+		const ir_instruction& inst = values[value];
+		if (known[value]) {
+			continue;
+		}
+		switch (inst.op) {
+		case ir_opcode::constant:
+		case ir_opcode::argument:
+			continue;
+		case ir_opcode::copy:
+			registers[value] = registers[source[value]];
+			continue;
+		case ir_opcode::ret:
+			code._instructions.push_back(register_instruction {
+				.op = register_opcode::ret,
+				.a = registers[source[inst.lhs]]
+			});
+			continue;
+		case ir_opcode::abort:
+			code._instructions.push_back(register_instruction { .op = register_opcode::abort });
+			continue;
+		default:
+			break;
+		}
+		register_instruction instruction {
+			.op = inst.op == ir_opcode::cast ?
+				(inst.type == object_type::floating ? register_opcode::cast_float : register_opcode::cast_int) :
+				operation(inst.op, inst.type),
+			.b = registers[source[inst.lhs]],
+			.c = inst.rhs != no_value ? registers[source[inst.rhs]] : 0
+		};
+		/* operands are read before the result is written, so the result
+		 * may take the register of an operand that dies here */
+		for (ir_value operand : { inst.lhs, inst.rhs }) {
+			if (operand != no_value && last_use[source[operand]] == position && is_temporary(source[operand])) {
+				free.push_back(registers[source[operand]]);
+				/* both operands may be the same value */
+				last_use[source[operand]] = never;
+			}
+		}
+		if (!free.empty()) {
+			registers[value] = free.back();
+			free.pop_back();
+		} else {
+			registers[value] = next++;
+		}
+		instruction.a = registers[value];
+		code._instructions.push_back(instruction);
+		if (last_use[value] == never) {
+			free.push_back(registers[value]);
+		}
+	}
+	/* running off the end returns nothing, as an abort does */
+	if (code._instructions.empty() || (code._instructions.back().op != register_opcode::ret &&
+		code._instructions.back().op != register_opcode::abort))
+	{
+		code._instructions.push_back(register_instruction { .op = register_opcode::abort });
+	}
+	code._register_count = next;
+	return code;
+}
+
+const std::vector<register_instruction>& register_code::instructions() const {
+	return _instructions;
+}
+const std::vector<value>& register_code::constants() const {
+	return _constants;
+}
+std::uint32_t register_code::constant_base() const {
+	return _constant_base;
+}
+std::uint32_t register_code::register_count() const {
+	return _register_count;
+}
+
+std::string register_code::disassemble() const {
+	std::string str;
+	for (std::size_t index = 0; index < _constants.size(); ++index) {
+		const value& constant = _constants[index];
+		str += "r" + std::to_string(_constant_base + index) + " = ";
+		switch (constant.type) {
+		case value::tag::integer: str += std::to_string(constant.integer); break;
+		case value::tag::floating: str += std::to_string(constant.floating); break;
+		default: str += "none"; break;
+		}
+		str += "\n";
+	}
+	for (const register_instruction& inst : _instructions) {
+		switch (inst.op) {
+		case register_opcode::ret:
+			str += "ret r" + std::to_string(inst.a);
+			break;
+		case register_opcode::abort:
+			str += "abort";
+			break;
+		case register_opcode::cast_int:
+		case register_opcode::cast_float:
+			str += "r" + std::to_string(inst.a) + " = " + std::string(name(inst.op)) + " r" + std::to_string(inst.b);
+			break;
+		default:
+			str += "r" + std::to_string(inst.a) + " = " + std::string(name(inst.op)) + " r" + std::to_string(inst.b) +
+				", r" + std::to_string(inst.c);
+			break;
+		}
+		str += "\n";
+	}
+	return str;
+}
+std::string_view register_code::name(register_opcode op) {
+	switch (op) {
+#define REGISTER_NAME(name) case register_opcode::name: return #name;
+	REGISTER_OPCODES(REGISTER_NAME)
+#undef REGISTER_NAME
+	}
+	return "";
+}
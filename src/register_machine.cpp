@@ -0,0 +1,104 @@
+#include "register_machine.hpp"
+#include <algorithm>
+#include <limits>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define REGISTER_MACHINE_COMPUTED_GOTO
+#endif
+
+
+register_machine::register_machine(const register_code& code) :
+	_code(code),
+	_registers(std::make_unique<value[]>(code.register_count()))
+{}
+
+std::vector<OBJECT> register_machine::evaluate(const register_code& code) {
+	register_machine machine(code);
+	std::optional<value> result = machine.run();
+	if (!result) {
+		return {};
+	}
+	return { result->to_object() };
+}
+
+std::optional<value> register_machine::run() {
+	value* const r = _registers.get();
+	std::copy(_code.constants().begin(), _code.constants().end(), r + _code.constant_base());
+	/* the code always ends in ret or abort */
+	const register_instruction* pc = _code.instructions().data();
+
+#ifdef REGISTER_MACHINE_COMPUTED_GOTO
+	static const void* const labels[] = {
+#define REGISTER_LABEL(name) &&op_##name,
+		REGISTER_OPCODES(REGISTER_LABEL)
+#undef REGISTER_LABEL
+	};
+#define CASE(name) op_##name:
+#define NEXT() goto *labels[static_cast<std::size_t>((++pc)->op)]
+	goto *labels[static_cast<std::size_t>(pc->op)];
+#else
+#define CASE(name) case register_opcode::name:
+#define NEXT() ++pc; continue
+	for (;;) switch (pc->op) {
+#endif
+
+#define EXPECT(item, kind) if ((item).type != value::tag::kind) { return std::nullopt; }
+#define ARITHMETIC(kind, op) { \
+		const value& lhs = r[pc->b]; \
+		const value& rhs = r[pc->c]; \
+		EXPECT(lhs, kind); \
+		EXPECT(rhs, kind); \
+		r[pc->a] = value::of(static_cast<decltype(lhs.kind)>(wrapping(lhs.kind) op wrapping(rhs.kind))); \
+		NEXT(); \
+	}
+
+	CASE(add) ARITHMETIC(integer, +)
+	CASE(sub) ARITHMETIC(integer, -)
+	CASE(mul) ARITHMETIC(integer, *)
+	CASE(div) {
+		const value& lhs = r[pc->b];
+		const value& rhs = r[pc->c];
+		EXPECT(lhs, integer);
+		EXPECT(rhs, integer);
+		if (rhs.integer == 0 || (rhs.integer == -1 && lhs.integer == std::numeric_limits<std::int32_t>::min())) {
+			return std::nullopt;
+		}
+		r[pc->a] = value::of(lhs.integer / rhs.integer);
+		NEXT();
+	}
+	CASE(addf) ARITHMETIC(floating, +)
+	CASE(subf) ARITHMETIC(floating, -)
+	CASE(mulf) ARITHMETIC(floating, *)
+	CASE(divf) ARITHMETIC(floating, /)
+	CASE(cast_int) {
+		const value& source = r[pc->b];
+		if (source.type == value::tag::floating) {
+			r[pc->a] = value::of(static_cast<std::int32_t>(source.floating));
+		} else {
+			EXPECT(source, integer);
+			r[pc->a] = source;
+		}
+		NEXT();
+	}
+	CASE(cast_float) {
+		const value& source = r[pc->b];
+		if (source.type == value::tag::integer) {
+			r[pc->a] = value::of(static_cast<double>(source.integer));
+		} else {
+			EXPECT(source, floating);
+			r[pc->a] = source;
+		}
+		NEXT();
+	}
+	CASE(ret) return r[pc->a];
+	CASE(abort) return std::nullopt;
+
+#ifndef REGISTER_MACHINE_COMPUTED_GOTO
+	}
+#endif
+#undef ARITHMETIC
+#undef EXPECT
+#undef NEXT
+#undef CASE
+	return std::nullopt;
+}
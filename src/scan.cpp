@@ -0,0 +1,350 @@
+#include "scan.hpp"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SCAN_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(SCAN_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SCAN_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SCAN_TARGET_AVX2
+#endif
+
+
+/* ==========================================
+ *                   scalar
+ * ==========================================
+ */
+/* length of the well-formed sequence at `p` (RFC 3629: no overlong forms,
+ * no surrogates, nothing above U+10FFFF), or 0 when it is ill-formed */
+static inline int utf8_sequence_length(const unsigned char* p, const unsigned char* end) {
+	unsigned char lead = p[0];
+	if (lead < 0x80) {
+		return 1;
+	}
+	if (lead < 0xc2) {
+		return 0;
+	}
+	if (lead < 0xe0) {
+		return end - p >= 2 && (p[1] & 0xc0) == 0x80 ? 2 : 0;
+	}
+	if (lead < 0xf0) {
+		unsigned char lo = lead == 0xe0 ? 0xa0 : 0x80;
+		unsigned char hi = lead == 0xed ? 0x9f : 0xbf;
+		return end - p >= 3 && p[1] >= lo && p[1] <= hi && (p[2] & 0xc0) == 0x80 ? 3 : 0;
+	}
+	if (lead < 0xf5) {
+		unsigned char lo = lead == 0xf0 ? 0x90 : 0x80;
+		unsigned char hi = lead == 0xf4 ? 0x8f : 0xbf;
+		return end - p >= 4 && p[1] >= lo && p[1] <= hi &&
+			(p[2] & 0xc0) == 0x80 && (p[3] & 0xc0) == 0x80 ? 4 : 0;
+	}
+	return 0;
+}
+static const char* scalar_validate_utf8(const char* p, const char* end) {
+	const unsigned char* q = reinterpret_cast<const unsigned char*>(p);
+	const unsigned char* last = reinterpret_cast<const unsigned char*>(end);
+	while (q < last) {
+		if (last - q >= 8) {
+			std::uint64_t word;
+			std::memcpy(&word, q, sizeof(word));
+			if (!(word & 0x8080808080808080ull)) {
+				q += 8;
+				continue;
+			}
+		}
+		int length = utf8_sequence_length(q, last);
+		if (!length) {
+			break;
+		}
+		q += length;
+	}
+	return reinterpret_cast<const char*>(q < last ? q : last);
+}
+
+#ifdef SCAN_X86
+/* ==========================================
+ *                    SSE2
+ * ==========================================
+ */
+/* all-ASCII blocks are skipped 16 bytes at a time; a block with a non-ASCII
+ * byte is checked sequence by sequence. SSE2 has no byte shuffle, so there
+ * is no table-driven path here. */
+static const char* sse2_validate_utf8(const char* p, const char* end) {
+	const unsigned char* q = reinterpret_cast<const unsigned char*>(p);
+	const unsigned char* last = reinterpret_cast<const unsigned char*>(end);
+	while (last - q >= 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q));
+		if (!_mm_movemask_epi8(v)) {
+			q += 16;
+			continue;
+		}
+		const unsigned char* block_end = q + 16;
+		while (q < block_end) {
+			int length = utf8_sequence_length(q, last);
+			if (!length) {
+				return reinterpret_cast<const char*>(q);
+			}
+			q += length;
+		}
+	}
+	return scalar_validate_utf8(reinterpret_cast<const char*>(q), end);
+}
+
+/* ==========================================
+ *                    AVX2
+ * ==========================================
+ */
+/* table-driven validation after Keiser and Lemire, "Validating UTF-8 In
+ * Less Than One Instruction Per Byte". every byte is classified by the high
+ * and low nibble of the byte before it and the high nibble of itself; the
+ * three lookups are and-ed so that a bit survives only for an error. the
+ * 3rd and 4th bytes of long sequences are checked against the lead bytes
+ * two and three positions back. */
+enum : std::uint8_t {
+	utf8_too_short = 1 << 0,
+	utf8_too_long = 1 << 1,
+	utf8_overlong_3 = 1 << 2,
+	utf8_too_large = 1 << 3,
+	utf8_surrogate = 1 << 4,
+	utf8_overlong_2 = 1 << 5,
+	utf8_too_large_1000 = 1 << 6,
+	utf8_overlong_4 = 1 << 6,
+	utf8_two_conts = 1 << 7,
+	utf8_carry = utf8_too_short | utf8_too_long | utf8_two_conts,
+};
+
+SCAN_TARGET_AVX2 static inline __m256i avx2_lookup16(__m256i index,
+	std::uint8_t v0, std::uint8_t v1, std::uint8_t v2, std::uint8_t v3,
+	std::uint8_t v4, std::uint8_t v5, std::uint8_t v6, std::uint8_t v7,
+	std::uint8_t v8, std::uint8_t v9, std::uint8_t v10, std::uint8_t v11,
+	std::uint8_t v12, std::uint8_t v13, std::uint8_t v14, std::uint8_t v15
+) {
+	__m256i table = _mm256_setr_epi8(
+		v0, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15,
+		v0, v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15);
+	return _mm256_shuffle_epi8(table, index);
+}
+SCAN_TARGET_AVX2 static inline __m256i avx2_high_nibble(__m256i v) {
+	return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0f));
+}
+/* `input` shifted right by N bytes, with the last N bytes of `prev` in front */
+template <int N>
+SCAN_TARGET_AVX2 static inline __m256i avx2_prev(__m256i input, __m256i prev) {
+	return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - N);
+}
+SCAN_TARGET_AVX2 static inline __m256i avx2_utf8_errors(__m256i input, __m256i prev_input) {
+	__m256i prev1 = avx2_prev<1>(input, prev_input);
+	__m256i byte_1_high = avx2_lookup16(avx2_high_nibble(prev1),
+		utf8_too_long, utf8_too_long, utf8_too_long, utf8_too_long,
+		utf8_too_long, utf8_too_long, utf8_too_long, utf8_too_long,
+		utf8_two_conts, utf8_two_conts, utf8_two_conts, utf8_two_conts,
+		utf8_too_short | utf8_overlong_2,
+		utf8_too_short,
+		utf8_too_short | utf8_overlong_3 | utf8_surrogate,
+		utf8_too_short | utf8_too_large | utf8_too_large_1000 | utf8_overlong_4);
+	__m256i byte_1_low = avx2_lookup16(_mm256_and_si256(prev1, _mm256_set1_epi8(0x0f)),
+		utf8_carry | utf8_overlong_3 | utf8_overlong_2 | utf8_overlong_4,
+		utf8_carry | utf8_overlong_2,
+		utf8_carry,
+		utf8_carry,
+		utf8_carry | utf8_too_large,
+		utf8_carry | utf8_too_large | utf8_too_large_1000,
+		utf8_carry | utf8_too_large | utf8_too_large_1000,
+		utf8_carry | utf8_too_large | utf8_too_large_1000,
+		utf8_carry | utf8_too_large | utf8_too_large_1000,
+		utf8_carry | utf8_too_large | utf8_too_large_1000,
+		utf8_carry | utf8_too_large | utf8_too_large_1000,
+		utf8_carry | utf8_too_large | utf8_too_large_1000,
+		utf8_carry | utf8_too_large | utf8_too_large_1000,
+		utf8_carry | utf8_too_large | utf8_too_large_1000 | utf8_surrogate,
+		utf8_carry | utf8_too_large | utf8_too_large_1000,
+		utf8_carry | utf8_too_large | utf8_too_large_1000);
+	__m256i byte_2_high = avx2_lookup16(avx2_high_nibble(input),
+		utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short,
+		utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short,
+		utf8_too_long | utf8_overlong_2 | utf8_two_conts | utf8_overlong_3 | utf8_too_large_1000 | utf8_overlong_4,
+		utf8_too_long | utf8_overlong_2 | utf8_two_conts | utf8_overlong_3 | utf8_too_large,
+		utf8_too_long | utf8_overlong_2 | utf8_two_conts | utf8_surrogate | utf8_too_large,
+		utf8_too_long | utf8_overlong_2 | utf8_two_conts | utf8_surrogate | utf8_too_large,
+		utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short);
+	__m256i special = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+	/* a 3rd or 4th byte must be a continuation, which the lookups above
+	 * report as two_conts; flip that bit where it is expected */
+	__m256i prev2 = avx2_prev<2>(input, prev_input);
+	__m256i prev3 = avx2_prev<3>(input, prev_input);
+	__m256i is_third = _mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xe0 - 0x80)));
+	__m256i is_fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xf0 - 0x80)));
+	__m256i must_continue = _mm256_and_si256(_mm256_or_si256(is_third, is_fourth),
+		_mm256_set1_epi8(static_cast<char>(0x80)));
+	return _mm256_xor_si256(must_continue, special);
+}
+/* non-zero when the block ends inside a sequence */
+SCAN_TARGET_AVX2 static inline __m256i avx2_utf8_incomplete(__m256i input) {
+	__m256i max_value = _mm256_setr_epi8(
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		static_cast<char>(0xf0 - 1), static_cast<char>(0xe0 - 1), static_cast<char>(0xc0 - 1));
+	return _mm256_subs_epu8(input, max_value);
+}
+SCAN_TARGET_AVX2 static const char* avx2_validate_utf8(const char* p, const char* end) {
+	const char* begin = p;
+	__m256i prev_input = _mm256_setzero_si256();
+	__m256i prev_incomplete = _mm256_setzero_si256();
+	__m256i error = _mm256_setzero_si256();
+	const char* block = p;
+	alignas(32) char tail[32];
+	while (block < end) {
+		__m256i input;
+		if (end - block >= 32) {
+			input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+		} else {
+			/* zero padding is ASCII, so a sequence cut by the end still fails */
+			std::memset(tail, 0, sizeof(tail));
+			std::memcpy(tail, block, end - block);
+			input = _mm256_load_si256(reinterpret_cast<const __m256i*>(tail));
+		}
+		if (!_mm256_movemask_epi8(input)) {
+			error = _mm256_or_si256(error, prev_incomplete);
+		} else {
+			error = _mm256_or_si256(error, avx2_utf8_errors(input, prev_input));
+			prev_incomplete = avx2_utf8_incomplete(input);
+		}
+		if (!_mm256_testz_si256(error, error)) {
+			break;
+		}
+		prev_input = input;
+		block += 32;
+	}
+	if (block >= end) {
+		if (_mm256_testz_si256(prev_incomplete, prev_incomplete)) {
+			return end;
+		}
+		block = end;
+	}
+
+	/* bytes before `block` are well-formed, except that a sequence led by
+	 * one of the last three may be cut short. restart the exact scalar check
+	 * at the first sequence boundary among them to find the byte. */
+	const char* restart = block - begin >= 3 ? block - 3 : begin;
+	while (restart < block && (static_cast<unsigned char>(*restart) & 0xc0) == 0x80) {
+		++restart;
+	}
+	return scalar_validate_utf8(restart, end);
+}
+
+static bool cpu_supports_avx2() {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) {
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+static constexpr scan_kernels scalar_kernels {
+	.validate_utf8 = scalar_validate_utf8,
+};
+#ifdef SCAN_X86
+static constexpr scan_kernels sse2_kernels {
+	.validate_utf8 = sse2_validate_utf8,
+};
+static constexpr scan_kernels avx2_kernels {
+	.validate_utf8 = avx2_validate_utf8,
+};
+#endif
+
+struct scan_state {
+	scan_mode mode;
+	const scan_kernels* kernels;
+};
+static scan_state& get_scan_state() {
+	static scan_state state = [] {
+#ifdef SCAN_X86
+		if (is_scan_mode_supported(scan_mode::avx2)) {
+			return scan_state { .mode = scan_mode::avx2, .kernels = &avx2_kernels };
+		}
+		return scan_state { .mode = scan_mode::sse2, .kernels = &sse2_kernels };
+#else
+		return scan_state { .mode = scan_mode::scalar, .kernels = &scalar_kernels };
+#endif
+	}();
+	return state;
+}
+
+const scan_kernels& get_scan_kernels() {
+	return *get_scan_state().kernels;
+}
+scan_mode get_scan_mode() {
+	return get_scan_state().mode;
+}
+bool set_scan_mode(scan_mode mode) {
+	if (!is_scan_mode_supported(mode)) {
+		return false;
+	}
+	scan_state& state = get_scan_state();
+	state.mode = mode;
+	switch (mode) {
+#ifdef SCAN_X86
+	case scan_mode::sse2:
+		state.kernels = &sse2_kernels;
+		break;
+	case scan_mode::avx2:
+		state.kernels = &avx2_kernels;
+		break;
+#endif
+	default:
+		state.kernels = &scalar_kernels;
+		break;
+	}
+	return true;
+}
+bool is_scan_mode_supported(scan_mode mode) {
+	switch (mode) {
+	case scan_mode::scalar:
+		return true;
+#ifdef SCAN_X86
+	case scan_mode::sse2:
+		return true;
+	case scan_mode::avx2: {
+		static const bool avx2 = cpu_supports_avx2();
+		return avx2;
+	}
+#endif
+	default:
+		break;
+	}
+	return false;
+}
+
+const char* to_string(scan_mode mode) {
+	switch (mode) {
+	case scan_mode::scalar:
+		return "scalar";
+	case scan_mode::sse2:
+		return "sse2";
+	case scan_mode::avx2:
+		return "avx2";
+	default:
+		break;
+	}
+	return "unknown";
+}
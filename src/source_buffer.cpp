@@ -0,0 +1,130 @@
+#include "source_buffer.hpp"
+
+
+source_buffer::source_buffer(std::string source) :
+	_text(std::move(source)),
+	_file(),
+	_view(_text),
+	_in(nullptr),
+	_chunk_size(0),
+	_blocks(),
+	_carry(),
+	_handed(0),
+	_exhausted(false),
+	_is_too_large(false),
+	_size(0),
+	_lines(),
+	_lined_blocks(0)
+{
+	if (_text.size() > source_file::max_size) {
+		_text = std::string();
+		_view = _text;
+		_is_too_large = true;
+	}
+}
+source_buffer::source_buffer(source_file file) :
+	_text(),
+	_file(std::move(file)),
+	_view(_file->text()),
+	_in(nullptr),
+	_chunk_size(0),
+	_blocks(),
+	_carry(),
+	_handed(0),
+	_exhausted(false),
+	_is_too_large(_file->is_too_large()),
+	_size(0),
+	_lines(),
+	_lined_blocks(0)
+{}
+source_buffer::source_buffer(std::istream& in, std::size_t chunk_size) :
+	_text(),
+	_file(),
+	_view(),
+	_in(&in),
+	_chunk_size(chunk_size ? chunk_size : default_chunk_size),
+	_blocks(),
+	_carry(),
+	_handed(0),
+	_exhausted(false),
+	_is_too_large(false),
+	_size(0),
+	_lines(),
+	_lined_blocks(0)
+{}
+
+std::string_view source_buffer::next_block() {
+	if (!_in) {
+		if (_handed != 0) {
+			return {};
+		}
+		_handed = 1;
+		return _view;
+	}
+	if (_handed < _blocks.size()) {
+		return *_blocks[_handed++];
+	}
+	if (_exhausted) {
+		return {};
+	}
+
+	std::unique_ptr<std::string> block = std::make_unique<std::string>(std::move(_carry));
+	_carry.clear();
+	for (;;) {
+		std::size_t size = block->size();
+		block->resize(size + _chunk_size);
+		_in->read(block->data() + size, _chunk_size);
+		block->resize(size + _in->gcount());
+		if (!*_in) {
+			/* end of input: whatever is left is the last block */
+			_exhausted = true;
+			break;
+		}
+		std::size_t line_end = block->find_last_of('\n');
+		if (line_end != std::string::npos && line_end >= size) {
+			_carry.assign(*block, line_end + 1);
+			block->resize(line_end + 1);
+			break;
+		}
+		/* no line boundary yet, keep reading into the same block */
+	}
+	if (block->empty()) {
+		return {};
+	}
+	_size += block->size();
+	if (_size > source_file::max_size) {
+		_exhausted = true;
+		_is_too_large = true;
+		_carry.clear();
+		return {};
+	}
+	_blocks.push_back(std::move(block));
+	++_handed;
+	return *_blocks.back();
+}
+void source_buffer::rewind() {
+	_handed = 0;
+}
+
+std::string_view source_buffer::text() const {
+	return _view;
+}
+bool source_buffer::is_streaming() const {
+	return _in != nullptr;
+}
+bool source_buffer::is_too_large() const {
+	return _is_too_large;
+}
+const line_table& source_buffer::lines() {
+	if (!_in) {
+		if (_lined_blocks == 0) {
+			_lines.append(_view);
+			_lined_blocks = 1;
+		}
+		return _lines;
+	}
+	for (; _lined_blocks < _blocks.size(); ++_lined_blocks) {
+		_lines.append(*_blocks[_lined_blocks]);
+	}
+	return _lines;
+}
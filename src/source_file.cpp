@@ -0,0 +1,185 @@
+#include "source_file.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+static std::size_t page_size() {
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwPageSize;
+#else
+	return static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+/* maps `path` when it is a regular file of at most `size_limit` bytes whose
+ * last page has room for the sentinel. returns nullptr when the caller
+ * should read the file instead. `size` is set for any regular file, mapped
+ * or not. */
+static const char* map_file(const std::string& path, std::size_t size_limit, std::size_t& size) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return nullptr;
+	}
+	LARGE_INTEGER file_size;
+	if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &file_size)) {
+		CloseHandle(file);
+		return nullptr;
+	}
+	size = static_cast<std::size_t>(file_size.QuadPart);
+	if (size == 0 || size > size_limit || size % page_size() == 0) {
+		CloseHandle(file);
+		return nullptr;
+	}
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping) {
+		return nullptr;
+	}
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!view) {
+		return nullptr;
+	}
+	return static_cast<const char*>(view);
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return nullptr;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+		close(fd);
+		return nullptr;
+	}
+	size = static_cast<std::size_t>(st.st_size);
+	if (size == 0 || size > size_limit || size % page_size() == 0) {
+		close(fd);
+		return nullptr;
+	}
+	void* view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (view == MAP_FAILED) {
+		return nullptr;
+	}
+	madvise(view, st.st_size, MADV_SEQUENTIAL);
+	return static_cast<const char*>(view);
+#endif
+}
+
+source_file::source_file(const std::string& path, std::size_t size_limit) :
+	_buffer(),
+	_mapped(nullptr),
+	_mapped_size(0),
+	_text(),
+	_is_open(false),
+	_is_too_large(false)
+{
+	std::size_t size = 0;
+	size_limit = std::min(size_limit, max_size);
+	_mapped = map_file(path, size_limit, size);
+	if (_mapped) {
+		_mapped_size = size;
+		_text = std::string_view(_mapped, _mapped_size);
+		_is_open = true;
+		return;
+	}
+	if (size > size_limit) {
+		_is_too_large = true;
+		return;
+	}
+	_is_open = read_all(path, size_limit);
+	_text = _buffer;
+}
+source_file::~source_file() {
+	unmap();
+}
+
+source_file::source_file(source_file&& rhs) noexcept :
+	_buffer(std::move(rhs._buffer)),
+	_mapped(std::exchange(rhs._mapped, nullptr)),
+	_mapped_size(std::exchange(rhs._mapped_size, 0)),
+	_text(_mapped ? rhs._text : std::string_view(_buffer)),
+	_is_open(std::exchange(rhs._is_open, false)),
+	_is_too_large(std::exchange(rhs._is_too_large, false))
+{
+	rhs._text = {};
+}
+source_file& source_file::operator=(source_file&& rhs) noexcept {
+	if (this == &rhs) {
+		return *this;
+	}
+	unmap();
+	_buffer = std::move(rhs._buffer);
+	_mapped = std::exchange(rhs._mapped, nullptr);
+	_mapped_size = std::exchange(rhs._mapped_size, 0);
+	_text = _mapped ? rhs._text : std::string_view(_buffer);
+	_is_open = std::exchange(rhs._is_open, false);
+	_is_too_large = std::exchange(rhs._is_too_large, false);
+	rhs._text = {};
+	return *this;
+}
+
+bool source_file::is_open() const {
+	return _is_open;
+}
+bool source_file::is_too_large() const {
+	return _is_too_large;
+}
+bool source_file::is_mapped() const {
+	return _mapped != nullptr;
+}
+std::string_view source_file::text() const {
+	return _text;
+}
+
+void source_file::unmap() {
+	if (!_mapped) {
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(_mapped);
+#else
+	munmap(const_cast<char*>(_mapped), _mapped_size);
+#endif
+	_mapped = nullptr;
+	_mapped_size = 0;
+}
+
+bool source_file::read_all(const std::string& path, std::size_t size_limit) {
+	std::FILE* file = std::fopen(path.c_str(), "rb");
+	if (!file) {
+		return false;
+	}
+	constexpr std::size_t chunk_size = 64 * 1024;
+	std::size_t size = 0;
+	for (;;) {
+		_buffer.resize(size + chunk_size);
+		std::size_t read = std::fread(_buffer.data() + size, 1, chunk_size, file);
+		size += read;
+		if (read < chunk_size || size > size_limit) {
+			break;
+		}
+	}
+	/* a pipe has no size to check up front */
+	_is_too_large = size > size_limit;
+	_buffer.resize(_is_too_large ? 0 : size);
+	_buffer.shrink_to_fit();
+	bool failed = std::ferror(file) != 0;
+	std::fclose(file);
+	return !failed && !_is_too_large;
+}
@@ -0,0 +1,141 @@
+#include "superinstruction_selector.hpp"
+#include <optional>
+
+
+namespace {
+	using iterator = std::list<std::unique_ptr<instruct>>::iterator;
+
+	struct operation {
+		arithmetic op;
+		object_type type;
+	};
+
+	template <class T>
+	T* as(const std::unique_ptr<instruct>& inst) {
+		return dynamic_cast<T*>(inst.get());
+	}
+	push_instruct* variable_push(const std::unique_ptr<instruct>& inst) {
+		push_instruct* push = as<push_instruct>(inst);
+		return push && push->value.type == operand_type::variable ? push : nullptr;
+	}
+	/* a push of no value is how the encoder aborts, so it is never fused */
+	push_instruct* literal_push(const std::unique_ptr<instruct>& inst) {
+		push_instruct* push = as<push_instruct>(inst);
+		return push && push->value.type == operand_type::immidiate &&
+			push->value.value.index() != INVALID_TYPE_INDEX ? push : nullptr;
+	}
+	std::optional<operation> operation_of(const std::unique_ptr<instruct>& inst) {
+		if (as<add_instruct>(inst)) { return operation { arithmetic::add, object_type::integer }; }
+		if (as<sub_instruct>(inst)) { return operation { arithmetic::sub, object_type::integer }; }
+		if (as<mul_instruct>(inst)) { return operation { arithmetic::mul, object_type::integer }; }
+		if (as<div_instruct>(inst)) { return operation { arithmetic::div, object_type::integer }; }
+		if (as<addf_instruct>(inst)) { return operation { arithmetic::add, object_type::floating }; }
+		if (as<subf_instruct>(inst)) { return operation { arithmetic::sub, object_type::floating }; }
+		if (as<mulf_instruct>(inst)) { return operation { arithmetic::mul, object_type::floating }; }
+		if (as<divf_instruct>(inst)) { return operation { arithmetic::div, object_type::floating }; }
+		return std::nullopt;
+	}
+	/* verified code divides by an immediate without checking it, so the
+	 * divisors that can fail stay a push and a div */
+	bool fuses_with_immediate(const operation& operation, const OBJECT& rhs) {
+		if (operation.op != arithmetic::div || operation.type != object_type::integer) {
+			return true;
+		}
+		const int* divisor = std::get_if<int>(&rhs);
+		return divisor && *divisor != 0 && *divisor != -1;
+	}
+
+	/* the `count` instructions from `at`, or none where the list ends first */
+	bool take(std::list<std::unique_ptr<instruct>>& codes, iterator at, std::size_t count, iterator* out) {
+		for (std::size_t index = 0; index < count; ++index, ++at) {
+			if (at == codes.end()) {
+				return false;
+			}
+			out[index] = at;
+		}
+		return true;
+	}
+	/* puts `fused` in place of the `count` instructions from `first` and
+	 * returns the position after it */
+	iterator replace(std::list<std::unique_ptr<instruct>>& codes, iterator first, std::size_t count,
+		std::unique_ptr<instruct> fused)
+	{
+		iterator last = std::next(first, count);
+		*first = std::move(fused);
+		codes.erase(std::next(first), last);
+		return last;
+	}
+}
+
+std::size_t superinstruction_selector::select(std::list<std::unique_ptr<instruct>>& codes) {
+	std::size_t fused = 0;
+	for (iterator at = codes.begin(); at != codes.end();) {
+		iterator window[3];
+		bool has_three = take(codes, at, 3, window);
+		bool has_two = has_three || take(codes, at, 2, window);
+
+		if (alloc_instruct* alloc = as<alloc_instruct>(*at); alloc && has_three) {
+			push_instruct* push = literal_push(*window[1]);
+			init_instruct* init = as<init_instruct>(*window[2]);
+			if (push && init && init->slot == alloc->slot) {
+				std::unique_ptr<init_from_imm_instruct> inst = std::make_unique<init_from_imm_instruct>();
+				inst->is_mutable = alloc->is_mutable;
+				inst->name = alloc->name;
+				inst->slot = alloc->slot;
+				inst->type = alloc->type;
+				inst->value = push->value.value;
+				at = replace(codes, at, 3, std::move(inst));
+				++fused;
+				continue;
+			}
+		}
+
+		push_instruct* lhs = variable_push(*at);
+		if (lhs && has_three) {
+			std::optional<operation> operation = operation_of(*window[2]);
+			if (push_instruct* rhs = literal_push(*window[1]); operation && rhs && fuses_with_immediate(*operation, rhs->value.value)) {
+				std::unique_ptr<binary_var_imm_instruct> inst = std::make_unique<binary_var_imm_instruct>();
+				inst->op = operation->op;
+				inst->type = operation->type;
+				inst->lhs = lhs->value.name;
+				inst->slot = lhs->value.slot;
+				inst->rhs = rhs->value.value;
+				at = replace(codes, at, 3, std::move(inst));
+				++fused;
+				continue;
+			}
+			if (push_instruct* rhs = variable_push(*window[1]); operation && rhs) {
+				std::unique_ptr<binary_var_var_instruct> inst = std::make_unique<binary_var_var_instruct>();
+				inst->op = operation->op;
+				inst->type = operation->type;
+				inst->lhs = lhs->value.name;
+				inst->lhs_slot = lhs->value.slot;
+				inst->rhs = rhs->value.name;
+				inst->rhs_slot = rhs->value.slot;
+				at = replace(codes, at, 3, std::move(inst));
+				++fused;
+				continue;
+			}
+		}
+		if (lhs && has_two) {
+			if (cast_instruct* cast = as<cast_instruct>(*window[1])) {
+				std::unique_ptr<push_var_cast_instruct> inst = std::make_unique<push_var_cast_instruct>();
+				inst->name = lhs->value.name;
+				inst->slot = lhs->value.slot;
+				inst->to = cast->to;
+				at = replace(codes, at, 2, std::move(inst));
+				++fused;
+				continue;
+			}
+		}
+		++at;
+	}
+	return fused;
+}
+std::size_t superinstruction_selector::select(asm_context& con) {
+	std::size_t fused = select(con.codes);
+	con.functions.for_each([&fused](symbol, asm_context::function_info& info) {
+		fused += select(info.instruction);
+	});
+	return fused;
+}
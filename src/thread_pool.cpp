@@ -0,0 +1,47 @@
+#include "thread_pool.hpp"
+
+
+thread_pool::thread_pool(unsigned int thread_count) :
+	_workers(),
+	_tasks(),
+	_mutex(),
+	_cond(),
+	_stop(false)
+{
+	if (!thread_count) {
+		thread_count = 1;
+	}
+	for (unsigned int index = 0; index < thread_count; ++index) {
+		_workers.emplace_back(&thread_pool::worker, this);
+	}
+}
+thread_pool::~thread_pool() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_cond.notify_all();
+	for (std::thread& th : _workers) {
+		th.join();
+	}
+}
+
+unsigned int thread_pool::size() const {
+	return static_cast<unsigned int>(_workers.size());
+}
+
+void thread_pool::worker() {
+	for (;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_cond.wait(lock, [this] { return _stop || !_tasks.empty(); });
+			if (_tasks.empty()) {
+				return;
+			}
+			task = std::move(_tasks.front());
+			_tasks.pop();
+		}
+		task();
+	}
+}
@@ -0,0 +1,96 @@
+#include "token_array.hpp"
+#include <algorithm>
+#include <cassert>
+
+
+std::size_t token_array::size() const {
+	return _kinds.size();
+}
+bool token_array::empty() const {
+	return _kinds.empty();
+}
+void token_array::reserve(std::size_t count) {
+	_kinds.reserve(count);
+	_offsets.reserve(count);
+	_payloads.reserve(count);
+}
+void token_array::clear() {
+	_kinds.clear();
+	_offsets.clear();
+	_payloads.clear();
+	_origins.clear();
+}
+
+token token_array::operator[](std::size_t index) const {
+	token tok {
+		.str = {},
+		.type = _kinds[index],
+		.offset = _offsets[index],
+		.sym = no_symbol
+	};
+	std::uint32_t payload = _payloads[index];
+	std::size_t length;
+	switch (tok.type) {
+	case token_type::number:
+	case token_type::floating:
+	case token_type::unknown:
+		length = payload;
+		break;
+	case token_type::identifier:
+		tok.sym = payload;
+		length = interner::get_instance()->name(payload).size();
+		break;
+	default:
+		length = spelling(tok.type).size();
+		break;
+	}
+	tok.str = std::string_view(text_at(index), length);
+	return tok;
+}
+token token_array::back() const {
+	return (*this)[size() - 1];
+}
+token_type token_array::kind(std::size_t index) const {
+	return _kinds[index];
+}
+std::uint32_t token_array::offset(std::size_t index) const {
+	return _offsets[index];
+}
+
+void token_array::append(const token_array& other, std::size_t first, std::size_t last) {
+	for (std::size_t index = first; index < last; ++index) {
+		push_back(other[index]);
+	}
+}
+
+void token_array::resize(std::size_t count, const token_array& like) {
+	assert(like._origins.size() == 1);
+	clear();
+	_kinds.resize(count);
+	_offsets.resize(count);
+	_payloads.resize(count);
+	_origins = like._origins;
+}
+void token_array::assign(std::size_t index, const token_array& other, std::size_t count) {
+	assert(other._origins.size() == 1 && other._origins.front().base == _origins.front().base);
+	std::copy_n(other._kinds.begin(), count, _kinds.begin() + index);
+	std::copy_n(other._offsets.begin(), count, _offsets.begin() + index);
+	std::copy_n(other._payloads.begin(), count, _payloads.begin() + index);
+}
+
+std::size_t token_array::memory_size() const {
+	return _kinds.size() * sizeof(token_type) + _offsets.size() * sizeof(std::uint32_t) +
+		_payloads.size() * sizeof(std::uint32_t) + _origins.size() * sizeof(origin);
+}
+
+const char* token_array::text_at(std::size_t index) const {
+	auto itr = _origins.begin();
+	if (_origins.size() > 1) {
+		itr = std::upper_bound(_origins.begin(), _origins.end(), index,
+			[](std::size_t value, const origin& entry) { return value < entry.first; }) - 1;
+	}
+	return reinterpret_cast<const char*>(itr->base + _offsets[index]);
+}
+void token_array::add_origin(std::size_t first, std::uintptr_t base) {
+	_origins.push_back(origin { .first = first, .base = base });
+}
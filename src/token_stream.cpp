@@ -0,0 +1,61 @@
+#include "token_stream.hpp"
+#include <algorithm>
+#include <cassert>
+
+
+token_stream::token_stream(lexer& source) :
+	_lexer(&source),
+	_tokens(nullptr),
+	_ring(lookahead),
+	_released(0),
+	_filled(0),
+	_furthest(0)
+{}
+token_stream::token_stream(const token_array& tokens) :
+	_lexer(nullptr),
+	_tokens(&tokens),
+	_ring(lookahead),
+	_released(0),
+	_filled(0),
+	_furthest(0)
+{}
+
+token_stream::iterator token_stream::begin() {
+	return iterator(this, _released);
+}
+
+const token& token_stream::at(std::size_t index) {
+	if (index > _furthest) {
+		_furthest = index;
+	}
+	assert(index >= _released);
+	if (index - _released >= _ring.size()) {
+		std::size_t size = _ring.size();
+		while (index - _released >= size) {
+			size <<= 1;
+		}
+		std::vector<token> ring(size);
+		for (std::size_t i = _released; i < _filled; ++i) {
+			ring[i & (size - 1)] = _ring[i & (_ring.size() - 1)];
+		}
+		_ring = std::move(ring);
+	}
+	while (_filled <= index) {
+		token& slot = _ring[_filled & (_ring.size() - 1)];
+		if (_tokens) {
+			slot = (*_tokens)[std::min(_filled, _tokens->size() - 1)];
+		} else {
+			slot = _lexer->next();
+		}
+		++_filled;
+	}
+	return _ring[index & (_ring.size() - 1)];
+}
+void token_stream::release(std::size_t index) {
+	if (index > _released) {
+		_released = index;
+	}
+}
+std::size_t token_stream::furthest() const {
+	return _furthest;
+}
@@ -1,203 +1,321 @@
 #include "tokenize.hpp"
 #include "utf8_char.hpp"
+#include "unicode.hpp"
+#include "scan.hpp"
+#include "source_buffer.hpp"
+#include "token_array.hpp"
+#include <array>
+#include <cstdint>
 
 
-void lexer::skip_space(context& con) {
-	char* pp = con.p;
-	while (isspace(*pp)) {
-		if (*pp == '\n') {
-			++con.point.line;
-			con.point.line_head = pp;
-			con.point.col = -1;
-		}
-		++con.point.col;
-		++pp;
+enum class char_class : std::uint8_t {
+	unknown,
+	eof,
+	space,
+	newline,
+	digit,
+	alpha,
+	dot,
+	sign,
+	non_ascii,
+};
+
+struct sign_info {
+	std::string_view str;
+	token_type type;
+};
+static constexpr sign_info sign_list[] = {
+	{ .str = "+", .type = token_type::plus },
+	{ .str = "-", .type = token_type::minus },
+	{ .str = "*", .type = token_type::asterisk },
+	{ .str = "/", .type = token_type::slash },
+	{ .str = "(", .type = token_type::l_paren },
+	{ .str = ")", .type = token_type::r_paren },
+	{ .str = ";", .type = token_type::semicolon },
+	{ .str = ":", .type = token_type::colon },
+	{ .str = "=", .type = token_type::equal },
+	{ .str = ",", .type = token_type::comma },
+	{ .str = "->", .type = token_type::arrow },
+	{ .str = "{", .type = token_type::l_brace },
+	{ .str = "}", .type = token_type::r_brace }
+};
+
+static constexpr std::array<char_class, 256> make_char_table() {
+	std::array<char_class, 256> table {};
+	table['\0'] = char_class::eof;
+	for (unsigned char c : std::string_view(" \t\v\f\r")) {
+		table[c] = char_class::space;
 	}
-	con.p = pp;
-}
-std::optional<token> lexer::try_parse_number(context& con) {
-	char* p = con.p;
-	std::string str;
-	while (*p >= '0' && *p <= '9') {
-		str += *p++;
+	table['\n'] = char_class::newline;
+	for (int c = '0'; c <= '9'; ++c) {
+		table[c] = char_class::digit;
 	}
-	if (str.empty()) {
-		if (*p != '.') {
-			return std::nullopt;
-		}
-		str += *p++;
-		if (*p < '0' || *p > '9') {
-			return std::nullopt;
-		}
-		while (*p >= '0' && *p <= '9') {
-			str += *p++;
-		}
-		token tok{
-			.str = str,
-			.type = token_type::floating,
-			.point = con.point
-		};
-		con.point.col += p - con.p;
-		con.p = p;
-		return tok;
+	for (int c = 'a'; c <= 'z'; ++c) {
+		table[c] = char_class::alpha;
+		table[c - 'a' + 'A'] = char_class::alpha;
 	}
-
-	if (*p == '.') {
-		str += *p++;
-		while (*p >= '0' && *p <= '9') {
-			str += *p++;
-		}
-		token tok{
-			.str = str,
-			.type = token_type::floating,
-			.point = con.point
-		};
-		con.point.col += p - con.p;
-		con.p = p;
-		return tok;
+	table['_'] = char_class::alpha;
+	table['.'] = char_class::dot;
+	for (const sign_info& sign : sign_list) {
+		table[static_cast<unsigned char>(sign.str[0])] = char_class::sign;
 	}
-	token tok = {
-		.str = str,
-		.type = token_type::number,
-		.point = con.point
-	};
-	con.point.col += p - con.p;
-	con.p = p;
-	return tok;
+	for (int c = 0x80; c <= 0xff; ++c) {
+		table[c] = char_class::non_ascii;
+	}
+	return table;
 }
-std::optional<token> lexer::try_parse_sign(context& con) {
-	static std::vector<std::string> sign_list = {
-		"+", "-", "*", "/",
-		"(", ")", ";", ":", "=",
-		",", "->", "{", "}"
-	};
+static constexpr std::array<char_class, 256> char_table = make_char_table();
 
-	auto start_with = [](char* p, const char* keyword) {
-		while (*keyword) {
-			if (*p++ != *keyword++) {
-				return false;
-			}
-		}
-		return true;
-	};
+static constexpr char_class class_of(char c) {
+	return char_table[static_cast<unsigned char>(c)];
+}
 
-	int len = 0;
-	int cand_index = 0;
-	for (int index = 0; index < sign_list.size(); ++index) {
-		if (!start_with(con.p, sign_list[index].c_str())) {
-			continue;
-		}
-		if (sign_list[index].size() > len) {
-			len = sign_list[index].size();
-			cand_index = index;
+/* maximal-munch DFA over sign_list: state 0 is the start state and every
+ * other state is accepting, so the lexer stops at the first missing edge.
+ * `accept` is the kind of the sign that ends in a state; a state that is
+ * only a prefix of longer signs accepts as unknown. */
+struct sign_dfa {
+	static constexpr int max_state = 32;
+	std::uint8_t next[max_state][256];
+	token_type accept[max_state];
+	int state_count;
+};
+static constexpr sign_dfa make_sign_dfa() {
+	sign_dfa dfa {};
+	dfa.state_count = 1;
+	for (const sign_info& sign : sign_list) {
+		int state = 0;
+		for (unsigned char c : sign.str) {
+			if (!dfa.next[state][c]) {
+				if (dfa.state_count >= sign_dfa::max_state) {
+					throw "too many states in sign_dfa";
+				}
+				dfa.next[state][c] = static_cast<std::uint8_t>(dfa.state_count++);
+			}
+			state = dfa.next[state][c];
 		}
+		dfa.accept[state] = sign.type;
 	}
-	if (!len) {
-		return std::nullopt;
-	}
-	token tok = {
-		.str = sign_list[cand_index],
-		.type = token_type::sign,
-		.point = con.point
-	};
-	con.p += len;
-	con.point.col += len;
-	return tok;
+	return dfa;
 }
-std::optional<token> lexer::try_parse_keyword(context& con) {
-	struct keyword_info {
-		std::string str;
-		token_type type;
-	};
-	static keyword_info keywords[] = {
-		{ .str = "return", .type = token_type::_return },
-		{ .str = "const", .type = token_type::_const },
-		{ .str = "mut", .type = token_type::_mut },
-		{ .str = "int", .type = token_type::_int },
-		{ .str = "float", .type = token_type::_float },
-		{ .str = "fn", .type = token_type::_fn }
-	};
+static constexpr sign_dfa sign_table = make_sign_dfa();
 
-	auto start_with = [](char* p, const char* keyword) {
-		while (*keyword) {
-			if (*p++ != *keyword++) {
-				return false;
-			}
-		}
-		return true;
-		};
-
-	int len = 0;
-	int cand_index = 0;
-	for (int index = 0; index < sizeof(keywords) / sizeof(*keywords); ++index) {
-		if (!start_with(con.p, keywords[index].str.c_str())) {
-			continue;
-		}
-		if (keywords[index].str.size() > len) {
-			len = keywords[index].str.size();
-			cand_index = index;
+/* perfect hash over the keywords. the table is checked for collisions at
+ * compile time, so adding a keyword that collides fails to build. */
+struct keyword_info {
+	std::string_view str;
+	token_type type;
+};
+static constexpr keyword_info keywords[] = {
+	{ .str = "return", .type = token_type::_return },
+	{ .str = "const", .type = token_type::_const },
+	{ .str = "mut", .type = token_type::_mut },
+	{ .str = "int", .type = token_type::_int },
+	{ .str = "float", .type = token_type::_float },
+	{ .str = "fn", .type = token_type::_fn }
+};
+static constexpr std::size_t keyword_hash_size = 8;
+
+static constexpr std::size_t keyword_hash(std::string_view str) {
+	return (static_cast<unsigned char>(str.front()) + static_cast<unsigned char>(str.back()))
+		& (keyword_hash_size - 1);
+}
+static constexpr std::array<keyword_info, keyword_hash_size> make_keyword_table() {
+	std::array<keyword_info, keyword_hash_size> table {};
+	for (const keyword_info& info : keywords) {
+		keyword_info& slot = table[keyword_hash(info.str)];
+		if (!slot.str.empty()) {
+			throw "keyword_hash has a collision";
 		}
+		slot = info;
 	}
-	if (!len) {
-		return std::nullopt;
+	return table;
+}
+static constexpr std::array<keyword_info, keyword_hash_size> keyword_table = make_keyword_table();
+
+static constexpr token_type lookup_keyword(std::string_view str) {
+	const keyword_info& info = keyword_table[keyword_hash(str)];
+	return info.str == str ? info.type : token_type::identifier;
+}
+static_assert(lookup_keyword("return") == token_type::_return);
+static_assert(lookup_keyword("fn") == token_type::_fn);
+static_assert(lookup_keyword("fnx") == token_type::identifier);
+
+static constexpr std::array<std::string_view, token_type_count> make_spelling_table() {
+	std::array<std::string_view, token_type_count> table {};
+	for (const sign_info& sign : sign_list) {
+		table[static_cast<std::size_t>(sign.type)] = sign.str;
 	}
-	con.p += len;
-	if (std::isalnum(*con.p) || *con.p == '_') {
-		con.p -= len;
-		return std::nullopt;
+	for (const keyword_info& info : keywords) {
+		table[static_cast<std::size_t>(info.type)] = info.str;
 	}
-	token tok = {
-		.str = keywords[cand_index].str,
-		.type = keywords[cand_index].type,
-		.point = con.point
-	};
-	con.point.col += len;
-	return tok;
+	return table;
+}
+static constexpr std::array<std::string_view, token_type_count> spelling_table = make_spelling_table();
+
+std::string_view spelling(token_type type) {
+	return spelling_table[static_cast<std::size_t>(type)];
 }
 
-std::optional<token> lexer::try_parse_identifier(context& con) {
-	std::string str;
-	if (!isalpha(*con.p) && *con.p != '_') {
-		return std::nullopt;
+
+token lexer::parse_number(context& con) {
+	const char* p = skip_digits(con.p, con.end, con.vector_skip);
+	token_type type = token_type::number;
+	if (p < con.end && *p == '.') {
+		p = skip_digits(p + 1, con.end, con.vector_skip);
+		type = token_type::floating;
 	}
-	str += *con.p++;
-	++con.point.col;
-	while (*con.p) {
-		if (isalnum(*con.p) || *con.p == '_') {
-			str += *con.p++;
-			++con.point.col;
+	return make_token(con, p, type);
+}
+token lexer::parse_identifier(context& con, const char* p) {
+	/* the ASCII kernel stops at the first non-ASCII byte; from there the
+	 * identifier continues for as long as the characters are XID_Continue */
+	p = skip_identifier(p, con.end, con.vector_skip);
+	while (p < con.valid_end && static_cast<unsigned char>(*p) >= 0x80) {
+		utf8_char_view c(p);
+		if (!is_xid_continue(c.code_point())) {
+			break;
 		}
-		else {
+		p = skip_identifier(p + c.char_size(), con.end, con.vector_skip);
+	}
+	std::string_view str(con.p, p - con.p);
+	token_type type = lookup_keyword(str);
+	token tok = make_token(con, p, type);
+	if (type == token_type::identifier) {
+		tok.sym = con.names->intern(str);
+	}
+	return tok;
+}
+token lexer::parse_sign(context& con) {
+	const char* p = con.p;
+	int state = 0;
+	while (p < con.end) {
+		int next = sign_table.next[state][static_cast<unsigned char>(*p)];
+		if (!next) {
 			break;
 		}
+		state = next;
+		++p;
+	}
+	return make_token(con, p, sign_table.accept[state]);
+}
+token lexer::parse_non_ascii(context& con) {
+	if (con.p >= con.valid_end) {
+		/* one ill-formed byte is one unknown token; validation resumes after it */
+		token tok = make_token(con, con.p + 1, token_type::unknown);
+		con.valid_end = con.kernels->validate_utf8(con.p, con.end);
+		return tok;
+	}
+	utf8_char_view c(con.p);
+	if (is_xid_start(c.code_point())) {
+		return parse_identifier(con, con.p + c.char_size());
 	}
+	return make_token(con, con.p + c.char_size(), token_type::unknown);
+}
+token lexer::parse_unknown(context& con) {
+	return make_token(con, con.p + 1, token_type::unknown);
+}
+token lexer::make_token(context& con, const char* end, token_type type) {
 	token tok = {
-		.str = str,
-		.type = token_type::identifier,
-		.point = con.point
+		.str = std::string_view(con.p, end - con.p),
+		.type = type,
+		.offset = static_cast<std::uint32_t>(con.base + (con.p - con.begin)),
+		.sym = no_symbol
 	};
+	con.p = end;
 	return tok;
 }
 
-std::vector<token> lexer::tokenize(const std::string& source) {
-	context con { .point = {}, .p = const_cast<char*>(source.data()) };
-	std::vector<token> tokens;
+lexer::lexer(std::string_view source, std::uint32_t start) :
+	_con {
+		.p = source.data(),
+		.end = source.data() + source.size(),
+		.begin = source.data(),
+		.base = start,
+		.valid_end = nullptr,
+		.kernels = &get_scan_kernels(),
+		.vector_skip = get_scan_mode() != scan_mode::scalar,
+		.names = interner::get_instance()
+	},
+	_source(nullptr)
+{
+	_con.valid_end = _con.kernels->validate_utf8(_con.p, _con.end);
+}
+lexer::lexer(source_buffer& source) :
+	_con {
+		.p = "",
+		.end = nullptr,
+		.begin = nullptr,
+		.base = 0,
+		.valid_end = nullptr,
+		.kernels = &get_scan_kernels(),
+		.vector_skip = get_scan_mode() != scan_mode::scalar,
+		.names = interner::get_instance()
+	},
+	_source(&source)
+{
+	_con.end = _con.p;
+	_con.begin = _con.p;
+	_con.valid_end = _con.p;
+	next_block();
+}
 
-	while (*(con.p)) {
-		skip_space(con);
-		if (std::optional<token> tok = try_parse_number(con)) {
-			tokens.push_back(tok.value());
-		}
-		if (std::optional<token> tok = try_parse_sign(con)) {
-			tokens.push_back(tok.value());
-		}
-		if (std::optional<token> tok = try_parse_keyword(con)) {
-			tokens.push_back(tok.value());
+bool lexer::next_block() {
+	if (!_source) {
+		return false;
+	}
+	std::string_view block = _source->next_block();
+	if (block.empty()) {
+		_source = nullptr;
+		return false;
+	}
+	_con.base = static_cast<std::uint32_t>(_con.base + (_con.end - _con.begin));
+	_con.p = block.data();
+	_con.end = block.data() + block.size();
+	_con.begin = block.data();
+	_con.valid_end = _con.kernels->validate_utf8(_con.p, _con.end);
+	return true;
+}
+
+token lexer::next() {
+	for (;;) {
+		_con.p = skip_space(_con.p, _con.end, _con.vector_skip);
+		if (_con.p == _con.end) {
+			if (next_block()) {
+				continue;
+			}
+			return make_token(_con, _con.p, token_type::eof);
 		}
-		if (std::optional<token> tok = try_parse_identifier(con)) {
-			tokens.push_back(tok.value());
+		switch (class_of(*_con.p)) {
+		case char_class::eof:
+			return make_token(_con, _con.p, token_type::eof);
+		case char_class::digit:
+			return parse_number(_con);
+		case char_class::dot:
+			if (_con.end - _con.p > 1 && class_of(_con.p[1]) == char_class::digit) {
+				return parse_number(_con);
+			}
+			return parse_unknown(_con);
+		case char_class::alpha:
+			return parse_identifier(_con, _con.p + 1);
+		case char_class::sign:
+			return parse_sign(_con);
+		case char_class::non_ascii:
+			return parse_non_ascii(_con);
+		default:
+			return parse_unknown(_con);
 		}
 	}
-	tokens.push_back({ .str = "", .type = token_type::eof, .point = con.point });
+}
+
+token_array lexer::tokenize(std::string_view source) {
+	lexer lex(source);
+	token_array tokens;
+	tokens.reserve(source.size() / 8);
+	token tok;
+	do {
+		tok = lex.next();
+		tokens.push_back(tok);
+	} while (tok.type != token_type::eof);
 	return tokens;
-}
\ No newline at end of file
+}
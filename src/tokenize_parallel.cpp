@@ -0,0 +1,90 @@
+#include "tokenize.hpp"
+#include "token_array.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cstring>
+
+
+/* no token spans a line, so a chunk that starts right after a '\n' and is
+ * lexed from its own offset produces exactly the tokens the sequential lexer
+ * produces for the same bytes. */
+token_array lexer::tokenize_parallel(std::string_view source, std::size_t min_chunk_size) {
+	thread_pool* pool = thread_pool::get_instance();
+	std::size_t chunk_count = std::min<std::size_t>(
+		source.size() / std::max<std::size_t>(min_chunk_size, 1),
+		pool->size() * 4);
+	if (chunk_count <= 1) {
+		return tokenize(source);
+	}
+
+	std::vector<std::string_view> chunks;
+	chunks.reserve(chunk_count + 1);
+	const std::size_t target = source.size() / chunk_count;
+	const char* begin = source.data();
+	const char* end = source.data() + source.size();
+	while (begin < end) {
+		const char* cut = end;
+		if (end - begin > static_cast<std::ptrdiff_t>(target)) {
+			const void* newline = std::memchr(begin + target, '\n', end - begin - target);
+			cut = newline ? static_cast<const char*>(newline) + 1 : end;
+		}
+		chunks.push_back(std::string_view(begin, cut - begin));
+		begin = cut;
+	}
+	if (chunks.size() <= 1) {
+		return tokenize(source);
+	}
+
+	/* each chunk keeps its trailing eof token, whose offset is where the
+	 * chunk's lexer stopped */
+	std::vector<token_array> chunk_tokens(chunks.size());
+	std::vector<std::future<void>> futures;
+	futures.reserve(chunks.size());
+	for (std::size_t index = 0; index < chunks.size(); ++index) {
+		futures.push_back(pool->submit([&chunks, &chunk_tokens, index]() {
+			std::string_view chunk = chunks[index];
+			lexer lex(chunk, static_cast<std::uint32_t>(chunk.data() - chunks.front().data()));
+			token_array& tokens = chunk_tokens[index];
+			tokens.reserve(chunk.size() / 8);
+			token tok;
+			do {
+				tok = lex.next();
+				tokens.push_back(tok);
+			} while (tok.type != token_type::eof);
+		}));
+	}
+	for (std::future<void>& future : futures) {
+		future.get();
+	}
+
+	/* output offset of every chunk. a '\0' inside a chunk ends the
+	 * sequential lexer there, so the chunks after it are dropped. */
+	std::vector<std::size_t> offset(chunks.size() + 1);
+	std::size_t used = 0;
+	while (used < chunks.size()) {
+		const token_array& chunk = chunk_tokens[used];
+		std::size_t chunk_end = chunks[used].data() + chunks[used].size() - chunks.front().data();
+		offset[used + 1] = offset[used] + chunk.size() - 1;
+		++used;
+		if (chunk.offset(chunk.size() - 1) != chunk_end) {
+			break;
+		}
+	}
+
+	token_array tokens;
+	tokens.resize(offset[used] + 1, chunk_tokens.front());
+	futures.clear();
+	for (std::size_t index = 0; index < used; ++index) {
+		futures.push_back(pool->submit([&chunk_tokens, &tokens, &offset, index]() {
+			const token_array& src = chunk_tokens[index];
+			tokens.assign(offset[index], src, src.size() - 1);
+		}));
+	}
+	for (std::future<void>& future : futures) {
+		future.get();
+	}
+	token_array eof;
+	eof.push_back(chunk_tokens[used - 1].back());
+	tokens.assign(offset[used], eof, 1);
+	return tokens;
+}
@@ -0,0 +1,234 @@
+#include "type_checker.hpp"
+
+
+std::vector<type_checker::error> type_checker::check(syntax_tree& tree, node_id root) {
+	std::vector<error> errors;
+	if (root == no_node) {
+		return errors;
+	}
+	context con {
+		.tree = tree,
+		.errors = errors,
+		.bindings = {},
+		.visible = {},
+		.scopes = {},
+		.next_slot = 0,
+		.function_depth = 0
+	};
+
+	/* post-order on an explicit stack, so every operand is resolved before
+	 * the node that uses it. blocks and functions open their scope on the
+	 * way down and close it on the way up. */
+	enum class step_kind : std::uint8_t {
+		enter,
+		enter_argument,
+		leave,
+		leave_argument,
+		target,
+	};
+	struct step {
+		node_id id;
+		step_kind kind;
+	};
+	std::vector<step> work { step { .id = root, .kind = step_kind::enter } };
+	auto visit = [&work](node_id id, step_kind kind = step_kind::enter) {
+		if (id != no_node) {
+			work.push_back(step { .id = id, .kind = kind });
+		}
+	};
+	while (!work.empty()) {
+		step current = work.back();
+		work.pop_back();
+		const ast_node& node = tree[current.id];
+		switch (current.kind) {
+		case step_kind::leave:
+		case step_kind::leave_argument:
+			resolve(con, current.id, current.kind == step_kind::leave_argument);
+			if (node.kind == ast_kind::block || node.kind == ast_kind::function) {
+				leave_scope(con);
+			}
+			continue;
+		case step_kind::target:
+			resolve_variable(con, current.id, true);
+			continue;
+		case step_kind::enter_argument:
+			work.push_back(step { .id = current.id, .kind = step_kind::leave_argument });
+			visit(node.lhs);
+			continue;
+		case step_kind::enter:
+			break;
+		}
+
+		work.push_back(step { .id = current.id, .kind = step_kind::leave });
+		std::span<const node_id> children = tree.list(current.id);
+		switch (node.kind) {
+		case ast_kind::function: {
+			/* arguments first, then the errors after them, then the body */
+			enter_scope(con, true);
+			visit(node.lhs);
+			for (auto itr = children.rbegin(); itr != children.rend(); ++itr) {
+				bool is_argument = static_cast<std::size_t>(children.rend() - itr) <= node.list_split;
+				visit(*itr, is_argument && tree[*itr].kind == ast_kind::var_define ?
+					step_kind::enter_argument : step_kind::enter);
+			}
+			break;
+		}
+		case ast_kind::block:
+			enter_scope(con, false);
+			for (auto itr = children.rbegin(); itr != children.rend(); ++itr) {
+				visit(*itr);
+			}
+			break;
+		case ast_kind::bin_op:
+			if (node.tok == token_type::equal && node.lhs != no_node &&
+				tree[node.lhs].kind == ast_kind::value) {
+				/* the target is bound after the value it receives */
+				visit(node.lhs, step_kind::target);
+				visit(node.rhs);
+				break;
+			}
+			visit(node.rhs);
+			visit(node.lhs);
+			break;
+		default:
+			visit(node.lhs);
+			break;
+		}
+	}
+	return errors;
+}
+
+void type_checker::enter_scope(context& con, bool is_function) {
+	con.scopes.push_back(scope {
+		.binding_count = con.bindings.size(),
+		.next_slot = con.next_slot,
+		.is_function = is_function
+	});
+	if (is_function) {
+		/* a function numbers its slots from the start of its own frame */
+		con.next_slot = 0;
+		++con.function_depth;
+	}
+}
+void type_checker::leave_scope(context& con) {
+	const scope& closing = con.scopes.back();
+	while (con.bindings.size() > closing.binding_count) {
+		const binding& last = con.bindings.back();
+		*con.visible.find(last.name) = last.shadowed;
+		con.bindings.pop_back();
+	}
+	/* slots of a closed block are reused by the statements after it */
+	con.next_slot = closing.next_slot;
+	if (closing.is_function) {
+		--con.function_depth;
+	}
+	con.scopes.pop_back();
+}
+void type_checker::declare(context& con, node_id id, bool initialized) {
+	symbol name = con.tree[id].sym;
+	std::uint32_t* visible = con.visible.find(name);
+	con.bindings.push_back(binding {
+		.name = name,
+		.slot = con.next_slot,
+		.function_depth = con.function_depth,
+		.initialized = initialized,
+		.shadowed = visible ? *visible : 0
+	});
+	if (visible) {
+		*visible = static_cast<std::uint32_t>(con.bindings.size());
+	} else {
+		con.visible.insert(name, static_cast<std::uint32_t>(con.bindings.size()));
+	}
+	con.tree.set_slot(id, con.next_slot++);
+}
+type_checker::binding* type_checker::lookup(context& con, symbol name) {
+	const std::uint32_t* visible = con.visible.find(name);
+	if (!visible || !*visible) {
+		return nullptr;
+	}
+	binding& found = con.bindings[*visible - 1];
+	return found.function_depth == con.function_depth ? &found : nullptr;
+}
+
+void type_checker::resolve(context& con, node_id id, bool is_argument) {
+	syntax_tree& tree = con.tree;
+	ast_node& node = tree[id];
+	switch (node.kind) {
+	case ast_kind::value:
+		/* identifiers got the variable's type from the parser */
+		if (node.tok == token_type::number) {
+			node.type = object_type::integer;
+		} else if (node.tok == token_type::floating) {
+			node.type = object_type::floating;
+		} else if (node.tok == token_type::identifier) {
+			resolve_variable(con, id, false);
+		}
+		break;
+	case ast_kind::parenthess:
+	case ast_kind::expr:
+	case ast_kind::_return:
+		node.type = tree.type(node.lhs);
+		break;
+	case ast_kind::bin_op: {
+		object_type lhs_type = tree.type(node.lhs);
+		object_type rhs_type = tree.type(node.rhs);
+		node.type = evaluate_type(lhs_type, rhs_type);
+		if (node.type == object_type::none && lhs_type != object_type::none && rhs_type != object_type::none) {
+			if (node.tok == token_type::equal) {
+				report(con, id, "failed to cast " + to_string(rhs_type) + " -> " + to_string(lhs_type));
+			} else {
+				report(con, id, "no common type for `" + std::string(spelling(node.tok)) + "`: " +
+					to_string(lhs_type) + ", " + to_string(rhs_type));
+			}
+		}
+		convert(tree, node.lhs, node.type);
+		convert(tree, node.rhs, node.type);
+		break;
+	}
+	case ast_kind::var_define: {
+		if (node.var_type == token_type::_int) {
+			node.type = object_type::integer;
+		} else if (node.var_type == token_type::_float) {
+			node.type = object_type::floating;
+		}
+		object_type value_type = tree.type(node.lhs);
+		if (value_type != object_type::none && node.type != object_type::none &&
+			evaluate_type(node.type, value_type) == object_type::none) {
+			report(con, id, "failed to cast " + to_string(value_type) + " -> " + to_string(node.type));
+		}
+		convert(tree, node.lhs, node.type);
+		/* an argument is initialized by the caller */
+		declare(con, id, is_argument || node.lhs != no_node);
+		break;
+	}
+	default:
+		break;
+	}
+}
+void type_checker::report(context& con, node_id id, std::string message) {
+	con.errors.push_back(error { .node = id, .offset = con.tree[id].offset, .message = std::move(message) });
+}
+void type_checker::resolve_variable(context& con, node_id id, bool is_target) {
+	ast_node& node = con.tree[id];
+	binding* var = lookup(con, node.sym);
+	if (!var) {
+		con.tree.set_slot(id, no_slot);
+		/* the parser has already reported names it never saw */
+		if (node.type != object_type::none) {
+			report(con, id, std::string(node.str) + " is not defined in this scope");
+		}
+		return;
+	}
+	con.tree.set_slot(id, var->slot);
+	if (is_target) {
+		var->initialized = true;
+	} else if (!var->initialized) {
+		report(con, id, std::string(node.str) + " is used before it is initialized");
+	}
+}
+void type_checker::convert(syntax_tree& tree, node_id id, object_type to) {
+	if (id == no_node || to == object_type::none || tree[id].type == to) {
+		return;
+	}
+	tree[id].cast = to;
+}
@@ -3,6 +3,41 @@
 #include <utility>
 
 
+/* length of the sequence led by `lead`, or -1 for a continuation byte or
+ * a byte that never starts a sequence */
+static int sequence_size(unsigned char lead) {
+	if (lead < 0b10000000) { return 1; }
+	if (lead < 0b11000000) { return -1; }
+	if (lead < 0b11100000) { return 2; }
+	if (lead < 0b11110000) { return 3; }
+	if (lead < 0b11111000) { return 4; }
+	return -1;
+}
+/* byte-wise order of two sequences, which is also their code point order.
+ * invalid characters are unordered, so every comparison with one fails. */
+static bool is_comparable(int lhs_size, int rhs_size) {
+	return lhs_size != -1 && rhs_size != -1;
+}
+static int compare(const char* lhs, int lhs_size, const char* rhs, int rhs_size) {
+	int size = lhs_size < rhs_size ? lhs_size : rhs_size;
+	int result = std::memcmp(lhs, rhs, size);
+	if (result) {
+		return result;
+	}
+	return lhs_size - rhs_size;
+}
+static char32_t decode(const char* ptr, int size) {
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(ptr);
+	switch (size) {
+	case 1: return p[0];
+	case 2: return (char32_t(p[0] & 0x1f) << 6) | (p[1] & 0x3f);
+	case 3: return (char32_t(p[0] & 0x0f) << 12) | (char32_t(p[1] & 0x3f) << 6) | (p[2] & 0x3f);
+	case 4: return (char32_t(p[0] & 0x07) << 18) | (char32_t(p[1] & 0x3f) << 12) |
+		(char32_t(p[2] & 0x3f) << 6) | (p[3] & 0x3f);
+	}
+	return 0;
+}
+
 /* ==========================================
  *                  utf8_char                
  * ==========================================
@@ -13,14 +48,9 @@ utf8_char::utf8_char() :
 {}
 
 utf8_char::utf8_char(const char* str) :
-	_data()
+	_data(),
+	_csize(sequence_size(static_cast<unsigned char>(*str)))
 {
-	_csize = -1;
-	if (*str < 128) { _csize = 1; }
-	else if (*str >= 0b11110000) { _csize = 4; }
-	else if (*str >= 0b11100000) { _csize = 3; }
-	else if (*str >= 0b11000000) { _csize = 2; }
-
 	int index = 0;
 	char* p = const_cast<char*>(_data);
 	for (;*str && index < _csize; ++index) {
@@ -29,7 +59,7 @@ utf8_char::utf8_char(const char* str) :
 	if (index != _csize) {
 		_csize = -1;
 	}
-	for (;index < 5 - _csize; ++index) {
+	for (; index < 5; ++index) {
 		*p++ = 0;
 	}
 }
@@ -40,91 +70,54 @@ utf8_char::utf8_char(const utf8_char& rhs) :
 	_data(),
 	_csize(rhs._csize)
 {
-	char* p = const_cast<char*>(_data);
-	char* pp = const_cast<char*>(rhs._data);
-	for (int index = 0; index < 5; ++index) {
-		*p++ = *pp++;
-	}
+	std::memcpy(const_cast<char*>(_data), rhs._data, sizeof(_data));
 }
 utf8_char& utf8_char::operator=(const utf8_char& rhs) {
 	_csize = rhs._csize;
-	char* p = const_cast<char*>(_data);
-	char* pp = const_cast<char*>(rhs._data);
-	for (int index = 0; index < 5; ++index) {
-		*p++ = *pp++;
-	}
+	std::memcpy(const_cast<char*>(_data), rhs._data, sizeof(_data));
 	return *this;
 }
 
 int utf8_char::char_size() const { return _csize; }
 const char* utf8_char::data() const { return _data; }
+char32_t utf8_char::code_point() const { return decode(_data, _csize); }
 
 bool utf8_char::operator==(const utf8_char& rhs) const {
-	if (_csize != -1 || rhs.char_size()) {
-		return false;
-	}
-	return _csize == rhs.char_size() &&
-			_data[0] == rhs._data[0] &&
-			_data[1] == rhs._data[1] &&
-			_data[2] == rhs._data[2] &&
-			_data[3] == rhs._data[3] &&
-			_data[4] == rhs._data[4];
+	return is_comparable(_csize, rhs._csize) && compare(_data, _csize, rhs._data, rhs._csize) == 0;
 }
 bool utf8_char::operator!=(const utf8_char& rhs) const {
-	return !(*this == rhs);
+	return is_comparable(_csize, rhs._csize) && compare(_data, _csize, rhs._data, rhs._csize) != 0;
 }
 bool utf8_char::operator>(const utf8_char& rhs) const {
-	if (_csize != -1 || rhs.char_size()) {
-		return false;
-	}
-	if (_csize == 4) { return _data[4] > rhs._data[4]; }
-	else if (_csize == 3) { return _data[3] > rhs._data[3]; }
-	else if (_csize == 2) { return _data[2] > rhs._data[2]; }
-	else if (_csize == 1) { return _data[1] > rhs._data[1]; }
-	return false;
+	return is_comparable(_csize, rhs._csize) && compare(_data, _csize, rhs._data, rhs._csize) > 0;
 }
 bool utf8_char::operator<(const utf8_char& rhs) const {
-	return !(*this > rhs) && !(*this == rhs);
+	return is_comparable(_csize, rhs._csize) && compare(_data, _csize, rhs._data, rhs._csize) < 0;
 }
 bool utf8_char::operator>=(const utf8_char& rhs) const {
-	return (*this > rhs) || (*this == rhs);
+	return is_comparable(_csize, rhs._csize) && compare(_data, _csize, rhs._data, rhs._csize) >= 0;
 }
 bool utf8_char::operator<=(const utf8_char& rhs) const {
-	return (*this < rhs) || (*this == rhs);
+	return is_comparable(_csize, rhs._csize) && compare(_data, _csize, rhs._data, rhs._csize) <= 0;
 }
 
 bool utf8_char::operator==(const utf8_char_view rhs) const {
-	if (_csize != -1 || rhs.char_size()) {
-		return false;
-	}
-	return _csize == rhs.char_size() &&
-			_data[0] == rhs._ptr[0] &&
-			_data[1] == rhs._ptr[1] &&
-			_data[2] == rhs._ptr[2] &&
-			_data[3] == rhs._ptr[3] &&
-			_data[4] == rhs._ptr[4];
+	return is_comparable(_csize, rhs._csize) && compare(_data, _csize, rhs._ptr, rhs._csize) == 0;
 }
 bool utf8_char::operator!=(const utf8_char_view rhs) const {
-	return !(*this == rhs);
+	return is_comparable(_csize, rhs._csize) && compare(_data, _csize, rhs._ptr, rhs._csize) != 0;
 }
 bool utf8_char::operator>(const utf8_char_view rhs) const {
-	if (_csize != -1 || rhs.char_size()) {
-		return false;
-	}
-	if (_csize == 4) { return _data[4] > rhs._ptr[4]; }
-	else if (_csize == 3) { return _data[3] > rhs._ptr[3]; }
-	else if (_csize == 2) { return _data[2] > rhs._ptr[2]; }
-	else if (_csize == 1) { return _data[1] > rhs._ptr[1]; }
-	return false;
+	return is_comparable(_csize, rhs._csize) && compare(_data, _csize, rhs._ptr, rhs._csize) > 0;
 }
 bool utf8_char::operator<(const utf8_char_view rhs) const {
-	return !(*this > rhs) && !(*this == rhs);
+	return is_comparable(_csize, rhs._csize) && compare(_data, _csize, rhs._ptr, rhs._csize) < 0;
 }
 bool utf8_char::operator>=(const utf8_char_view rhs) const {
-	return (*this > rhs) || (*this == rhs);
+	return is_comparable(_csize, rhs._csize) && compare(_data, _csize, rhs._ptr, rhs._csize) >= 0;
 }
 bool utf8_char::operator<=(const utf8_char_view rhs) const {
-	return (*this < rhs) || (*this == rhs);
+	return is_comparable(_csize, rhs._csize) && compare(_data, _csize, rhs._ptr, rhs._csize) <= 0;
 }
 
 /* ==========================================
@@ -137,14 +130,9 @@ utf8_char_view::utf8_char_view() :
 	_csize(-1)
 {}
 utf8_char_view::utf8_char_view(const char* ptr) :
-	_ptr(ptr)
-{
-	_csize = -1;
-	if (*ptr < 128) { _csize = 1; }
-	else if (*ptr >= 0b11110000) { _csize = 4; }
-	else if (*ptr >= 0b11100000) { _csize = 3; }
-	else if (*ptr >= 0b11000000) { _csize = 2; }
-}
+	_ptr(ptr),
+	_csize(sequence_size(static_cast<unsigned char>(*ptr)))
+{}
 utf8_char_view::~utf8_char_view() {}
 
 utf8_char_view::operator utf8_char() const {
@@ -157,39 +145,27 @@ int utf8_char_view::char_size() const {
 const char* utf8_char_view::data() const {
 	return _ptr;
 }
+char32_t utf8_char_view::code_point() const {
+	return decode(_ptr, _csize);
+}
 
 bool utf8_char_view::operator==(const utf8_char_view rhs) const {
-	if (_csize != -1 || rhs.char_size()) {
-		return false;
-	}
-	return _csize == rhs.char_size() &&
-		_ptr[0] == rhs._ptr[0] &&
-		_ptr[1] == rhs._ptr[1] &&
-		_ptr[2] == rhs._ptr[2] &&
-		_ptr[3] == rhs._ptr[3] &&
-		_ptr[4] == rhs._ptr[4];
+	return is_comparable(_csize, rhs._csize) && compare(_ptr, _csize, rhs._ptr, rhs._csize) == 0;
 }
 bool utf8_char_view::operator!=(const utf8_char_view rhs) const {
-	return !(*this == rhs);
+	return is_comparable(_csize, rhs._csize) && compare(_ptr, _csize, rhs._ptr, rhs._csize) != 0;
 }
 bool utf8_char_view::operator>(const utf8_char_view rhs) const {
-	if (_csize != -1 || rhs.char_size()) {
-		return false;
-	}
-	if (_csize == 4) { return _ptr[4] > rhs._ptr[4]; }
-	else if (_csize == 3) { return _ptr[3] > rhs._ptr[3]; }
-	else if (_csize == 2) { return _ptr[2] > rhs._ptr[2]; }
-	else if (_csize == 1) { return _ptr[1] > rhs._ptr[1]; }
-	return false;
+	return is_comparable(_csize, rhs._csize) && compare(_ptr, _csize, rhs._ptr, rhs._csize) > 0;
 }
 bool utf8_char_view::operator<(const utf8_char_view rhs) const {
-	return !(*this > rhs) && !(*this == rhs);
+	return is_comparable(_csize, rhs._csize) && compare(_ptr, _csize, rhs._ptr, rhs._csize) < 0;
 }
 bool utf8_char_view::operator>=(const utf8_char_view rhs) const {
-	return (*this > rhs) || *this == rhs;
+	return is_comparable(_csize, rhs._csize) && compare(_ptr, _csize, rhs._ptr, rhs._csize) >= 0;
 }
 bool utf8_char_view::operator<=(const utf8_char_view rhs) const {
-	return (*this < rhs) || *this == rhs;
+	return is_comparable(_csize, rhs._csize) && compare(_ptr, _csize, rhs._ptr, rhs._csize) <= 0;
 }
 
 
@@ -206,7 +182,7 @@ std::string operator+(const std::string& lhs, const utf8_char& rhs) {
 	for (int index = 0; index < rhs.char_size(); ++index) {
 		str += rhs.data()[index];
 	}
-	return lhs;
+	return str;
 }
 std::string operator+(const utf8_char& lhs, const std::string& rhs) {
 	std::string str;
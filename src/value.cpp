@@ -0,0 +1,20 @@
+#include "value.hpp"
+
+
+value value::from_object(const OBJECT& object) {
+	if (const int* number = std::get_if<int>(&object)) {
+		return of(static_cast<std::int32_t>(*number));
+	}
+	if (const double* number = std::get_if<double>(&object)) {
+		return of(*number);
+	}
+	return none();
+}
+OBJECT value::to_object() const {
+	switch (type) {
+	case tag::integer: return OBJECT(static_cast<int>(integer));
+	case tag::floating: return OBJECT(floating);
+	default: break;
+	}
+	return invalid_type();
+}
@@ -0,0 +1,337 @@
+#include "verifier.hpp"
+
+
+namespace {
+#define VERIFIER_COUNT(name, layout, effect) + 1
+	constexpr std::size_t opcode_count = 0 BYTECODE_OPCODES(VERIFIER_COUNT);
+#define VERIFIER_REGISTER_COUNT(name) + 1
+	constexpr std::size_t register_opcode_count = 0 REGISTER_OPCODES(VERIFIER_REGISTER_COUNT);
+#undef VERIFIER_REGISTER_COUNT
+#undef VERIFIER_COUNT
+
+	std::string type_name(value::tag type) {
+		switch (type) {
+		case value::tag::none: return "nothing";
+		case value::tag::integer: return "int";
+		case value::tag::floating: return "float";
+		case value::tag::handle: return "handle";
+		}
+		return "";
+	}
+}
+
+std::optional<verifier::error> verifier::verify(bytecode& program, std::span<const argument> arguments) {
+	const std::uint8_t* const code = program.data();
+	std::vector<slot_state> frame(program.frame_size());
+	if (arguments.size() > frame.size()) {
+		return error { 0, std::to_string(arguments.size()) + " arguments for a frame of " + std::to_string(frame.size()) };
+	}
+	for (std::size_t index = 0; index < arguments.size(); ++index) {
+		frame[index] = slot_state { .type = arguments[index].type, .is_mutable = arguments[index].is_mutable, .is_init = true };
+	}
+	std::vector<value::tag> stack;
+	stack.reserve(program.max_stack());
+
+	/* each returns none, or false, and leaves the reason in `problem` when
+	 * the instruction would fail */
+	std::string problem;
+	auto pop = [&stack, &problem](value::tag expected) {
+		if (stack.empty()) {
+			problem = "the stack is empty";
+			return value::tag::none;
+		}
+		value::tag type = stack.back();
+		if (expected != value::tag::none && type != expected) {
+			problem = "expects " + type_name(expected) + " but the stack has " + type_name(type);
+			return value::tag::none;
+		}
+		stack.pop_back();
+		return type;
+	};
+	auto push = [&stack, &problem, &program](value::tag type) {
+		if (stack.size() == program.max_stack()) {
+			problem = "the stack grows past " + std::to_string(program.max_stack());
+			return false;
+		}
+		stack.push_back(type);
+		return true;
+	};
+	auto slot = [&frame, &problem](std::uint32_t index) -> slot_state* {
+		if (index >= frame.size()) {
+			problem = "$" + std::to_string(index) + " is outside the frame of " + std::to_string(frame.size());
+			return nullptr;
+		}
+		return &frame[index];
+	};
+	auto read = [&slot, &problem](std::uint32_t index, value::tag expected) {
+		slot_state* state = slot(index);
+		if (!state) {
+			return value::tag::none;
+		}
+		if (!state->is_init) {
+			problem = "$" + std::to_string(index) + " is read before it is written";
+			return value::tag::none;
+		}
+		if (state->type == value::tag::none) {
+			/* an argument given without a type */
+			problem = "$" + std::to_string(index) + " has no type";
+			return value::tag::none;
+		}
+		if (expected != value::tag::none && state->type != expected) {
+			problem = "expects " + type_name(expected) + " but $" + std::to_string(index) + " is " + type_name(state->type);
+			return value::tag::none;
+		}
+		return state->type;
+	};
+	/* `store` is an assignment, the others declare the slot */
+	auto write = [&slot, &pop, &problem](std::uint32_t index, bool is_assignment) {
+		slot_state* state = slot(index);
+		if (!state) {
+			return false;
+		}
+		if (state->type == value::tag::none) {
+			problem = "$" + std::to_string(index) + " is written before it is allocated";
+			return false;
+		}
+		if (is_assignment && !state->is_mutable) {
+			problem = "$" + std::to_string(index) + " is constant";
+			return false;
+		}
+		if (!is_assignment && state->is_init) {
+			problem = "$" + std::to_string(index) + " is initialized twice";
+			return false;
+		}
+		if (pop(state->type) == value::tag::none) {
+			return false;
+		}
+		state->is_init = true;
+		return true;
+	};
+	auto declare = [&slot](std::uint32_t index, value::tag type, bool is_mutable, bool is_init) {
+		slot_state* state = slot(index);
+		if (state) {
+			*state = slot_state { .type = type, .is_mutable = is_mutable, .is_init = is_init };
+		}
+		return state != nullptr;
+	};
+	auto binary = [&pop, &push](value::tag type) {
+		return pop(type) != value::tag::none && pop(type) != value::tag::none && push(type);
+	};
+
+	for (std::size_t offset = 0; offset < program.size();) {
+		if (code[offset] >= opcode_count) {
+			return error { offset, "unknown opcode " + std::to_string(code[offset]) };
+		}
+		opcode op = static_cast<opcode>(code[offset]);
+		if (offset + 1 + bytecode::operand_size(op) > program.size()) {
+			return error { offset, std::string(bytecode::name(op)) + " runs past the end of the code" };
+		}
+		const std::uint8_t* at = code + offset + 1;
+		std::uint32_t first = 0;
+		std::uint32_t second = 0;
+		if (bytecode::layout(op) == operand_layout::slot || bytecode::layout(op) == operand_layout::slot_integer ||
+			bytecode::layout(op) == operand_layout::slot_floating || bytecode::layout(op) == operand_layout::slot_slot)
+		{
+			first = bytecode::read<std::uint32_t>(at);
+		}
+		if (bytecode::layout(op) == operand_layout::slot_slot) {
+			second = bytecode::read<std::uint32_t>(at + sizeof(std::uint32_t));
+		}
+
+		bool sound = true;
+		switch (op) {
+		case opcode::push_int: sound = push(value::tag::integer); break;
+		case opcode::push_float: sound = push(value::tag::floating); break;
+		case opcode::push_var: {
+			value::tag type = read(first, value::tag::none);
+			sound = type != value::tag::none && push(type);
+			break;
+		}
+		case opcode::pop: sound = pop(value::tag::none) != value::tag::none; break;
+		case opcode::alloc_int: sound = declare(first, value::tag::integer, true, false); break;
+		case opcode::alloc_float: sound = declare(first, value::tag::floating, true, false); break;
+		case opcode::alloc_const_int: sound = declare(first, value::tag::integer, false, false); break;
+		case opcode::alloc_const_float: sound = declare(first, value::tag::floating, false, false); break;
+		case opcode::init: sound = write(first, false); break;
+		case opcode::store: sound = write(first, true); break;
+		case opcode::store_int: sound = declare(first, value::tag::integer, true, true); break;
+		case opcode::store_float: sound = declare(first, value::tag::floating, true, true); break;
+		case opcode::store_const_int: sound = declare(first, value::tag::integer, false, true); break;
+		case opcode::store_const_float: sound = declare(first, value::tag::floating, false, true); break;
+		case opcode::add:
+		case opcode::sub:
+		case opcode::mul:
+		case opcode::div:
+			sound = binary(value::tag::integer);
+			break;
+		case opcode::addf:
+		case opcode::subf:
+		case opcode::mulf:
+		case opcode::divf:
+			sound = binary(value::tag::floating);
+			break;
+		case opcode::cast_int:
+			sound = pop(value::tag::none) != value::tag::none && push(value::tag::integer);
+			break;
+		case opcode::cast_float:
+			sound = pop(value::tag::none) != value::tag::none && push(value::tag::floating);
+			break;
+		case opcode::push_var_cast_int:
+			sound = read(first, value::tag::none) != value::tag::none && push(value::tag::integer);
+			break;
+		case opcode::push_var_cast_float:
+			sound = read(first, value::tag::none) != value::tag::none && push(value::tag::floating);
+			break;
+		case opcode::add_var_imm:
+		case opcode::sub_var_imm:
+		case opcode::mul_var_imm:
+			sound = read(first, value::tag::integer) != value::tag::none && push(value::tag::integer);
+			break;
+		case opcode::div_var_imm: {
+			/* the interpreter does not check an immediate divisor in verified code */
+			std::int32_t divisor = bytecode::read<std::int32_t>(at + sizeof(std::uint32_t));
+			if (divisor == 0 || divisor == -1) {
+				sound = false;
+				problem = "divides by " + std::to_string(divisor);
+				break;
+			}
+			sound = read(first, value::tag::integer) != value::tag::none && push(value::tag::integer);
+			break;
+		}
+		case opcode::addf_var_imm:
+		case opcode::subf_var_imm:
+		case opcode::mulf_var_imm:
+		case opcode::divf_var_imm:
+			sound = read(first, value::tag::floating) != value::tag::none && push(value::tag::floating);
+			break;
+		case opcode::add_var_var:
+		case opcode::sub_var_var:
+		case opcode::mul_var_var:
+		case opcode::div_var_var:
+			sound = read(first, value::tag::integer) != value::tag::none &&
+				read(second, value::tag::integer) != value::tag::none && push(value::tag::integer);
+			break;
+		case opcode::addf_var_var:
+		case opcode::subf_var_var:
+		case opcode::mulf_var_var:
+		case opcode::divf_var_var:
+			sound = read(first, value::tag::floating) != value::tag::none &&
+				read(second, value::tag::floating) != value::tag::none && push(value::tag::floating);
+			break;
+		case opcode::ret:
+		case opcode::abort: {
+			/* nothing after the first of them runs */
+			program._is_verified = true;
+			program._argument_types.clear();
+			for (const argument& item : arguments) {
+				program._argument_types.push_back(item.type);
+			}
+			return std::nullopt;
+		}
+		default:
+			/* only the interpreter writes the quickened forms, into its copy */
+			sound = false;
+			problem = "compiled code has no " + std::string(bytecode::name(op));
+			break;
+		}
+		if (!sound) {
+			return error { offset, std::string(bytecode::name(op)) + ": " + problem };
+		}
+		offset += 1 + bytecode::operand_size(op);
+	}
+	return error { program.size(), "the code runs off its end" };
+}
+
+std::optional<verifier::error> verifier::verify(const register_code& code) {
+	const std::vector<value>& constants = code.constants();
+	if (code.constant_base() + constants.size() > code.register_count()) {
+		return error { 0, std::to_string(constants.size()) + " constants from r" + std::to_string(code.constant_base()) +
+			" for " + std::to_string(code.register_count()) + " registers" };
+	}
+	/* none until the register is written */
+	std::vector<value::tag> registers(code.register_count(), value::tag::none);
+	for (std::size_t index = 0; index < constants.size(); ++index) {
+		std::uint32_t target = code.constant_base() + static_cast<std::uint32_t>(index);
+		if (constants[index].type == value::tag::none) {
+			return error { 0, "r" + std::to_string(target) + " has no type" };
+		}
+		registers[target] = constants[index].type;
+	}
+
+	/* as for bytecode, each leaves the reason in `problem` */
+	std::string problem;
+	auto outside = [&registers, &problem](std::uint32_t index) {
+		if (index < registers.size()) {
+			return false;
+		}
+		problem = "r" + std::to_string(index) + " is outside the " + std::to_string(registers.size()) + " registers";
+		return true;
+	};
+	auto read = [&registers, &problem, &outside](std::uint32_t index, value::tag expected) {
+		if (outside(index)) {
+			return value::tag::none;
+		}
+		value::tag type = registers[index];
+		if (type == value::tag::none) {
+			problem = "r" + std::to_string(index) + " is read before it is written";
+			return value::tag::none;
+		}
+		if (expected != value::tag::none && type != expected) {
+			problem = "expects " + type_name(expected) + " but r" + std::to_string(index) + " is " + type_name(type);
+			return value::tag::none;
+		}
+		return type;
+	};
+	auto write = [&registers, &outside](std::uint32_t index, value::tag type) {
+		if (outside(index)) {
+			return false;
+		}
+		registers[index] = type;
+		return true;
+	};
+	/* both operands are read before the result is written */
+	auto binary = [&read, &write](const register_instruction& inst, value::tag type) {
+		return read(inst.b, type) != value::tag::none && read(inst.c, type) != value::tag::none && write(inst.a, type);
+	};
+
+	const std::vector<register_instruction>& instructions = code.instructions();
+	for (std::size_t offset = 0; offset < instructions.size(); ++offset) {
+		const register_instruction& inst = instructions[offset];
+		if (static_cast<std::size_t>(inst.op) >= register_opcode_count) {
+			return error { offset, "unknown opcode " + std::to_string(static_cast<std::size_t>(inst.op)) };
+		}
+		bool sound = true;
+		switch (inst.op) {
+		case register_opcode::add:
+		case register_opcode::sub:
+		case register_opcode::mul:
+		case register_opcode::div:
+			sound = binary(inst, value::tag::integer);
+			break;
+		case register_opcode::addf:
+		case register_opcode::subf:
+		case register_opcode::mulf:
+		case register_opcode::divf:
+			sound = binary(inst, value::tag::floating);
+			break;
+		case register_opcode::cast_int:
+			sound = read(inst.b, value::tag::none) != value::tag::none && write(inst.a, value::tag::integer);
+			break;
+		case register_opcode::cast_float:
+			sound = read(inst.b, value::tag::none) != value::tag::none && write(inst.a, value::tag::floating);
+			break;
+		case register_opcode::ret:
+			if (read(inst.a, value::tag::none) != value::tag::none) {
+				return std::nullopt;
+			}
+			sound = false;
+			break;
+		case register_opcode::abort:
+			return std::nullopt;
+		}
+		if (!sound) {
+			return error { offset, std::string(register_code::name(inst.op)) + ": " + problem };
+		}
+	}
+	return error { instructions.size(), "the code runs off its end" };
+}